@@ -2,33 +2,16 @@
 
 void Console::run()
 {
-    
-    // initialize db
-    initialize_database();
-    
-    // command loop
-    std::string cmd;
     print_welcome();
-    
-    // start http server in background
-    start_http_server();
-    
-    // resume contracts states
-    std::vector<Event> events = list_all_events(false);
-    
-    for (auto &e : events)
-    {
-        state[e.id] = std::make_unique<LMSRContract>(e.id, e.name, e.risk_cap, e.q_yes, e.q_no, e.event_funds);
-    }
-    if (state.size() > 0)
-    {
-        warning_msg((std::string("[Resumed ") + to_string_safe(state.size()) + " ongoing contracts states from database.]\n").c_str());
-    }
-    
+
+    if (!start())
+        return;
+
     // usage breif
     std::cout << "Type 'help' for list of commands.\n";
-    
 
+    // command loop
+    std::string cmd;
     while (true)
     {
         std::cout << "> ";
@@ -37,6 +20,122 @@ void Console::run()
         if (!dispatch(cmd))
             break;
     }
+
+    stop();
+}
+
+bool Console::start()
+{
+    // engine log writer (order fills, rejections, persistence errors)
+    if (!logger_start(options.log))
+    {
+        error_msg("Cannot open log file '" + options.log.file + "'.");
+        return false;
+    }
+
+    // initialize db
+    if (initialize_database() != 0)
+    {
+        stop();
+        return false;
+    }
+
+    // start the order journal (writer thread for group/async durability)
+    if (!order_journal().start(options.journal))
+    {
+        error_msg("Cannot open the order log in '" + options.journal.binlog.directory + "'.");
+        stop();
+        return false;
+    }
+    if (options.journal.durability == Durability::NONE)
+        warning_msg("[Durability 'none': orders are NOT saved to the database.]\n");
+    else if (options.journal.storage == StorageEngine::BINLOG)
+        warning_msg("[Storage 'binlog': orders are logged to '" + options.journal.binlog.directory +
+                    "' and copied to the database in the background.]\n");
+
+    order_sequencer().start(options.execution);
+
+    if (options.trace_sample_every > 0)
+        trace_start(options.trace_sample_every);
+
+    quote_stream().start(options.stream);
+
+    // start http server in background; market routes answer 503 until the
+    // markets below are loaded
+    start_http_server();
+
+    // resume contracts states (numeric columns only, in parallel)
+    if (!hydrator.start(options.hydration))
+    {
+        error_msg("Failed to load the open markets from the database.");
+        stop();
+        return false;
+    }
+
+    // GET /events metadata is read on first use (lazy mode: after loading
+    // every cold market, since the listing shows their state)
+    catalog.load_on_first_use([this]() {
+        std::vector<EventCatalog::Listing> listings;
+        if (!hydrator.hydrate_all())
+            log_error("Failed to load every open market; GET /events lists the loaded ones.");
+        for (EventListing &e : list_event_listings())
+            if (const LMSRContract *contract = markets.find(e.id))
+                listings.push_back(EventCatalog::Listing{std::move(e), contract});
+        return listings;
+    });
+
+    if (options.hydration.mode == HydrationMode::LAZY)
+    {
+        if (hydrator.pending() > 0)
+            warning_msg("[" + to_string_safe(hydrator.pending()) + " ongoing contracts will be resumed on first access.]\n");
+    }
+    else
+    {
+        if (markets.size() > 0)
+            warning_msg("[Resumed " + to_string_safe(markets.size()) + " ongoing contracts states from database.]\n");
+        // a large catalog's first body takes a while; build it off the request path
+        warm_thread = std::thread([this]() { catalog.body(); });
+    }
+    ready.store(true, std::memory_order_release);
+
+    // binary order entry listens only once the markets are loaded
+    if (options.wire_port > 0)
+    {
+        if (!gateway.start(options.http_host, options.wire_port, options.wire_connections))
+        {
+            error_msg("Cannot listen for binary order entry on port " + to_string_safe(options.wire_port) + ".");
+            stop();
+            return false;
+        }
+        warning_msg("[Binary order entry on " + options.http_host + ":" + to_string_safe(options.wire_port) + ".]\n");
+    }
+
+    // finish settlements interrupted by the last shutdown or crash
+    settler().start(options.settlement);
+    std::vector<int> settling = list_settling_events();
+    for (int id : settling)
+        settler().resume(id);
+    if (!settling.empty())
+        warning_msg("[Resuming " + to_string_safe(settling.size()) + " unfinished settlement(s).]\n");
+    return true;
+}
+
+void Console::stop()
+{
+    // end the quote streams (their handlers hold HTTP workers), stop taking
+    // requests on either protocol, then flush fills still waiting for a group/async commit
+    quote_stream().stop();
+    gateway.stop();
+    http_server.stop();
+    if (http_thread.joinable())
+        http_thread.join();
+    if (warm_thread.joinable())
+        warm_thread.join();
+    ready.store(false, std::memory_order_release);
+    order_sequencer().stop();
+    settler().stop();
+    order_journal().stop();
+    logger_stop();
 }
 
 void Console::print_welcome()
@@ -65,6 +164,8 @@ bool Console::dispatch(const std::string &cmd)
         return add_event();
     if (lowerCmd == "list")
         return list_events();
+    if (lowerCmd == "settlements")
+        return list_settlements();
 
     std::istringstream iss(lowerCmd);
     std::string command, arg;
@@ -167,6 +268,15 @@ bool Console::dispatch(const std::string &cmd)
         return metrics(std::stoi(arg));
     }
 
+    if (command == "trace")
+    {
+        // re-split the original text: a dump path keeps its case
+        std::istringstream raw(cmd);
+        std::string word, value;
+        raw >> word >> word >> value;
+        return trace(arg, value);
+    }
+
     std::cout << "Unknown command.\n";
     return true;
 }
@@ -181,7 +291,9 @@ bool Console::help()
               << "  quote <event id/tag> — get quote for event\n"
               << "  orders <event id/tag> — get orders for event\n"
               << "  resolve <event id/tag> — resolve event outcome\n"
+              << "  settlements — show settlement progress\n"
               << "  metrics <event id>  — show event metrics\n"
+              << "  trace on [N] | off | dump [file] — sample every Nth request into trace spans\n"
               << "  help     — show commands\n"
               << "  :q   — exit\n"
               << "  :b   — back/cancel\n";
@@ -264,11 +376,17 @@ bool Console::add_event()
     }
 
     std::cout << "Creating event..." << std::endl;
-    int event_id = new_event(tag, name, maturity, static_cast<double>(risk_cap));
+    int event_id = new_event(tag, name, maturity, Money::from_micros(risk_cap * Money::scale));
+    if (event_id < 0)
+        return true; // reason already reported
+
     std::cout << "Event created with ID: " << event_id << ", Tag: " << tag << std::endl;
 
     // initialize contract state
-    state[event_id] = std::make_unique<LMSRContract>(event_id, name, static_cast<double>(risk_cap), 0.0, 0.0, 0.0);
+    auto contract = std::make_unique<LMSRContract>(event_id, name, static_cast<double>(risk_cap));
+    const LMSRContract *listed = contract.get();
+    if (markets.insert(std::move(contract)))
+        catalog.add(event_id, tag, name, maturity, listed);
 
     return true;
 }
@@ -285,11 +403,7 @@ bool Console::list_events()
                          {"Name", [](const Event &e)
                           { return e.name; }},
                          {"Liquidity (funds)", [](const Event &e)
-                          {
-                              std::ostringstream oss;
-                              oss << std::fixed << std::setprecision(1) << e.event_funds;
-                              return oss.str();
-                          }},
+                          { return to_string(e.event_funds, 1); }},
                          {"Orders (count)", [](const Event &e)
                           { return std::to_string(e.order_count); }},
                          {"Maturity Date", [](const Event &e)
@@ -299,14 +413,21 @@ bool Console::list_events()
 
 bool Console::stake_event(Event &event)
 {
+    LMSRContract *contract = hydrator.find(event.id);
+    if (!contract)
+    {
+        error_msg("Event is not open for trading.\n");
+        return true;
+    }
+
     std::cout << "You are about to stake for event '" << event.name << "':\n";
     // get quote
-    Quote quote = state.at(event.id)->generate_quote();
+    Quote quote = contract->generate_quote();
 
     // build prompt string
     std::ostringstream prompt;
-    prompt << "Choose side [YES (" << round_figure(quote.price_yes)
-           << ") / NO (" << round_figure(quote.price_no)
+    prompt << "Choose side [YES (" << round_cents(quote.price_yes)
+           << ") / NO (" << round_cents(quote.price_no)
            << ") ]: ";
     std::string side_input;
 
@@ -357,10 +478,10 @@ bool Console::stake_event(Event &event)
     if (!ok)
         return true; // user cancelled with :b or empty
 
-    quote = state.at(event.id)->generate_quote(); // refresh quote before confirming
-    double stake_amount = std::stod(stake_input);
-    double expectded_cashout = stake_amount / (chosen_side == Side::YES ? quote.price_yes : quote.price_no);
-    std::cout << "Staking $" << round_figure(stake_amount)
+    quote = contract->generate_quote(); // refresh quote before confirming
+    Money stake_amount = Money::from_double(std::stod(stake_input));
+    double expectded_cashout = stake_amount.to_double() / (chosen_side == Side::YES ? quote.price_yes : quote.price_no);
+    std::cout << "Staking $" << stake_amount
               << " on " << (chosen_side == Side::YES ? "YES" : "NO")
               << " with expected cashout of $" << std::fixed << std::setprecision(2) << expectded_cashout << "\n";
 
@@ -386,7 +507,7 @@ bool Console::stake_event(Event &event)
     else
     {
         // place order
-        Order order = state.at(event.id)->buy(chosen_side, stake_amount);
+        Order order = contract->buy(chosen_side, stake_amount);
         if (order.event_id == 0)
         {
             std::cout << "Order failed.\n";
@@ -396,10 +517,10 @@ bool Console::stake_event(Event &event)
         else
         {
             std::cout << "Order placed successfully: "
-                      << "Stake $" << std::fixed << std::setprecision(2) << order.stake
+                      << "Stake $" << order.stake
                       << " on " << (order.side == Side::YES ? "YES" : "NO")
-                      << " at price " << std::fixed << std::setprecision(2) << order.price
-                      << " with expected cashout of $" << std::fixed << std::setprecision(2) << order.expected_cashout
+                      << " at price " << order.price
+                      << " with expected cashout of $" << order.expected_cashout
                       << "\n";
         }
     }
@@ -409,8 +530,15 @@ bool Console::stake_event(Event &event)
 
 bool Console::event_quote(Event &event)
 {
+    LMSRContract *contract = hydrator.find(event.id);
+    if (!contract)
+    {
+        error_msg("Event is not open for trading.\n");
+        return true;
+    }
+
     std::cout << "Quote for event '" << event.name << "':\n";
-    Quote quote = state.at(event.id)->generate_quote();
+    Quote quote = contract->generate_quote();
     std::cout << "YES Price: " << std::fixed << std::setprecision(2) << quote.price_yes
               << ", NO Price: " << std::fixed << std::setprecision(2) << quote.price_no
               << ", Max Stake: " << std::fixed << std::setprecision(1) << quote.size << "\n";
@@ -423,33 +551,19 @@ bool Console::event_orders(Event &event)
     std::vector<Order> orders = list_event_orders(event.id);
     auto columns = std::vector<std::pair<std::string, std::function<std::string(const Order &)>>>{
         {"Stake", [](const Order &o)
-         {
-             std::ostringstream oss;
-             oss << std::fixed << std::setprecision(1) << o.stake;
-             return oss.str();
-         }},
+         { return to_string(o.stake, 1); }},
         {"Side", [](const Order &o)
          { return o.side == Side::YES ? "YES" : "NO"; }},
         {"Price", [](const Order &o)
-         {
-             std::ostringstream oss;
-             oss << std::fixed << std::setprecision(2) << o.price;
-             return oss.str();
-         }},
+         { return to_string(o.price); }},
         {"Expected Cashout", [](const Order &o)
-         {
-             std::ostringstream oss;
-             oss << std::fixed << std::setprecision(2) << o.expected_cashout;
-             return oss.str();
-         }}};
+         { return to_string(o.expected_cashout); }}};
 
     // Only add "Payout" column if the event is resolved
     if (event.resolved)
     {
         columns.push_back({"Payout", [](const Order &o) {
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(2) << o.payout;
-            return oss.str();
+            return to_string(o.payout);
         }});
     }
 
@@ -485,12 +599,70 @@ bool Console::resolve_event(Event &event)
 
     bool outcome = (outcome_input == "yes");
 
-    double expected_total_payouts = 0.0;
-    resolve_event_outcome(event.id, outcome);
+    // stop trading first: unlist the market, let in-flight orders finish and
+    // make sure every queued fill is committed before computing payouts
+    LMSRContract *contract = hydrator.find(event.id);
+    if (contract)
+    {
+        contract->close();
+        markets.remove(event.id);
+        catalog.remove(event.id);
+    }
+    order_journal().sync();
+
+    // records the outcome, then pays out orders in the background
+    if (!settler().submit(event.id, outcome))
+    {
+        // reopen the market from its committed state, unless the outcome is
+        // already recorded (a settlement in progress never reopens)
+        Event current = get_event_details(std::to_string(event.id));
+        if (current.id != 0 && !current.resolved && !current.outcome.has_value())
+        {
+            auto reopened = std::make_unique<LMSRContract>(current.id, current.name, current.risk_cap.to_double(), current.q_yes,
+                                                           current.q_no, current.event_funds, current.order_count,
+                                                           current.aggregates);
+            const LMSRContract *listed = reopened.get();
+            if (markets.insert(std::move(reopened)))
+                catalog.add(current.id, current.tag, current.name, current.maturity, listed);
+        }
+        return true;
+    }
 
     std::cout << "Event resolved as '" << (outcome ? "YES" : "NO") << "'. "
-              << "Expected total payouts: $" << std::fixed << std::setprecision(2) << expected_total_payouts << "\n";
+              << "Paying out its orders in the background; type 'settlements' for progress.\n";
+
+    return true;
+}
+
+bool Console::list_settlements()
+{
+    std::vector<SettlementStatus> jobs = settler().status();
+    if (jobs.empty())
+    {
+        std::cout << "No settlements since startup.\n";
+        return true;
+    }
 
+    auto state_name = [](SettlementState state) {
+        switch (state)
+        {
+        case SettlementState::QUEUED:  return "queued";
+        case SettlementState::RUNNING: return "running";
+        case SettlementState::DONE:    return "done";
+        case SettlementState::FAILED:  return "failed";
+        }
+        return "?";
+    };
+    print_table(jobs, {{"Event", [](const SettlementStatus &s)
+                        { return std::to_string(s.progress.event_id); }},
+                       {"Outcome", [](const SettlementStatus &s)
+                        { return std::string(s.progress.outcome ? "YES" : "NO"); }},
+                       {"State", [&](const SettlementStatus &s)
+                        { return std::string(state_name(s.state)); }},
+                       {"Orders", [](const SettlementStatus &s)
+                        { return std::to_string(s.progress.settled_orders) + " / " + std::to_string(s.progress.total_orders); }},
+                       {"Paid Out", [](const SettlementStatus &s)
+                        { return to_string(s.progress.total_payout); }}});
     return true;
 }
 
@@ -500,18 +672,107 @@ bool Console::metrics(const int event_id)
     return true;
 }
 
+bool Console::trace(const std::string &action, const std::string &value)
+{
+    if (action == "on")
+    {
+        uint32_t every = 1;
+        if (!value.empty())
+        {
+            if (!is_integer(value) || std::stol(value) < 1)
+            {
+                error_msg("Usage: trace on [N]  (sample every Nth request, N >= 1)");
+                return true;
+            }
+            every = static_cast<uint32_t>(std::stol(value));
+        }
+        trace_start(every);
+        success_msg("Tracing on, sampling 1 in " + std::to_string(every) + " requests per thread.");
+        return true;
+    }
+    if (action == "off")
+    {
+        trace_stop();
+        success_msg("Tracing off; recorded spans are kept until the next 'trace on'.");
+        return true;
+    }
+    if (action == "dump")
+    {
+        std::string path = value.empty() ? "trace.json" : value;
+        std::ofstream out(path);
+        if (!out || !(out << trace_dump_json()))
+        {
+            error_msg("Could not write " + path);
+            return true;
+        }
+        success_msg("Trace written to " + path + " (open in ui.perfetto.dev or chrome://tracing).");
+        return true;
+    }
 
+    std::cout << "Tracing is " << (trace_running() ? "on, 1 in " + std::to_string(trace_sample_every()) : std::string("off"))
+              << ". Usage: trace on [N] | off | dump [file]\n";
+    return true;
+}
 
 
 
 
 
 
+
+
+// metrics label for a route pattern (httplib's Request::matched_route)
+static HttpRoute http_route_of(const std::string &pattern)
+{
+    if (pattern == "/events")          return HttpRoute::EVENTS;
+    if (pattern == R"(/quote/(\d+))")  return HttpRoute::QUOTE;
+    if (pattern == "/quotes")          return HttpRoute::QUOTES;
+    if (pattern == R"(/order/(\d+))")  return HttpRoute::ORDER;
+    if (pattern == "/orders/batch")    return HttpRoute::ORDERS_BATCH;
+    if (pattern == "/metrics")         return HttpRoute::METRICS;
+    if (pattern == R"(/metrics/(\d+))") return HttpRoute::EVENT_METRICS;
+    if (pattern == "/trace")           return HttpRoute::TRACE;
+    if (pattern == "/ready")           return HttpRoute::READY;
+    if (pattern == "/stream/quotes")   return HttpRoute::STREAM_QUOTES;
+    return HttpRoute::OTHER;
+}
+
 // http server
 void Console::start_http_server()
 {
-    std::thread([this] {
-        httplib::Server svr;
+    http_thread = std::thread([this] {
+        httplib::Server &svr = http_server;
+
+        // responses go out as header + body writes; without this, Nagle plus
+        // the client's delayed ACK holds every keep-alive response ~40 ms
+        svr.set_tcp_nodelay(true);
+
+        // worker pool that reports its queue depth; a streaming client holds
+        // its worker for as long as it stays connected, so those come on top
+        size_t workers = CPPHTTPLIB_THREAD_POOL_COUNT + options.stream.max_subscribers;
+        svr.new_task_queue = [workers] { return new InstrumentedTaskQueue(workers); };
+
+        // per-route request count and latency; a request is routed and
+        // answered on the same worker thread
+        static thread_local std::chrono::steady_clock::time_point request_start;
+        svr.set_pre_routing_handler([this](const httplib::Request& req, httplib::Response& res) {
+            request_start = std::chrono::steady_clock::now();
+
+            // until the markets are loaded, anything that reads them would
+            // see an empty registry and answer a spurious 404
+            if (!ready.load(std::memory_order_acquire) && req.path != "/ready" && req.path != "/metrics" &&
+                req.path != "/trace") {
+                res.status = 503;
+                res.set_header("Retry-After", "1");
+                res.set_content(R"({"error":"Starting up"})", "application/json");
+                return httplib::Server::HandlerResponse::Handled;
+            }
+            return httplib::Server::HandlerResponse::Unhandled;
+        });
+        svr.set_post_routing_handler([](const httplib::Request& req, httplib::Response& res) {
+            metrics_count_request(http_route_of(req.matched_route), res.status,
+                                  std::chrono::steady_clock::now() - request_start);
+        });
 
         // --- Helper: safe JSON response ---
         auto json_response = [](httplib::Response& res, const nlohmann::json& j, int status = 200) {
@@ -524,42 +785,237 @@ void Console::start_http_server()
             json_response(res, {{"error", msg}}, status);
         };
 
+        // --- Helper: response already encoded by json_codec ---
+        auto json_text = [](httplib::Response& res, std::string_view body, int status = 200) {
+            static const std::string content_type = "application/json";
+            res.status = status;
+            res.set_content(body.data(), body.size(), content_type);
+        };
+
+        // --- GET /ready (200 once the markets are loaded, 503 before) ---
+        svr.Get("/ready", [this, &json_response](const httplib::Request&, httplib::Response& res) {
+            bool up = ready.load(std::memory_order_acquire);
+            json_response(res, {{"ready", up}, {"markets", markets.size()}, {"cold_markets", hydrator.pending()}},
+                          up ? 200 : 503);
+        });
+
         // --- GET /events ---
-        svr.Get("/events", [this, &json_response](const httplib::Request&, httplib::Response& res) {
+        // served from the in-memory catalog; 304 when the client's ETag is current
+        svr.Get("/events", [this, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("GET /events");
             try {
-                nlohmann::json j;
-                auto events = list_all_events(false);
-                for (const auto& e : events) {
-                    j.push_back({
-                        {"id", e.id},
-                        {"tag", e.tag},
-                        {"name", e.name},
-                        {"liquidity", round_figure(e.event_funds)},
-                        {"orders", e.order_count},
-                        {"maturity", e.maturity}
-                    });
+                std::shared_ptr<const EventCatalog::Body> body = catalog.body();
+                res.set_header("ETag", body->etag);
+                res.set_header("Cache-Control", "no-cache");
+                if (etag_matches(req.get_header_value("If-None-Match"), body->etag)) {
+                    res.status = 304;
+                    return;
                 }
-                json_response(res, j);
+                res.set_content(body->json, "application/json");
             } catch (const std::exception& ex) {
                 json_response(res, {{"error", ex.what()}}, 500);
             }
         });
 
         // --- GET /quote/<id> ---
-        svr.Get(R"(/quote/(\d+))", [this, &json_error, &json_response](const httplib::Request& req, httplib::Response& res) {
+        svr.Get(R"(/quote/(\d+))", [this, &json_text, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("GET /quote/:id");
             try {
                 int id = std::stoi(req.matches[1]);
-                auto it = state.find(id);
-                if (it == state.end()) {
+                LMSRContract *contract = hydrator.find(id);
+                if (!contract) {
+                    json_text(res, error_json("Event not found"), 404);
+                    return;
+                }
+
+                json_text(res, quote_json(contract->generate_quote()));
+            } catch (const std::exception& ex) {
+                json_response(res, {{"error", ex.what()}}, 500);
+            }
+        });
+
+        // --- GET /quotes[?ids=1,2,3] ---
+        // the quote every open market (or each listed one) published with its
+        // last fill, the same one GET /quote/<id> returns
+        svr.Get("/quotes", [this, &json_error, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("GET /quotes");
+            try {
+                nlohmann::json quotes = nlohmann::json::array();
+                nlohmann::json missing = nlohmann::json::array();
+
+                auto add_market = [&quotes](const LMSRContract &contract) {
+                    Quote quote = contract.generate_quote();
+                    quotes.push_back({
+                        {"id", contract.contract_id},
+                        {"yes_price", round_cents(quote.price_yes)},
+                        {"no_price", round_cents(quote.price_no)},
+                        {"max_stake", static_cast<int>(quote.size)}
+                    });
+                };
+
+                if (req.has_param("ids")) {
+                    std::stringstream ids(req.get_param_value("ids"));
+                    std::string token;
+                    while (std::getline(ids, token, ',')) {
+                        // digits only, and small enough for an int
+                        bool valid = !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+                        int id = 0;
+                        try {
+                            if (valid)
+                                id = std::stoi(token);
+                        } catch (const std::out_of_range&) {
+                            valid = false;
+                        }
+                        if (!valid) {
+                            json_error(res, "ids must be a comma-separated list of event ids");
+                            return;
+                        }
+                        if (LMSRContract *contract = hydrator.find(id))
+                            add_market(*contract);
+                        else
+                            missing.push_back(id);
+                    }
+                } else {
+                    hydrator.hydrate_all();
+                    markets.for_each(add_market);
+                }
+
+                nlohmann::json j{{"quotes", quotes}};
+                if (!missing.empty())
+                    j["missing"] = missing;
+                json_response(res, j);
+            } catch (const std::exception& ex) {
+                json_response(res, {{"error", ex.what()}}, 500);
+            }
+        });
+
+        // --- GET /stream/quotes[?ids=1,2,3] (Server-Sent Events) ---
+        // the current quote of every open market (or the listed ones), then
+        // an event whenever one changes, at most one per market per
+        // --stream-interval-ms
+        svr.Get("/stream/quotes", [this, &json_error](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("GET /stream/quotes");
+            std::vector<int> ids;
+            if (req.has_param("ids")) {
+                std::stringstream list(req.get_param_value("ids"));
+                std::string token;
+                while (std::getline(list, token, ',')) {
+                    // digits only, and small enough for an int
+                    bool valid = !token.empty() && token.find_first_not_of("0123456789") == std::string::npos;
+                    try {
+                        if (valid)
+                            ids.push_back(std::stoi(token));
+                    } catch (const std::out_of_range&) {
+                        valid = false;
+                    }
+                    if (!valid) {
+                        json_error(res, "ids must be a comma-separated list of event ids");
+                        return;
+                    }
+                }
+            }
+
+            std::shared_ptr<QuoteSubscriber> subscriber = quote_stream().subscribe(ids);
+            if (!subscriber) {
+                res.set_header("Retry-After", "1");
+                json_error(res, "Too many streaming clients", 503);
+                return;
+            }
+
+            // read after subscribing, so no update falls between the two; an
+            // event may repeat a version the snapshot already showed
+            std::string initial;
+            if (ids.empty()) {
+                hydrator.hydrate_all();
+                markets.for_each([&initial](const LMSRContract& contract) {
+                    append_quote_event(initial, contract.contract_id, contract.generate_quote());
+                });
+            } else {
+                for (int id : ids)
+                    if (const LMSRContract *contract = hydrator.find(id))
+                        append_quote_event(initial, id, contract->generate_quote());
+            }
+
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider(
+                "text/event-stream",
+                [subscriber, initial = std::move(initial), batch = std::string()](size_t, httplib::DataSink& sink) mutable {
+                    if (!initial.empty()) {
+                        bool ok = sink.write(initial.data(), initial.size());
+                        std::string().swap(initial);
+                        return ok;
+                    }
+                    // a comment line when idle keeps proxies from timing out
+                    // and notices a client that went away
+                    if (!subscriber->take(batch, std::chrono::seconds(15))) {
+                        sink.done();
+                        return true;
+                    }
+                    if (batch.empty())
+                        batch = ": keep-alive\n\n";
+                    return sink.write(batch.data(), batch.size());
+                },
+                [subscriber](bool) { quote_stream().unsubscribe(subscriber); });
+        });
+
+        // --- GET /metrics (Prometheus text format) ---
+        svr.Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+            metrics_gauge_set(MetricGauge::OPEN_MARKETS, static_cast<int64_t>(markets.size()));
+            res.set_content(metrics_render(), "text/plain; version=0.0.4");
+        });
+
+        // --- GET /metrics/<id> (one event's exposure) ---
+        // open markets answer from their published snapshot, closed ones
+        // from their events row; neither scans the order book
+        svr.Get(R"(/metrics/(\d+))", [this, &json_error, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("GET /metrics/:id");
+            try {
+                // the path only matches digits; too many for an int is no event
+                int id;
+                try {
+                    id = std::stoi(req.matches[1]);
+                } catch (const std::out_of_range&) {
                     json_error(res, "Event not found", 404);
                     return;
                 }
+                Money risk_cap, funds;
+                int64_t orders;
+                bool open = true, resolved = false;
+                OrderAggregates totals;
+                if (LMSRContract *contract = hydrator.find(id)) {
+                    MarketSnapshot s = contract->snapshot();
+                    risk_cap = Money::from_double(contract->risk_limit());
+                    funds = s.total_deposits;
+                    orders = s.order_count;
+                    totals = s.aggregates;
+                } else {
+                    Event e = get_event_details(std::to_string(id));
+                    if (e.id == 0) {
+                        json_error(res, "Event not found", 404);
+                        return;
+                    }
+                    risk_cap = e.risk_cap;
+                    funds = e.event_funds;
+                    orders = e.order_count;
+                    totals = e.aggregates;
+                    open = false;
+                    resolved = e.resolved;
+                }
 
-                Quote q = it->second->generate_quote();
                 nlohmann::json j{
-                    {"yes_price", round_figure(q.price_yes)},
-                    {"no_price", round_figure(q.price_no)},
-                    {"max_stake", static_cast<int>(q.size)}
+                    {"id", id},
+                    {"open", open},
+                    {"resolved", resolved},
+                    {"risk_cap", risk_cap.rounded()},
+                    {"orders", orders},
+                    {"liquidity", funds.rounded()},
+                    {"yes_stake", totals.yes_stake.rounded()},
+                    {"no_stake", totals.no_stake.rounded()},
+                    {"largest_stake", totals.largest_stake.rounded()},
+                    {"yes_liability", totals.yes_liability.rounded()},
+                    {"no_liability", totals.no_liability.rounded()},
+                    {"pnl_if_yes", (funds - totals.yes_liability).rounded()},
+                    {"pnl_if_no", (funds - totals.no_liability).rounded()}
                 };
                 json_response(res, j);
             } catch (const std::exception& ex) {
@@ -567,62 +1023,181 @@ void Console::start_http_server()
             }
         });
 
+        // --- GET /trace (Chrome trace-event JSON of the sampled spans) ---
+        svr.Get("/trace", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(trace_dump_json(), "application/json");
+        });
+
         // --- POST /order/<id> ---
-        svr.Post(R"(/order/(\d+))", [this, &json_error, &json_response](const httplib::Request& req, httplib::Response& res) {
+        // bodies and responses go through json_codec; bodies it does not
+        // handle are parsed with nlohmann as before
+        svr.Post(R"(/order/(\d+))", [this, &json_text, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("POST /order/:id");
             try {
                 int id = std::stoi(req.matches[1]);
-                auto it = state.find(id);
-                if (it == state.end()) {
-                    json_error(res, "Event not found", 404);
+                LMSRContract *contract = hydrator.find(id);
+                if (!contract) {
+                    metrics_count_order(OrderStatus::MARKET_NOT_FOUND);
+                    json_text(res, error_json("Event not found"), 404);
                     return;
                 }
 
-                // Parse JSON body safely
-                nlohmann::json body;
-                try {
-                    body = nlohmann::json::parse(req.body);
-                } catch (const std::exception&) {
-                    json_error(res, "Invalid JSON body");
-                    return;
+                double stake = 0.0;
+                std::string_view side;
+                std::string parsed_side; // owns `side` when nlohmann parsed the body
+                OrderBodyParse parsed;
+                {
+                    TraceSpan parse("parse order body");
+                    parsed = parse_order_body(req.body, stake, side);
+                }
+                if (parsed == OrderBodyParse::FALLBACK) {
+                    // Parse JSON body safely
+                    nlohmann::json body;
+                    try {
+                        TraceSpan parse("parse order body");
+                        body = nlohmann::json::parse(req.body);
+                    } catch (const std::exception&) {
+                        metrics_count_order(OrderStatus::INVALID_ORDER);
+                        json_text(res, error_json("Invalid JSON body"), 400);
+                        return;
+                    }
+                    if (body.contains("stake") && body.contains("side")) {
+                        parsed = OrderBodyParse::OK;
+                        stake = body["stake"].get<double>();
+                        parsed_side = body["side"].get<std::string>();
+                        side = parsed_side;
+                    }
                 }
 
-                if (!body.contains("stake") || !body.contains("side")) {
-                    json_error(res, "Missing 'stake' or 'side' in request");
+                if (parsed != OrderBodyParse::OK) {
+                    metrics_count_order(OrderStatus::INVALID_ORDER);
+                    json_text(res, error_json("Missing 'stake' or 'side' in request"), 400);
                     return;
                 }
 
-                double stake = body["stake"].get<double>();
-                std::string side = body["side"].get<std::string>();
                 if (side != "yes" && side != "no") {
-                    json_error(res, "Invalid side; must be 'yes' or 'no'");
+                    metrics_count_order(OrderStatus::INVALID_ORDER);
+                    json_text(res, error_json("Invalid side; must be 'yes' or 'no'"), 400);
                     return;
                 }
 
                 Side s = (side == "yes") ? Side::YES : Side::NO;
 
-                Quote q = it->second->generate_quote();
+                Quote q;
+                {
+                    TraceSpan quote("generate_quote");
+                    q = contract->generate_quote();
+                }
                 if (stake <= 0.0 || stake > q.size) {
-                    json_error(res, "Invalid stake amount, must be > 0 and <= " + std::to_string(static_cast<int>(q.size)));
+                    metrics_count_order(stake <= 0.0 ? OrderStatus::INVALID_ORDER : OrderStatus::EXCEEDS_MAX_STAKE);
+                    json_text(res, stake_error_json(static_cast<int>(q.size)), 400);
+                    return;
+                }
+
+                OrderStatus status;
+                Order o = contract->buy(s, Money::from_double(stake), &status);
+                if (status != OrderStatus::FILLED) {
+                    json_text(res, error_json(order_status_message(status)), 409);
                     return;
                 }
 
-                Order o = it->second->buy(s, stake);
+                TraceSpan encode("encode order response");
+                json_text(res, order_json(o));
 
-                nlohmann::json j{
-                    {"event_id", o.event_id},
-                    {"side", side},
-                    {"stake", round_figure(o.stake)},
-                    {"price", round_figure(o.price)},
-                    {"expected_cashout", round_figure(o.expected_cashout)}
+            } catch (const std::exception& ex) {
+                json_response(res, {{"error", ex.what()}}, 500);
+            }
+        });
+
+        // --- POST /orders/batch ---
+        // Body: [{"event_id": 1, "side": "yes", "stake": 10.0}, ...]
+        // Orders run in array order and all fills commit in one transaction.
+        svr.Post("/orders/batch", [this, &json_error, &json_response](const httplib::Request& req, httplib::Response& res) {
+            TraceSpan span("POST /orders/batch");
+            try {
+                nlohmann::json body;
+                try {
+                    TraceSpan parse("parse batch body");
+                    body = nlohmann::json::parse(req.body);
+                } catch (const std::exception&) {
+                    json_error(res, "Invalid JSON body");
+                    return;
+                }
+
+                if (!body.is_array() || body.empty()) {
+                    json_error(res, "Body must be a non-empty array of orders");
+                    return;
+                }
+                if (body.size() > max_batch_orders) {
+                    json_error(res, "Too many orders in batch; max " + std::to_string(max_batch_orders));
+                    return;
+                }
+
+                std::vector<LMSRContract::BatchLeg> legs;
+                std::vector<bool> valid;
+                legs.reserve(body.size());
+                // 1..INT_MAX: get<int>() would wrap a larger id onto another market
+                auto event_id_of = [](const nlohmann::json& value) -> int {
+                    int64_t id = 0;
+                    if (value.is_number_unsigned())
+                        id = value.get<uint64_t>() <= static_cast<uint64_t>(std::numeric_limits<int>::max()) ? value.get<int64_t>() : 0;
+                    else if (value.is_number_integer())
+                        id = value.get<int64_t>();
+                    return id > 0 && id <= std::numeric_limits<int>::max() ? static_cast<int>(id) : 0;
                 };
-                json_response(res, j);
+                for (const auto& item : body) {
+                    int event_id = item.is_object() && item.contains("event_id") ? event_id_of(item["event_id"]) : 0;
+                    bool ok = event_id != 0
+                        && item.contains("stake") && item["stake"].is_number()
+                        && item.contains("side") && item["side"].is_string()
+                        && (item["side"] == "yes" || item["side"] == "no");
+                    valid.push_back(ok);
+                    if (!ok) {
+                        legs.push_back({nullptr, Side::NO, Money()});
+                        continue;
+                    }
+                    legs.push_back({hydrator.find(event_id),
+                                    item["side"] == "yes" ? Side::YES : Side::NO,
+                                    Money::from_double(item["stake"].get<double>())});
+                }
+
+                auto results = LMSRContract::buy_batch(legs);
+
+                nlohmann::json out = nlohmann::json::array();
+                size_t filled = 0;
+                for (size_t i = 0; i < results.size(); ++i) {
+                    OrderStatus status = valid[i] ? results[i].status : OrderStatus::INVALID_ORDER;
+                    if (!legs[i].contract)
+                        metrics_count_order(status);
+                    if (status == OrderStatus::FILLED) {
+                        const Order& o = results[i].order;
+                        ++filled;
+                        out.push_back({
+                            {"index", i},
+                            {"event_id", o.event_id},
+                            {"side", o.side == Side::YES ? "yes" : "no"},
+                            {"stake", o.stake.rounded()},
+                            {"price", o.price.rounded()},
+                            {"expected_cashout", o.expected_cashout.rounded()}
+                        });
+                    } else {
+                        out.push_back({{"index", i}, {"error", order_status_message(status)}});
+                    }
+                }
+
+                json_response(res, {{"filled", filled}, {"rejected", results.size() - filled}, {"results", out}});
 
             } catch (const std::exception& ex) {
                 json_response(res, {{"error", ex.what()}}, 500);
             }
         });
 
-        success_msg("[HTTP SERVER] running on 127.0.0.1:4444\n");
-        svr.listen("127.0.0.1", 4444);
-    }).detach();
+        std::string address = options.http_host + ":" + std::to_string(options.http_port);
+        success_msg("[HTTP SERVER] running on " + address + "\n");
+        if (!svr.listen(options.http_host, options.http_port))
+            error_msg("[HTTP SERVER] could not listen on " + address);
+    });
+
+    // stop() is only safe once the server is listening (or has failed to)
+    http_server.wait_until_ready();
 }
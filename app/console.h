@@ -1,25 +1,55 @@
 #pragma once
 #include "database.h"
 #include "contract.h"
+#include "registry.h"
+#include "metrics.h"
+#include "trace.h"
+#include "http_task_queue.h"
+#include "quote_stream.h"
+#include "json_codec.h"
 #include "json.hpp"
 #include "httplib.h"
 #include "utils.h"
 #include "event.h"
+#include "event_catalog.h"
+#include "hydration.h"
+#include "journal.h"
+#include "settlement.h"
+#include "logger.h"
+#include "options.h"
+#include "order_gateway.h"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <limits>
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 
 class Console
 {
 public:
+    explicit Console(const Options &options_ = Options{}) : options(options_) {}
     void run();
     void print_welcome();
-    std::unordered_map<int, std::unique_ptr<LMSRContract>> state;
+
+    // engine and HTTP server without the command loop (run() = start + loop + stop)
+    bool start();
+    void stop();
+    MarketRegistry markets;
+    MarketHydrator hydrator{markets}; // fills `markets` at startup (or lazily)
+    EventCatalog catalog; // GET /events; lists the markets above
+    OrderGateway gateway{[this](int id) { return hydrator.find(id); }}; // --wire-port
 
 private:
+    static constexpr size_t max_batch_orders = 1000;
+    Options options;
+    httplib::Server http_server;
+    std::thread http_thread;
+    std::atomic<bool> ready{false}; // markets hydrated; market routes answer 503 before
+    std::thread warm_thread;        // builds the first GET /events body
     bool dispatch(const std::string &cmd);
     bool help();
     auto get_input(const std::string& prompt, std::string& out);
@@ -29,6 +59,8 @@ private:
     bool event_quote(Event& event);
     bool event_orders(Event& event);
     bool resolve_event(Event& event);
+    bool list_settlements();
     bool metrics(const int  event_id);
+    bool trace(const std::string &action, const std::string &value);
     void start_http_server();
 };
@@ -0,0 +1,37 @@
+#pragma once
+#include "httplib.h"
+#include "metrics.h"
+#include <functional>
+
+
+// httplib's ThreadPool with its queue depth and busy workers exported as
+// metrics. httplib enqueues one task per accepted connection and a worker
+// serves that connection until it closes (keep-alive included), so queued
+// tasks are clients waiting for a free worker.
+class InstrumentedTaskQueue : public httplib::TaskQueue
+{
+    private:
+        httplib::ThreadPool pool;
+
+    public:
+        explicit InstrumentedTaskQueue(size_t workers) : pool(workers)
+        {
+            metrics_gauge_set(MetricGauge::HTTP_WORKERS, static_cast<int64_t>(workers));
+        }
+
+        bool enqueue(std::function<void()> fn) override
+        {
+            metrics_gauge_add(MetricGauge::HTTP_QUEUED_CONNECTIONS, 1);
+            bool queued = pool.enqueue([fn = std::move(fn)]() {
+                metrics_gauge_add(MetricGauge::HTTP_QUEUED_CONNECTIONS, -1);
+                metrics_gauge_add(MetricGauge::HTTP_BUSY_WORKERS, 1);
+                fn();
+                metrics_gauge_add(MetricGauge::HTTP_BUSY_WORKERS, -1);
+            });
+            if (!queued)
+                metrics_gauge_add(MetricGauge::HTTP_QUEUED_CONNECTIONS, -1);
+            return queued;
+        }
+
+        void shutdown() override { pool.shutdown(); }
+};
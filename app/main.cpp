@@ -2,9 +2,13 @@
 #include "console.h"
 
 
-int main() {
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options))
+        return 1;
+
     try {
-        Console console;
+        Console console(options);
         console.run();
     } catch (const std::exception &e) {
         std::cerr << "Exception: " << e.what() << "\n";
@@ -0,0 +1,179 @@
+#include "options.h"
+#include "utils.h"
+#include <iostream>
+
+
+static void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --durability=sync|group|async|none\n"
+              << "                                 when a fill must be on disk (default sync)\n"
+              << "                                   sync:  commit per order before confirming\n"
+              << "                                   group: batch commits, confirm once the batch is durable\n"
+              << "                                   async: batch commits, confirm immediately\n"
+              << "                                   none:  never persist (benchmarks only)\n"
+              << "  --group-size=N                 max fills per group commit (default 64)\n"
+              << "  --group-window-us=M            max wait before a group commit (default 2000)\n"
+              << "  --storage=sqlite|binlog        where fills are made durable (default sqlite)\n"
+              << "                                   binlog: append-only log, copied to the database in the background\n"
+              << "  --binlog-dir=PATH              binlog segment and snapshot directory (default binlog)\n"
+              << "  --snapshot-interval-s=N        seconds between binlog market state snapshots (default 60)\n"
+              << "  --execution=locked|sequenced   how single orders reach a market (default locked)\n"
+              << "                                   locked:    the request's thread takes the market lock\n"
+              << "                                   sequenced: one thread per shard of markets applies orders in arrival order\n"
+              << "  --execution-threads=N          sequencer shards (default: one per hardware thread)\n"
+              << "  --execution-batch=N            max orders a sequencer applies and persists together (default 64)\n"
+              << "  --settle-workers=N             events settled concurrently (default 2)\n"
+              << "  --settle-chunk=N               orders paid out per settlement transaction (default 2000)\n"
+              << "  --hydrate=eager|lazy           load every open market at startup, or each on first access (default eager)\n"
+              << "  --hydrate-threads=N            startup hydration workers (default: one per hardware thread)\n"
+              << "  --port=N                       HTTP port on 127.0.0.1 (default 4444)\n"
+              << "  --wire-port=N                  also accept binary order-entry connections on port N (default off)\n"
+              << "  --wire-connections=N           max binary order-entry connections (default 64)\n"
+              << "  --stream-interval-ms=N         GET /stream/quotes: merge a market's updates within N ms (default 100)\n"
+              << "  --stream-buffer-kb=N           unsent events per streaming client before it is dropped (default 1024)\n"
+              << "  --stream-clients=N             max streaming clients, each holding an HTTP worker (default 64)\n"
+              << "  --log-level=debug|info|warn|error|off\n"
+              << "                                 least severe engine log record written (default info)\n"
+              << "  --log-file=PATH                append the engine log to PATH (logfmt) instead of the console\n"
+              << "  --trace=N                      start with tracing on, sampling 1 in N requests\n"
+              << "  --help                         show this message\n";
+}
+
+// split "--key=value"; returns false if arg is not of that form
+static bool split_flag(const std::string &arg, std::string &key, std::string &value)
+{
+    if (arg.rfind("--", 0) != 0)
+        return false;
+    size_t eq = arg.find('=');
+    key = arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+    value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+    return true;
+}
+
+bool parse_options(int argc, char *argv[], Options &out)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string key, value;
+
+        if (!split_flag(arg, key, value) || key == "help")
+        {
+            print_usage(argv[0]);
+            return false;
+        }
+
+        if (key == "durability")
+        {
+            if (value == "sync")
+                out.journal.durability = Durability::SYNC;
+            else if (value == "group")
+                out.journal.durability = Durability::GROUP;
+            else if (value == "async")
+                out.journal.durability = Durability::ASYNC;
+            else if (value == "none")
+                out.journal.durability = Durability::NONE;
+            else
+            {
+                error_msg("Invalid --durability: '" + value + "'");
+                return false;
+            }
+        }
+        else if (key == "group-size" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.journal.group_max_orders = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "storage" && (value == "sqlite" || value == "binlog"))
+        {
+            out.journal.storage = value == "binlog" ? StorageEngine::BINLOG : StorageEngine::SQLITE;
+        }
+        else if (key == "binlog-dir" && !value.empty())
+        {
+            out.journal.binlog.directory = value;
+        }
+        else if (key == "snapshot-interval-s" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.journal.binlog.snapshot_interval = std::chrono::seconds(std::stol(value));
+        }
+        else if (key == "hydrate" && (value == "eager" || value == "lazy"))
+        {
+            out.hydration.mode = value == "lazy" ? HydrationMode::LAZY : HydrationMode::EAGER;
+        }
+        else if (key == "hydrate-threads" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.hydration.threads = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "execution" && (value == "locked" || value == "sequenced"))
+        {
+            out.execution.mode = value == "sequenced" ? ExecutionMode::SEQUENCED : ExecutionMode::LOCKED;
+        }
+        else if (key == "execution-threads" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.execution.threads = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "execution-batch" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.execution.max_batch = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "settle-workers" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.settlement.workers = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "settle-chunk" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.settlement.chunk_orders = static_cast<int>(std::stol(value));
+        }
+        else if (key == "port" && is_integer(value) && std::stol(value) > 0 && std::stol(value) < 65536)
+        {
+            out.http_port = static_cast<int>(std::stol(value));
+        }
+        else if (key == "wire-port" && is_integer(value) && std::stol(value) > 0 && std::stol(value) < 65536)
+        {
+            out.wire_port = static_cast<int>(std::stol(value));
+        }
+        else if (key == "wire-connections" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.wire_connections = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "stream-interval-ms" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.stream.interval = std::chrono::milliseconds(std::stol(value));
+        }
+        else if (key == "stream-buffer-kb" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.stream.buffer_bytes = static_cast<size_t>(std::stol(value)) * 1024;
+        }
+        else if (key == "stream-clients" && is_integer(value) && std::stol(value) >= 0)
+        {
+            out.stream.max_subscribers = static_cast<size_t>(std::stol(value));
+        }
+        else if (key == "log-level")
+        {
+            if (!parse_log_level(value, out.log.level))
+            {
+                error_msg("Invalid --log-level: '" + value + "'");
+                return false;
+            }
+        }
+        else if (key == "log-file" && !value.empty())
+        {
+            out.log.file = value;
+        }
+        else if (key == "trace" && is_integer(value) && std::stol(value) > 0)
+        {
+            out.trace_sample_every = static_cast<uint32_t>(std::stol(value));
+        }
+        else if (key == "group-window-us" && is_integer(value) && std::stol(value) >= 0)
+        {
+            out.journal.group_max_delay = std::chrono::microseconds(std::stol(value));
+        }
+        else
+        {
+            error_msg("Invalid option: '" + arg + "'");
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "hydration.h"
+#include "journal.h"
+#include "logger.h"
+#include "quote_stream.h"
+#include "sequencer.h"
+#include "settlement.h"
+#include <cstdint>
+#include <string>
+
+
+// Command-line settings for the engine (see `--help`).
+struct Options
+{
+    JournalConfig journal;
+    SequencerConfig execution;
+    LogConfig log;
+    SettlerConfig settlement;
+    HydrationConfig hydration;
+    QuoteStreamConfig stream;
+    std::string http_host = "127.0.0.1";
+    int http_port = 4444;
+    int wire_port = 0;                 // binary order entry; 0: off
+    size_t wire_connections = 64;
+    uint32_t trace_sample_every = 0; // 0: tracing starts off
+};
+
+// Parses argv into `out`. Returns false (after printing usage) on bad input
+// or `--help`.
+bool parse_options(int argc, char *argv[], Options &out);
@@ -0,0 +1,233 @@
+#include "order_gateway.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
+#include <climits>
+#include <cstring>
+#include <vector>
+
+#if defined(MSG_NOSIGNAL)
+static constexpr int send_flags = MSG_NOSIGNAL; // a closed peer is an error, not SIGPIPE
+#else
+static constexpr int send_flags = 0;
+#endif
+
+static constexpr size_t receive_buffer_size = 64 * 1024;
+
+
+static bool send_all(socket_t socket, const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = httplib::detail::send_socket(socket, data, size, send_flags);
+        if (sent <= 0)
+            return false;
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+OrderGateway::OrderGateway(std::function<LMSRContract *(int)> find_market_) : find_market(std::move(find_market_))
+{
+}
+
+OrderGateway::~OrderGateway()
+{
+    stop();
+}
+
+bool OrderGateway::start(const std::string &host, int port, size_t max_connections_)
+{
+    stop();
+    max_connections = max_connections_;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return false;
+
+    for (addrinfo *a = addresses; a && listener == INVALID_SOCKET; a = a->ai_next)
+    {
+        socket_t s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == INVALID_SOCKET)
+            continue;
+        int yes = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&yes), sizeof yes);
+        if (bind(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) == 0 && listen(s, 128) == 0)
+            listener = s;
+        else
+            httplib::detail::close_socket(s);
+    }
+    freeaddrinfo(addresses);
+    if (listener == INVALID_SOCKET)
+        return false;
+
+    running = true;
+    acceptor = std::thread(&OrderGateway::accept_loop, this);
+    return true;
+}
+
+void OrderGateway::stop()
+{
+    running = false;
+    if (acceptor.joinable())
+        acceptor.join();
+    if (listener != INVALID_SOCKET)
+    {
+        httplib::detail::close_socket(listener);
+        listener = INVALID_SOCKET;
+    }
+
+    // wake the connection threads out of recv(); no connection is added now
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Connection &c : connections)
+            if (c.socket != INVALID_SOCKET)
+                httplib::detail::shutdown_socket(c.socket);
+    }
+    for (Connection &c : connections)
+        c.thread.join();
+    connections.clear();
+}
+
+void OrderGateway::reap_finished()
+{
+    for (auto it = connections.begin(); it != connections.end();)
+    {
+        if (it->finished)
+        {
+            it->thread.join();
+            it = connections.erase(it);
+        }
+        else
+            ++it;
+    }
+}
+
+void OrderGateway::accept_loop()
+{
+    while (running)
+    {
+        // wake up now and then to notice stop()
+        if (httplib::detail::select_read(listener, 0, 100'000) <= 0)
+            continue;
+        socket_t s = accept(listener, nullptr, nullptr);
+        if (s == INVALID_SOCKET)
+            continue;
+
+        // replies are small and latency is the point
+        int yes = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&yes), sizeof yes);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        reap_finished();
+        if (connections.size() >= max_connections)
+        {
+            httplib::detail::close_socket(s);
+            continue;
+        }
+        connections.emplace_back();
+        Connection &c = connections.back();
+        c.socket = s;
+        c.thread = std::thread(&OrderGateway::serve, this, std::ref(c));
+    }
+}
+
+void OrderGateway::serve(Connection &connection)
+{
+    metrics_gauge_add(MetricGauge::WIRE_CONNECTIONS, 1);
+
+    // worst case every received frame is a bare header answered with the
+    // largest reply
+    std::vector<uint8_t> in(receive_buffer_size);
+    std::vector<uint8_t> out(receive_buffer_size / wire_header_size * wire_max_frame_size);
+    size_t have = 0;
+    uint64_t expected_sequence = 1;
+
+    while (running)
+    {
+        ssize_t received = httplib::detail::read_socket(connection.socket, in.data() + have, in.size() - have, 0);
+        if (received <= 0)
+            break;
+        have += static_cast<size_t>(received);
+
+        size_t used = 0, out_size = 0;
+        bool malformed = false;
+        while (have - used >= wire_header_size)
+        {
+            WireFrame frame(in.data() + used);
+            if (!frame.valid_header() || (frame.type() != WireType::ORDER && frame.type() != WireType::QUOTE_REQUEST))
+            {
+                malformed = true;
+                break;
+            }
+            if (have - used < frame.length())
+                break;
+            execute(frame, expected_sequence, out.data(), out_size);
+            used += frame.length();
+        }
+
+        if (out_size > 0 && !send_all(connection.socket, out.data(), out_size))
+            break;
+        if (malformed)
+        {
+            metrics_count(MetricCounter::WIRE_PROTOCOL_ERRORS);
+            log_warn("[WIRE] Malformed frame; closing the connection.", {{"expected_sequence", expected_sequence}});
+            break;
+        }
+        std::memmove(in.data(), in.data() + used, have - used);
+        have -= used;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    httplib::detail::close_socket(connection.socket);
+    connection.socket = INVALID_SOCKET;
+    connection.finished = true;
+    metrics_gauge_add(MetricGauge::WIRE_CONNECTIONS, -1);
+}
+
+void OrderGateway::execute(const WireFrame &frame, uint64_t &expected_sequence, uint8_t *out, size_t &out_size)
+{
+    uint64_t sequence = frame.sequence();
+    uint32_t event_id = frame.event_id();
+    auto reject = [&](WireReject reason) {
+        out_size += wire_encode_reject(out + out_size, sequence, event_id, reason);
+    };
+
+    if (sequence != expected_sequence)
+    {
+        reject(WireReject::BAD_SEQUENCE);
+        return;
+    }
+    ++expected_sequence;
+
+    LMSRContract *contract = event_id <= INT_MAX ? find_market(static_cast<int>(event_id)) : nullptr;
+    if (frame.type() == WireType::QUOTE_REQUEST)
+    {
+        if (!contract)
+            reject(WireReject::MARKET_NOT_FOUND);
+        else
+            out_size += wire_encode_quote(out + out_size, sequence, event_id, contract->generate_quote());
+        return;
+    }
+
+    TraceSpan span("wire ORDER");
+    if (!contract || frame.side_byte() > 1)
+    {
+        OrderStatus status = contract ? OrderStatus::INVALID_ORDER : OrderStatus::MARKET_NOT_FOUND;
+        metrics_count_order(status);
+        reject(wire_reject_of(status));
+        return;
+    }
+
+    OrderStatus status;
+    Order order = contract->buy(frame.side(), frame.stake(), &status);
+    if (status == OrderStatus::FILLED)
+        out_size += wire_encode_ack(out + out_size, sequence, order);
+    else
+        reject(wire_reject_of(status));
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "contract.h"
+#include "httplib.h" // socket_t and the platform socket headers
+#include "wire_protocol.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+// TCP listener for the binary order-entry protocol (wire_protocol.h).
+//
+// One thread per connection reads whatever frames have arrived, executes
+// them in order against the same LMSRContract::buy as POST /order, and
+// writes all their replies in one send, so a client that pipelines
+// requests gets its replies in batches.
+class OrderGateway
+{
+    private:
+        struct Connection
+        {
+            socket_t socket;
+            std::thread thread;
+            bool finished = false;
+        };
+
+        std::function<LMSRContract *(int)> find_market;
+        size_t max_connections = 0;
+        socket_t listener = INVALID_SOCKET;
+        std::thread acceptor;
+        std::atomic<bool> running{false};
+
+        std::mutex mutex;
+        std::list<Connection> connections;
+
+        void accept_loop();
+        void serve(Connection &connection);
+        // executes one complete frame and appends its reply to `out`
+        void execute(const WireFrame &frame, uint64_t &expected_sequence, uint8_t *out, size_t &out_size);
+        void reap_finished(); // caller holds mutex
+
+    public:
+        explicit OrderGateway(std::function<LMSRContract *(int)> find_market_);
+        ~OrderGateway();
+        OrderGateway(const OrderGateway &) = delete;
+        OrderGateway &operator=(const OrderGateway &) = delete;
+
+        // false if the port cannot be bound
+        bool start(const std::string &host, int port, size_t max_connections_);
+        void stop(); // closes every connection
+};
@@ -0,0 +1,841 @@
+#include "harness.h"
+#include "connection.h"
+#include "contract.h"
+#include "database.h"
+#include "event_catalog.h"
+#include "hydration.h"
+#include "journal.h"
+#include "json_codec.h"
+#include "lmsr_engine.h"
+#include "logger.h"
+#include "money.h"
+#include "quote_kernel.h"
+#include "quote_stream.h"
+#include "sequencer.h"
+#include "trace.h"
+#include "wire_protocol.h"
+#include "json.hpp"
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+
+// ---------------- fixtures ----------------
+// Inputs come from a fixed-seed generator so every run measures the same work.
+static constexpr double bench_risk_cap = 1e9;  // high enough that buy never hits the cap
+
+struct Inventory
+{
+    std::vector<double> q_yes, q_no;
+};
+
+static Inventory random_inventory(size_t n, double scale)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> u(0.0, scale);
+    Inventory inv;
+    for (size_t i = 0; i < n; ++i)
+    {
+        inv.q_yes.push_back(u(rng));
+        inv.q_no.push_back(u(rng));
+    }
+    return inv;
+}
+
+// a market that has already traded, so prices are away from 0.5
+static LMSRContract traded_market(int id = 1)
+{
+    return LMSRContract(id, "bench", 20000.0, 9000.0, 4000.0, Money::from_micros(6000 * Money::scale));
+}
+
+
+// ---------------- pricing primitives ----------------
+static void bench_cost(BenchState &state)
+{
+    LMSRContract contract = traded_market();
+    Inventory inv = random_inventory(1024, 20000.0);
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            do_not_optimize(contract.cost(inv.q_yes[i & 1023], inv.q_no[i & 1023]));
+    });
+}
+
+static void bench_price(BenchState &state)
+{
+    LMSRContract contract = traded_market();
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            do_not_optimize(contract.price((i & 1) ? Side::YES : Side::NO));
+    });
+}
+
+static void bench_max_stake(BenchState &state)
+{
+    LMSRContract contract = traded_market();
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            do_not_optimize(contract);
+            do_not_optimize(contract.max_stake());
+        }
+    });
+}
+
+static void bench_solve_delta_q(BenchState &state)
+{
+    LMSRContract contract = traded_market();
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            do_not_optimize(contract.solve_delta_q((i & 1) ? Side::YES : Side::NO, 1.0 + double(i & 1023)));
+    });
+}
+
+static void bench_generate_quote(BenchState &state)
+{
+    LMSRContract contract = traded_market();
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            do_not_optimize(contract.generate_quote());
+    });
+}
+
+
+// ---------------- N-outcome engine ----------------
+// every outcome's price for one N-outcome market: the fixed-N and runtime-N
+// engines against a scalar std::exp log-sum-exp over the same quantities
+// (items are outcomes)
+enum class PricesPath { FIXED, DYNAMIC, SCALAR };
+
+template <size_t N>
+static typename LmsrEngine<N>::Quantities random_quantities(size_t outcomes)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> u(0.0, 20000.0);
+    typename LmsrEngine<N>::Quantities q{};
+    if constexpr (N == dynamic_outcomes)
+        q.resize(outcomes);
+    for (double &x : q)
+        x = u(rng);
+    return q;
+}
+
+template <size_t N>
+static BenchFunction bench_prices(size_t outcomes, PricesPath path)
+{
+    return [outcomes, path](BenchState &state) {
+        LmsrEngine<N> engine(20000.0, random_quantities<N>(outcomes));
+        std::vector<double> out(outcomes);
+        state.set_items_per_op(outcomes);
+        if (path != PricesPath::SCALAR)
+        {
+            state.measure([&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i)
+                {
+                    do_not_optimize(engine);
+                    engine.prices(out.data());
+                    do_not_optimize(out.data());
+                }
+            });
+            return;
+        }
+
+        const auto &q = engine.quantities();
+        const double b = engine.liquidity();
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                do_not_optimize(engine);
+                double m = q[0];
+                for (size_t k = 1; k < outcomes; ++k)
+                    m = std::max(m, q[k]);
+                double sum = 0.0;
+                for (size_t k = 0; k < outcomes; ++k)
+                    sum += (out[k] = std::exp((q[k] - m) / b));
+                for (size_t k = 0; k < outcomes; ++k)
+                    out[k] /= sum;
+                do_not_optimize(out.data());
+            }
+        });
+    };
+}
+
+template <size_t N>
+static BenchFunction bench_n_cost(size_t outcomes)
+{
+    return [outcomes](BenchState &state) {
+        LmsrEngine<N> engine(20000.0, random_quantities<N>(outcomes));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                do_not_optimize(engine);
+                do_not_optimize(engine.cost());
+            }
+        });
+    };
+}
+
+// ---------------- order execution ----------------
+// alternating small YES/NO stakes keep the market near the middle however
+// many iterations the calibration picks
+static void run_buys(BenchState &state, LMSRContract &contract)
+{
+    state.measure([&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            do_not_optimize(contract.buy((i & 1) ? Side::YES : Side::NO, Money::from_micros(10 * Money::scale)));
+    });
+}
+
+static void bench_buy_no_persist(BenchState &state)
+{
+    JournalConfig config;
+    config.durability = Durability::NONE;
+    order_journal().start(config);
+
+    LMSRContract contract(1, "bench", bench_risk_cap);
+    run_buys(state, contract);
+
+    order_journal().start(JournalConfig{});
+}
+
+static void bench_buy_sync(BenchState &state)
+{
+    TempDatabase db;
+    if (!db.ok())
+        return;
+    int id = new_event("bench", "Bench", "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+    if (id < 0)
+        return;
+
+    order_journal().start(JournalConfig{}); // SYNC: one commit per order
+    LMSRContract contract(id, "bench", bench_risk_cap);
+    run_buys(state, contract);
+}
+
+
+// ---------------- storage engines ----------------
+// buy() persisting to SQLite or to the binlog (items are orders). SYNC
+// confirms each order on disk; ASYNC measures throughput, waiting at the end
+// of each run until the fills are committed (and, for the binlog, fed to
+// SQLite).
+static BenchFunction bench_buy_storage(StorageEngine storage, Durability durability)
+{
+    return [storage, durability](BenchState &state) {
+        TempDatabase db;
+        if (!db.ok())
+            return;
+        int id = new_event("bench", "Bench", "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+        if (id < 0)
+            return;
+
+        JournalConfig config;
+        config.storage = storage;
+        config.durability = durability;
+        config.binlog.directory =
+            (std::filesystem::temp_directory_path() / ("ecb-bench-binlog-" + std::to_string(id))).string();
+        std::filesystem::remove_all(config.binlog.directory);
+        if (!order_journal().start(config))
+            return;
+
+        LMSRContract contract(id, "bench", bench_risk_cap);
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                do_not_optimize(contract.buy((i & 1) ? Side::YES : Side::NO, Money::from_micros(10 * Money::scale)));
+            order_journal().sync();
+        });
+
+        order_journal().start(JournalConfig{});
+        std::filesystem::remove_all(config.binlog.directory);
+    };
+}
+
+
+// ---------------- tracing ----------------
+// cost of one TraceSpan with tracing off, sampling 1 in 64, and recording all
+static BenchFunction bench_trace_span(uint32_t sample_every)
+{
+    return [sample_every](BenchState &state) {
+        if (sample_every > 0)
+            trace_start(sample_every);
+        state.measure([](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                TraceSpan span("bench");
+                do_not_optimize(i);
+            }
+        });
+        trace_stop();
+    };
+}
+
+static void bench_buy_traced(BenchState &state)
+{
+    JournalConfig config;
+    config.durability = Durability::NONE;
+    order_journal().start(config);
+    trace_start(1);
+
+    LMSRContract contract(1, "bench", bench_risk_cap);
+    run_buys(state, contract);
+
+    trace_stop();
+    order_journal().start(JournalConfig{});
+}
+
+
+// ---------------- quote stream ----------------
+// fill-path cost of a connected GET /stream/quotes client: each buy() also
+// queues its quote for the dispatcher, which coalesces them every interval
+static void bench_buy_streamed(BenchState &state)
+{
+    JournalConfig config;
+    config.durability = Durability::NONE;
+    order_journal().start(config);
+    quote_stream().start(QuoteStreamConfig{});
+    std::shared_ptr<QuoteSubscriber> subscriber = quote_stream().subscribe({});
+
+    LMSRContract contract(1, "bench", bench_risk_cap);
+    run_buys(state, contract);
+
+    quote_stream().stop();
+    order_journal().start(JournalConfig{});
+}
+
+
+// ---------------- sequencer ----------------
+// buy() handed to a sequencer thread and back (--execution=sequenced) with
+// one caller: the handoff, with nothing to batch or contend with
+static void bench_buy_sequenced(BenchState &state)
+{
+    JournalConfig config;
+    config.durability = Durability::NONE;
+    order_journal().start(config);
+    SequencerConfig execution;
+    execution.mode = ExecutionMode::SEQUENCED;
+    execution.threads = 1;
+    order_sequencer().start(execution);
+
+    LMSRContract contract(1, "bench", bench_risk_cap);
+    run_buys(state, contract);
+
+    order_sequencer().stop();
+    order_journal().start(JournalConfig{});
+}
+
+// ---------------- order entry ----------------
+// reading one order request: a binary ORDER frame in place, against the
+// nlohmann parse of the equivalent POST /order body
+static void bench_decode_wire(BenchState &state)
+{
+    uint8_t frame[wire_max_frame_size];
+    wire_encode_order(frame, 1, 7, Side::YES, Money::from_micros(12'500'000));
+    state.measure([&frame](uint64_t n) {
+        int64_t total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            do_not_optimize(frame);
+            WireFrame order(frame);
+            if (order.valid_header() && order.type() == WireType::ORDER && order.side_byte() <= 1)
+                total += order.stake().micros() + order.event_id() + (order.side() == Side::YES);
+        }
+        do_not_optimize(total);
+    });
+}
+
+static void bench_decode_json(BenchState &state)
+{
+    const std::string body = R"({"stake": 12.5, "side": "yes"})";
+    state.measure([&body](uint64_t n) {
+        double total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            nlohmann::json j = nlohmann::json::parse(body);
+            total += j["stake"].get<double>() + (j["side"].get<std::string>() == "yes");
+        }
+        do_not_optimize(total);
+    });
+}
+
+static void bench_decode_json_codec(BenchState &state)
+{
+    const std::string body = R"({"stake": 12.5, "side": "yes"})";
+    state.measure([&body](uint64_t n) {
+        double total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            double stake = 0;
+            std::string_view side;
+            if (parse_order_body(body, stake, side) == OrderBodyParse::OK)
+                total += stake + (side == "yes");
+        }
+        do_not_optimize(total);
+    });
+}
+
+
+// ---------------- JSON responses ----------------
+// GET /quote and POST /order response bodies: the nlohmann objects the
+// routes built, against json_codec writing the same bytes
+enum class JsonPath { NLOHMANN, CODEC };
+
+static BenchFunction bench_quote_json(JsonPath path)
+{
+    return [path](BenchState &state) {
+        LMSRContract contract = traded_market();
+        Quote q = contract.generate_quote();
+        state.measure([&q, path](uint64_t n) {
+            size_t total = 0;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                do_not_optimize(q);
+                if (path == JsonPath::CODEC)
+                    total += quote_json(q).size();
+                else
+                    total += nlohmann::json{{"yes_price", round_cents(q.price_yes)},
+                                            {"no_price", round_cents(q.price_no)},
+                                            {"max_stake", static_cast<int>(q.size)}}.dump().size();
+            }
+            do_not_optimize(total);
+        });
+    };
+}
+
+static BenchFunction bench_order_json(JsonPath path)
+{
+    return [path](BenchState &state) {
+        Order o{7, Money::from_double(12.5), Money::from_double(0.6184), Money::from_double(20.213), Side::YES, Money()};
+        state.measure([&o, path](uint64_t n) {
+            size_t total = 0;
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                do_not_optimize(o);
+                if (path == JsonPath::CODEC)
+                    total += order_json(o).size();
+                else
+                    total += nlohmann::json{{"event_id", o.event_id},
+                                            {"side", o.side == Side::YES ? "yes" : "no"},
+                                            {"stake", o.stake.rounded()},
+                                            {"price", o.price.rounded()},
+                                            {"expected_cashout", o.expected_cashout.rounded()}}.dump().size();
+            }
+            do_not_optimize(total);
+        });
+    };
+}
+
+
+// ---------------- event listing ----------------
+// GET /events body for n open markets: the SQLite query + JSON it replaced,
+// the catalog's rebuild after every fill, and the cached body under polling
+enum class EventsSource { SQLITE_JSON, CATALOG_AFTER_FILL, CATALOG_CACHED };
+
+static BenchFunction bench_events(size_t markets, EventsSource mode)
+{
+    return [markets, mode](BenchState &state) {
+        TempDatabase db;
+        if (!db.ok())
+            return;
+        std::vector<std::unique_ptr<LMSRContract>> contracts;
+        EventCatalog catalog;
+        for (size_t m = 0; m < markets; ++m)
+        {
+            std::string tag = "ev" + std::to_string(m);
+            int id = new_event(tag, "Bench event " + std::to_string(m), "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+            if (id < 0)
+                return;
+            contracts.push_back(std::make_unique<LMSRContract>(id, tag, bench_risk_cap));
+            catalog.add(id, tag, "Bench event " + std::to_string(m), "2099-01-01 00:00:00", contracts.back().get());
+        }
+
+        JournalConfig config;
+        config.durability = Durability::NONE; // fills only move the in-memory state
+        order_journal().start(config);
+
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                if (mode == EventsSource::SQLITE_JSON)
+                {
+                    nlohmann::json j;
+                    for (const auto &e : list_all_events(false))
+                        j.push_back({{"id", e.id}, {"tag", e.tag}, {"name", e.name},
+                                     {"liquidity", e.event_funds.rounded()}, {"orders", e.order_count},
+                                     {"maturity", e.maturity}});
+                    std::string body = j.dump();
+                    do_not_optimize(body);
+                    continue;
+                }
+                if (mode == EventsSource::CATALOG_AFTER_FILL)
+                    contracts[i % contracts.size()]->buy((i & 1) ? Side::YES : Side::NO, Money::from_micros(Money::scale));
+                std::string body = catalog.body()->json; // the copy httplib makes
+                do_not_optimize(body);
+            }
+        });
+        order_journal().start(JournalConfig{});
+    };
+}
+
+
+// ---------------- settlement ----------------
+// paying out one event's orders (items are orders): in chunks as the settler
+// does, and in a single transaction. Each operation first clears the payouts
+// of the previous one.
+static BenchFunction bench_settle(int orders, int chunk)
+{
+    return [orders, chunk](BenchState &state) {
+        TempDatabase db;
+        if (!db.ok())
+            return;
+        int id = new_event("bench", "Bench", "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+        DbConnection *conn = db_connection();
+        std::string fill =
+            "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(orders) + ") "
+            "INSERT INTO order_book (event_id, side, stake, expected_cashout, price) "
+            "SELECT " + std::to_string(id) + ", x % 2, 10.0, 19.5, 0.51 FROM n;";
+        if (id < 0 || !conn || !conn->exec(fill.c_str()) || !begin_settlement(id, true))
+            return;
+
+        state.set_items_per_op(double(orders));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                conn->exec("UPDATE order_book SET pay_out = NULL;");
+                Settlement progress;
+                progress.event_id = id;
+                progress.outcome = true;
+                while (settle_order_chunk(progress, chunk) > 0)
+                    ;
+                do_not_optimize(progress.total_payout);
+            }
+        });
+    };
+}
+
+
+// ---------------- order history growth ----------------
+// reading one event's 1000 orders out of an order book of `total` rows
+// spread over 100 other events; with the order_book_event index the cost
+// depends on the event, not on the history. `indexed = false` drops the
+// index to show the full scan it replaced.
+static BenchFunction bench_event_orders(int64_t total, bool indexed)
+{
+    return [total, indexed](BenchState &state) {
+        TempDatabase db;
+        if (!db.ok())
+            return;
+        int id = new_event("bench", "Bench", "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+        for (int e = 0; e < 100; ++e)
+            new_event("other" + std::to_string(e), "Other", "2099-01-01 00:00:00", Money::from_double(bench_risk_cap));
+
+        // the event's orders are interleaved through the whole history
+        int64_t every = total / 1000;
+        std::string fill =
+            "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(total) + ") "
+            "INSERT INTO order_book (event_id, side, stake, expected_cashout, price) "
+            "SELECT CASE WHEN x % " + std::to_string(every) + " = 0 THEN " + std::to_string(id) +
+            " ELSE " + std::to_string(id + 1) + " + x % 100 END, x % 2, 10.0, 19.5, 0.51 FROM n;";
+        DbConnection *conn = db_connection();
+        if (id < 0 || !conn || !conn->exec(fill.c_str()))
+            return;
+        if (!indexed && !conn->exec("DROP INDEX order_book_event;"))
+            return;
+
+        state.set_items_per_op(1000.0);
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                do_not_optimize(list_event_orders(id));
+        });
+    };
+}
+
+
+// ---------------- startup ----------------
+// reopening `events` open markets (items are markets), each run into a fresh
+// registry and catalog. The time until the service is ready: the serial
+// full-row load that also listed every event, numeric hydration on 1 and on
+// all hardware threads, and lazy mode's id scan. `LISTING` is the GET /events
+// metadata load that now runs after ready (without the JSON build).
+enum class StartupPath { SERIAL_FULL_ROWS, HYDRATE, LAZY, LISTING };
+
+static BenchFunction bench_startup(int events, StartupPath path, size_t threads = 0)
+{
+    return [events, path, threads](BenchState &state) {
+        TempDatabase db;
+        if (!db.ok())
+            return;
+        std::string fill =
+            "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM n WHERE x < " + std::to_string(events) + ") "
+            "INSERT INTO events (tag, name, risk_cap, q_yes, q_no, event_funds, order_count, maturity) "
+            "SELECT 'ev' || x, 'Synthetic event number ' || x, 10000, x % 97, x % 89, x % 1000, x % 50, "
+            "'2099-01-01 00:00:00' FROM n;";
+        DbConnection *conn = db_connection();
+        if (!conn || !conn->exec(fill.c_str()))
+            return;
+
+        state.set_items_per_op(double(events));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                MarketRegistry markets;
+                EventCatalog catalog;
+                if (path == StartupPath::SERIAL_FULL_ROWS)
+                {
+                    for (const Event &e : list_all_events(false))
+                    {
+                        auto contract = std::make_unique<LMSRContract>(e.id, e.name, e.risk_cap.to_double(), e.q_yes, e.q_no,
+                                                                       e.event_funds, e.order_count, e.aggregates);
+                        const LMSRContract *listed = contract.get();
+                        if (markets.insert(std::move(contract)))
+                            catalog.add(e.id, e.tag, e.name, e.maturity, listed);
+                    }
+                    do_not_optimize(markets.size());
+                    continue;
+                }
+
+                if (path == StartupPath::LISTING)
+                {
+                    for (const EventListing &e : list_event_listings())
+                        catalog.add(e.id, e.tag, e.name, e.maturity, nullptr);
+                    continue;
+                }
+
+                MarketHydrator hydrator(markets);
+                hydrator.start(HydrationConfig{path == StartupPath::LAZY ? HydrationMode::LAZY : HydrationMode::EAGER,
+                                               threads});
+                do_not_optimize(markets.size() + hydrator.pending());
+            }
+        });
+    };
+}
+
+
+// ---------------- logging ----------------
+// an order-fill record with four fields; the writer drains to /dev/null
+static void bench_log_record(BenchState &state)
+{
+    LogConfig config;
+    config.file = "/dev/null";
+    if (!logger_start(config))
+        return;
+    state.measure([](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            log_info("Order added successfully", {{"event_id", 1}, {"stake", 10.0 + double(i & 7)},
+                                                  {"cashout", 19.96}, {"side", (i & 1) ? "YES" : "NO"}});
+    });
+    logger_stop();
+}
+
+static void bench_log_filtered(BenchState &state)
+{
+    LogConfig config;
+    config.level = LogLevel::WARN;
+    config.file = "/dev/null";
+    if (!logger_start(config))
+        return;
+    state.measure([](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i)
+            log_info("Order added successfully", {{"event_id", 1}, {"stake", 10.0}});
+    });
+    logger_stop();
+}
+
+
+// ---------------- money ----------------
+// one amount to its two-decimal text: Money's integer formatter against the
+// old double path (pow-based round_figure, then an ostringstream)
+static void bench_money_format(BenchState &state)
+{
+    state.measure([](uint64_t n) {
+        char buffer[money_chars];
+        size_t total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+            total += format_money(Money::from_micros(123'456'789 + int64_t(i & 1023)), buffer);
+        do_not_optimize(total);
+    });
+}
+
+static void bench_double_format(BenchState &state)
+{
+    state.measure([](uint64_t n) {
+        size_t total = 0;
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            double value = 123.456789 + double(i & 1023) * 1e-6;
+            double factor = std::pow(10.0, 2);
+            std::ostringstream os;
+            os << std::round(value * factor) / factor;
+            total += os.str().size();
+        }
+        do_not_optimize(total);
+    });
+}
+
+
+// ---------------- bulk quoting ----------------
+// SIMD kernel over a QuoteBook against the per-market alternatives for the
+// same set of markets; GET /quotes reads the published quotes
+// (generate_quote_loop)
+struct MarketSet
+{
+    std::vector<std::unique_ptr<LMSRContract>> contracts;
+    QuoteBook book;
+};
+
+static MarketSet random_markets(size_t n)
+{
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    MarketSet set;
+    set.book.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        double cap = 10000.0 + u(rng) * 1e6;
+        double q_yes = u(rng) * cap * 1.2;
+        double q_no = u(rng) * cap * 1.2;
+        set.contracts.push_back(std::make_unique<LMSRContract>(int(i), "bench", cap, q_yes, q_no));
+        set.book.push(int(i), q_yes, q_no, set.contracts.back()->liquidity_param(), cap);
+    }
+    return set;
+}
+
+static BenchFunction bench_quote_kernel(size_t markets)
+{
+    return [markets](BenchState &state) {
+        MarketSet set = random_markets(markets);
+        QuoteColumns columns;
+        state.set_items_per_op(double(markets));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                price_markets(set.book, columns);
+                do_not_optimize(columns.size.data());
+            }
+        });
+    };
+}
+
+// includes gathering the snapshots into the QuoteBook first
+static BenchFunction bench_quote_kernel_gather(size_t markets)
+{
+    return [markets](BenchState &state) {
+        MarketSet set = random_markets(markets);
+        QuoteBook book;
+        QuoteColumns columns;
+        state.set_items_per_op(double(markets));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                book.clear();
+                for (const auto &c : set.contracts)
+                {
+                    MarketSnapshot s = c->snapshot();
+                    book.push(c->contract_id, s.q_T, s.q_F, c->liquidity_param(), c->risk_limit());
+                }
+                price_markets(book, columns);
+                do_not_optimize(columns.size.data());
+            }
+        });
+    };
+}
+
+static BenchFunction bench_quote_generate_loop(size_t markets)
+{
+    return [markets](BenchState &state) {
+        MarketSet set = random_markets(markets);
+        state.set_items_per_op(double(markets));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                for (const auto &c : set.contracts)
+                    do_not_optimize(c->generate_quote());
+        });
+    };
+}
+
+// what generate_quote computed per call before quotes were published
+static BenchFunction bench_quote_scalar_loop(size_t markets)
+{
+    return [markets](BenchState &state) {
+        MarketSet set = random_markets(markets);
+        state.set_items_per_op(double(markets));
+        state.measure([&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i)
+                for (const auto &c : set.contracts)
+                {
+                    do_not_optimize(c->price(Side::YES));
+                    do_not_optimize(c->price(Side::NO));
+                    do_not_optimize(c->max_stake());
+                }
+        });
+    };
+}
+
+
+static const bool registered = register_bench_cases({
+    {"lmsr/cost", bench_cost},
+    {"lmsr/price", bench_price},
+    {"lmsr/max_stake", bench_max_stake},
+    {"lmsr/solve_delta_q", bench_solve_delta_q},
+    {"lmsr/generate_quote", bench_generate_quote},
+    {"lmsr/outcomes/prices/fixed_2", bench_prices<2>(2, PricesPath::FIXED)},
+    {"lmsr/outcomes/prices/fixed_8", bench_prices<8>(8, PricesPath::FIXED)},
+    {"lmsr/outcomes/prices/dynamic_8", bench_prices<dynamic_outcomes>(8, PricesPath::DYNAMIC)},
+    {"lmsr/outcomes/prices/scalar_8", bench_prices<dynamic_outcomes>(8, PricesPath::SCALAR)},
+    {"lmsr/outcomes/prices/dynamic_64", bench_prices<dynamic_outcomes>(64, PricesPath::DYNAMIC)},
+    {"lmsr/outcomes/prices/scalar_64", bench_prices<dynamic_outcomes>(64, PricesPath::SCALAR)},
+    {"lmsr/outcomes/prices/dynamic_1k", bench_prices<dynamic_outcomes>(1024, PricesPath::DYNAMIC)},
+    {"lmsr/outcomes/prices/scalar_1k", bench_prices<dynamic_outcomes>(1024, PricesPath::SCALAR)},
+    {"lmsr/outcomes/cost/fixed_2", bench_n_cost<2>(2)},
+    {"lmsr/outcomes/cost/fixed_8", bench_n_cost<8>(8)},
+    {"lmsr/outcomes/cost/dynamic_64", bench_n_cost<dynamic_outcomes>(64)},
+    {"lmsr/buy/no_persist", bench_buy_no_persist},
+    {"lmsr/buy/sync_sqlite", bench_buy_sync},
+    {"lmsr/buy/no_persist/traced", bench_buy_traced},
+    {"lmsr/buy/no_persist/streamed", bench_buy_streamed},
+    {"lmsr/buy/no_persist/sequenced", bench_buy_sequenced},
+    {"storage/buy/sync/sqlite", bench_buy_storage(StorageEngine::SQLITE, Durability::SYNC)},
+    {"storage/buy/sync/binlog", bench_buy_storage(StorageEngine::BINLOG, Durability::SYNC)},
+    {"storage/buy/async/sqlite", bench_buy_storage(StorageEngine::SQLITE, Durability::ASYNC)},
+    {"storage/buy/async/binlog", bench_buy_storage(StorageEngine::BINLOG, Durability::ASYNC)},
+    {"order_entry/decode/wire", bench_decode_wire},
+    {"order_entry/decode/json", bench_decode_json},
+    {"order_entry/decode/json_codec", bench_decode_json_codec},
+    {"json/quote/nlohmann", bench_quote_json(JsonPath::NLOHMANN)},
+    {"json/quote/codec", bench_quote_json(JsonPath::CODEC)},
+    {"json/order/nlohmann", bench_order_json(JsonPath::NLOHMANN)},
+    {"json/order/codec", bench_order_json(JsonPath::CODEC)},
+    {"events/sqlite_json/1k", bench_events(1000, EventsSource::SQLITE_JSON)},
+    {"events/catalog_after_fill/1k", bench_events(1000, EventsSource::CATALOG_AFTER_FILL)},
+    {"events/catalog_cached/1k", bench_events(1000, EventsSource::CATALOG_CACHED)},
+    {"settle/chunk_2000/20k", bench_settle(20000, 2000)},
+    {"settle/single_txn/20k", bench_settle(20000, 20000)},
+    {"orders/event_1k_of/100k", bench_event_orders(100'000, true)},
+    {"orders/event_1k_of/1m", bench_event_orders(1'000'000, true)},
+    {"orders/event_1k_of/10m", bench_event_orders(10'000'000, true)},
+    {"orders/event_1k_of/1m/no_index", bench_event_orders(1'000'000, false)},
+    {"startup/serial_full_rows/100k", bench_startup(100'000, StartupPath::SERIAL_FULL_ROWS)},
+    {"startup/hydrate/100k/1_thread", bench_startup(100'000, StartupPath::HYDRATE, 1)},
+    {"startup/hydrate/100k", bench_startup(100'000, StartupPath::HYDRATE)},
+    {"startup/lazy/100k", bench_startup(100'000, StartupPath::LAZY)},
+    {"startup/listing/100k", bench_startup(100'000, StartupPath::LISTING)},
+    {"log/record", bench_log_record},
+    {"log/below_level", bench_log_filtered},
+    {"money/format", bench_money_format},
+    {"money/format_double", bench_double_format},
+    {"trace/span/off", bench_trace_span(0)},
+    {"trace/span/sample_64", bench_trace_span(64)},
+    {"trace/span/all", bench_trace_span(1)},
+    {"quotes/kernel/1k", bench_quote_kernel(1000)},
+    {"quotes/kernel/10k", bench_quote_kernel(10000)},
+    {"quotes/kernel/100k", bench_quote_kernel(100000)},
+    {"quotes/kernel_gather/1k", bench_quote_kernel_gather(1000)},
+    {"quotes/kernel_gather/10k", bench_quote_kernel_gather(10000)},
+    {"quotes/kernel_gather/100k", bench_quote_kernel_gather(100000)},
+    {"quotes/generate_quote_loop/1k", bench_quote_generate_loop(1000)},
+    {"quotes/generate_quote_loop/10k", bench_quote_generate_loop(10000)},
+    {"quotes/generate_quote_loop/100k", bench_quote_generate_loop(100000)},
+    {"quotes/scalar_loop/1k", bench_quote_scalar_loop(1000)},
+    {"quotes/scalar_loop/10k", bench_quote_scalar_loop(10000)},
+    {"quotes/scalar_loop/100k", bench_quote_scalar_loop(100000)},
+});
@@ -0,0 +1,271 @@
+#include "harness.h"
+#include "connection.h"
+#include "database.h"
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <streambuf>
+
+
+// ---------------- allocation counting ----------------
+static std::atomic<uint64_t> alloc_count{0};
+static std::atomic<uint64_t> alloc_bytes{0};
+
+static void *counted_alloc(std::size_t size)
+{
+    alloc_count.fetch_add(1, std::memory_order_relaxed);
+    alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) { return counted_alloc(size); }
+void *operator new[](std::size_t size) { return counted_alloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+
+// ---------------- registry ----------------
+static std::vector<BenchCase> &bench_cases()
+{
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+bool register_bench_cases(std::vector<BenchCase> cases)
+{
+    for (auto &c : cases)
+        bench_cases().push_back(std::move(c));
+    return true;
+}
+
+
+// ---------------- measurement ----------------
+// engine code reports through std::cout; keep it out of the timings' output
+class NullBuffer : public std::streambuf
+{
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+static double elapsed_ns(const std::function<void(uint64_t)> &body, uint64_t n)
+{
+    auto start = std::chrono::steady_clock::now();
+    body(n);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+void BenchState::measure(const std::function<void(uint64_t n)> &body)
+{
+    if (measured)
+        return;
+    measured = true;
+
+    // calibrate (doubles as warm-up): grow n until one run takes min_time
+    const double min_ns = config.min_time_ms * 1e6;
+    uint64_t n = 1;
+    while (true)
+    {
+        double ns = elapsed_ns(body, n);
+        if (ns >= min_ns || n >= (uint64_t(1) << 40))
+            break;
+        double scale = ns > 0 ? 1.2 * min_ns / ns : 100.0;
+        scale = std::min(std::max(scale, 2.0), 100.0);
+        n = static_cast<uint64_t>(static_cast<double>(n) * scale);
+    }
+
+    std::vector<double> per_op;
+    per_op.reserve(config.repetitions); // keep the harness out of the count
+    uint64_t allocs_before = alloc_count.load(std::memory_order_relaxed);
+    uint64_t bytes_before = alloc_bytes.load(std::memory_order_relaxed);
+    for (int r = 0; r < config.repetitions; ++r)
+        per_op.push_back(elapsed_ns(body, n) / static_cast<double>(n));
+    uint64_t ops = n * static_cast<uint64_t>(config.repetitions);
+
+    std::sort(per_op.begin(), per_op.end());
+    result.iterations = n;
+    result.repetitions = config.repetitions;
+    result.ns_per_op = per_op[per_op.size() / 2];
+    result.ns_per_op_min = per_op.front();
+    result.ns_per_op_max = per_op.back();
+    result.allocs_per_op = static_cast<double>(alloc_count.load(std::memory_order_relaxed) - allocs_before) / ops;
+    result.bytes_per_op = static_cast<double>(alloc_bytes.load(std::memory_order_relaxed) - bytes_before) / ops;
+}
+
+
+// ---------------- reporting ----------------
+static nlohmann::json to_json(const BenchResult &r)
+{
+    nlohmann::json j{
+        {"name", r.name},
+        {"iterations", r.iterations},
+        {"repetitions", r.repetitions},
+        {"ns_per_op", r.ns_per_op},
+        {"ns_per_op_min", r.ns_per_op_min},
+        {"ns_per_op_max", r.ns_per_op_max},
+        {"allocs_per_op", r.allocs_per_op},
+        {"bytes_per_op", r.bytes_per_op}
+    };
+    if (r.items_per_op != 1)
+    {
+        j["items_per_op"] = r.items_per_op;
+        j["items_per_second"] = r.items_per_op * 1e9 / r.ns_per_op;
+    }
+    return j;
+}
+
+static std::map<std::string, double> load_baseline(const std::string &path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Cannot read baseline '" << path << "'\n";
+        return baseline;
+    }
+    try
+    {
+        nlohmann::json j = nlohmann::json::parse(in);
+        for (const auto &b : j.at("benchmarks"))
+            baseline[b.at("name").get<std::string>()] = b.at("ns_per_op").get<double>();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Invalid baseline '" << path << "': " << e.what() << "\n";
+    }
+    return baseline;
+}
+
+static void print_header(bool with_baseline)
+{
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(14) << "ns/op" << std::setw(12) << "min" << std::setw(12) << "max"
+              << std::setw(11) << "allocs/op" << std::setw(14) << "items/s";
+    if (with_baseline)
+        std::cout << std::setw(10) << "vs base";
+    std::cout << "\n" << std::string(with_baseline ? 109 : 99, '-') << "\n";
+}
+
+static void print_row(const BenchResult &r, const std::map<std::string, double> &baseline, bool with_baseline)
+{
+    std::cout << std::left << std::setw(36) << r.name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(14) << r.ns_per_op
+              << std::setw(12) << r.ns_per_op_min << std::setw(12) << r.ns_per_op_max
+              << std::setprecision(2) << std::setw(11) << r.allocs_per_op;
+    if (r.items_per_op != 1)
+        std::cout << std::setprecision(0) << std::setw(14) << r.items_per_op * 1e9 / r.ns_per_op;
+    else
+        std::cout << std::setw(14) << "-";
+    if (with_baseline)
+    {
+        auto it = baseline.find(r.name);
+        if (it != baseline.end() && it->second > 0)
+            std::cout << std::showpos << std::setprecision(1) << std::setw(9)
+                      << (r.ns_per_op / it->second - 1.0) * 100.0 << "%" << std::noshowpos;
+        else
+            std::cout << std::setw(10) << "new";
+    }
+    std::cout << "\n";
+}
+
+int run_benchmarks(const BenchConfig &config)
+{
+    std::map<std::string, double> baseline;
+    bool with_baseline = !config.baseline_path.empty();
+    if (with_baseline)
+        baseline = load_baseline(config.baseline_path);
+
+    std::vector<BenchResult> results;
+    NullBuffer null_buffer;
+    print_header(with_baseline);
+
+    for (const auto &c : bench_cases())
+    {
+        if (!config.filter.empty() && c.name.find(config.filter) == std::string::npos)
+            continue;
+
+        BenchResult result;
+        result.name = c.name;
+        BenchState state(config, result);
+
+        std::streambuf *console = std::cout.rdbuf(&null_buffer);
+        c.run(state);
+        std::cout.rdbuf(console);
+
+        if (result.iterations == 0)
+        {
+            std::cerr << c.name << ": skipped (setup failed)\n";
+            continue;
+        }
+        print_row(result, baseline, with_baseline);
+        results.push_back(result);
+    }
+
+    if (!config.json_path.empty())
+    {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        nlohmann::json j;
+        j["context"] = {
+            {"date", date},
+#if defined(__VERSION__)
+            {"compiler", __VERSION__},
+#endif
+            {"repetitions", config.repetitions},
+            {"min_time_ms", config.min_time_ms}
+        };
+        j["benchmarks"] = nlohmann::json::array();
+        for (const auto &r : results)
+            j["benchmarks"].push_back(to_json(r));
+
+        std::ofstream out(config.json_path);
+        if (!out)
+        {
+            std::cerr << "Cannot write '" << config.json_path << "'\n";
+            return 1;
+        }
+        out << j.dump(2) << "\n";
+        std::cout << "\nResults written to " << config.json_path << "\n";
+    }
+    return 0;
+}
+
+
+// ---------------- temporary database ----------------
+TempDatabase::TempDatabase() : previous_path(database_path)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "ecb-bench-%lld.db",
+                  static_cast<long long>(std::chrono::steady_clock::now().time_since_epoch().count()));
+    path = (std::filesystem::temp_directory_path() / name).string();
+
+    database_path = path.c_str();
+    ready = initialize_database() == 0;
+}
+
+TempDatabase::~TempDatabase()
+{
+    if (DbConnection *conn = db_connection())
+        conn->close();
+    database_path = previous_path;
+
+    for (const char *suffix : {"", "-wal", "-shm"})
+            std::remove((path + suffix).c_str());
+}
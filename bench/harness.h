@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Minimal microbenchmark harness for the engine (built by `./build.sh bench`).
+//
+// A case does its setup, then hands a body to BenchState::measure(). The body
+// gets an operation count and must perform exactly that many operations; only
+// the body is timed. The runner grows the count until one run lasts at least
+// --min-time-ms, then repeats it --repetitions times and reports the median.
+// Allocations are counted by a replaced global operator new, so allocs/op
+// includes any background thread (e.g. the journal writer) active meanwhile.
+
+struct BenchConfig
+{
+    std::string filter;         // run only cases whose name contains this
+    int repetitions = 5;
+    double min_time_ms = 100.0; // per repetition
+    std::string json_path;      // machine-readable results, if set
+    std::string baseline_path;  // earlier --json output to compare against
+};
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t iterations = 0;   // operations per repetition
+    int repetitions = 0;
+    double ns_per_op = 0;      // median over repetitions
+    double ns_per_op_min = 0;
+    double ns_per_op_max = 0;
+    double allocs_per_op = 0;
+    double bytes_per_op = 0;
+    double items_per_op = 1;   // e.g. markets quoted per operation
+};
+
+class BenchState
+{
+    private:
+        const BenchConfig &config;
+        BenchResult &result;
+        bool measured = false;
+
+    public:
+        BenchState(const BenchConfig &config_, BenchResult &result_) : config(config_), result(result_) {}
+
+        // times body(n); may be called once per case
+        void measure(const std::function<void(uint64_t n)> &body);
+
+        // for batch operations: how many items one operation handles
+        void set_items_per_op(double items) { result.items_per_op = items; }
+};
+
+using BenchFunction = std::function<void(BenchState &)>;
+
+struct BenchCase
+{
+    std::string name;
+    BenchFunction run;
+};
+
+// called from a static initialiser in each *_bench.cpp
+bool register_bench_cases(std::vector<BenchCase> cases);
+
+int run_benchmarks(const BenchConfig &config);
+
+
+// keeps the optimiser from discarding a computed value
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+// Points database_path at a fresh temporary SQLite file for the lifetime of
+// the object and deletes it (with its WAL files) afterwards.
+class TempDatabase
+{
+    private:
+        std::string path;
+        const char *previous_path;
+        bool ready = false;
+
+    public:
+        TempDatabase();
+        ~TempDatabase();
+        TempDatabase(const TempDatabase &) = delete;
+        TempDatabase &operator=(const TempDatabase &) = delete;
+
+        bool ok() const { return ready; }
+};
@@ -0,0 +1,47 @@
+#include "harness.h"
+#include "utils.h"
+#include <iostream>
+#include <string>
+
+
+static void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --filter=TEXT         run only benchmarks whose name contains TEXT\n"
+              << "  --repetitions=N       timed runs per benchmark, median reported (default 5)\n"
+              << "  --min-time-ms=M       minimum duration of one run (default 100)\n"
+              << "  --json=FILE           write results as JSON\n"
+              << "  --baseline=FILE       compare against an earlier --json file\n"
+              << "  --help                show this message\n";
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--filter")
+            config.filter = value;
+        else if (key == "--repetitions" && is_integer(value) && std::stoi(value) > 0)
+            config.repetitions = std::stoi(value);
+        else if (key == "--min-time-ms" && is_positive_number(value))
+            config.min_time_ms = std::stod(value);
+        else if (key == "--json" && !value.empty())
+            config.json_path = value;
+        else if (key == "--baseline" && !value.empty())
+            config.baseline_path = value;
+        else
+        {
+            print_usage(argv[0]);
+            return key == "--help" ? 0 : 1;
+        }
+    }
+
+    return run_benchmarks(config);
+}
@@ -2,6 +2,15 @@
 
 set -e
 
+# Target: "app" (default) builds and runs the bot, "bench" builds and runs
+# the microbenchmarks, "check" the correctness checks (non-zero exit on a
+# failure), "loadgen" the HTTP load generator. Remaining arguments are
+# passed to the program.
+TARGET="app"
+case "$1" in
+  app|bench|check|loadgen) TARGET="$1"; shift ;;
+esac
+
 # Determine OS (Linux vs Windows-like)
 case "$OSTYPE" in
   linux*)   OS="linux" ;;
@@ -17,20 +26,35 @@ echo "Detected OS: $OS"
 BUILD_DIR="build"
 mkdir -p "$BUILD_DIR"
 
-# Select output name
-if [ "$OS" = "windows" ]; then
-    OUTPUT="$BUILD_DIR/event-contract-bot.exe"
+ROOT_DIR=$(dirname "$0")
+
+# Select output name and sources
+if [ "$TARGET" = "bench" ]; then
+    OUTPUT="$BUILD_DIR/bench"
+    CPP_SRC="$ROOT_DIR/bench/*.cpp $ROOT_DIR/src/*.cpp"
+    RUN_ARGS="--json=$BUILD_DIR/bench.json"
+elif [ "$TARGET" = "check" ]; then
+    OUTPUT="$BUILD_DIR/check"
+    CPP_SRC="$ROOT_DIR/check/*.cpp $ROOT_DIR/src/*.cpp"
+    RUN_ARGS=""
+elif [ "$TARGET" = "loadgen" ]; then
+    OUTPUT="$BUILD_DIR/loadgen"
+    CPP_SRC="$ROOT_DIR/loadgen/*.cpp $ROOT_DIR/client/*.cpp $ROOT_DIR/app/console.cpp $ROOT_DIR/app/options.cpp $ROOT_DIR/app/order_gateway.cpp $ROOT_DIR/src/*.cpp"
+    RUN_ARGS=""
 else
     OUTPUT="$BUILD_DIR/event-contract-bot"
+    CPP_SRC="$ROOT_DIR/app/*.cpp $ROOT_DIR/src/*.cpp"
+    RUN_ARGS=""
+fi
+if [ "$OS" = "windows" ]; then
+    OUTPUT="$OUTPUT.exe"
 fi
-
-ROOT_DIR=$(dirname "$0")
 
 # Paths
-CPP_SRC="$ROOT_DIR/app/*.cpp $ROOT_DIR/src/*.cpp"
 C_SRC="$ROOT_DIR/vendor/sqlite/sqlite3.c"
 OBJ="$BUILD_DIR/sqlite3.o"
-INCLUDE_DIRS="-I./src -I./vendor/sqlite -I./vendor/httplib -I./vendor/json"
+INCLUDE_DIRS="-I./src -I./app -I./client -I./vendor/sqlite -I./vendor/httplib -I./vendor/json"
+OPT_FLAGS="-O2"
 
 # Select compilers and platform libs
 if [ "$OS" = "windows" ]; then
@@ -57,7 +81,7 @@ fi
 
 # Compile + link
 echo "Compiling C++ sources..."
-$CPP_COMPILER $CPP_SRC -o "$OUTPUT" $OBJ -std=c++17 \
+$CPP_COMPILER $CPP_SRC -o "$OUTPUT" $OBJ -std=c++17 $OPT_FLAGS \
     $INCLUDE_DIRS $PLATFORM_DEFS $PLATFORM_LIBS -pthread
 
 echo "Build successful."
@@ -66,7 +90,5 @@ echo "Build successful."
 echo "Running: $OUTPUT"
 if [ "$OS" = "windows" ]; then
     chmod +x "$OUTPUT"  # ensure Git Bash can run it
-    "$OUTPUT"
-else
-    "$OUTPUT"
 fi
+"$OUTPUT" $RUN_ARGS "$@"
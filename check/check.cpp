@@ -0,0 +1,64 @@
+#include "check.h"
+#include <iostream>
+
+
+static constexpr int max_printed_failures = 5; // per case
+
+
+void CheckState::expect(bool ok, const std::string &what)
+{
+    if (ok)
+        return;
+    if (++failures <= max_printed_failures)
+        std::cout << "  FAILED: " << what << "\n";
+    else if (failures == max_printed_failures + 1)
+        std::cout << "  (further failures of " << name << " not shown)\n";
+}
+
+void CheckState::note(const std::string &line) const
+{
+    std::cout << "  " << line << "\n";
+}
+
+
+// ---------------- registry ----------------
+static std::vector<CheckCase> &check_cases()
+{
+    static std::vector<CheckCase> cases;
+    return cases;
+}
+
+bool register_check_cases(std::vector<CheckCase> cases)
+{
+    for (auto &c : cases)
+        check_cases().push_back(std::move(c));
+    return true;
+}
+
+
+// ---------------- runner ----------------
+int run_checks(const CheckConfig &config)
+{
+    int run = 0, failed = 0;
+    for (const auto &c : check_cases())
+    {
+        if (!config.filter.empty() && c.name.find(config.filter) == std::string::npos)
+            continue;
+
+        std::cout << c.name << "\n";
+        CheckState state(c.name);
+        c.run(state);
+        std::cout << (state.passed() ? "  ok\n" : "  FAIL\n");
+        ++run;
+        if (!state.passed())
+            ++failed;
+    }
+
+    if (run == 0)
+    {
+        std::cout << "No checks match '" << config.filter << "'\n";
+        return 1;
+    }
+    std::cout << "\n" << run - failed << " of " << run << " checks passed\n";
+    return failed == 0 ? 0 : 1;
+}
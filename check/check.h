@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// Minimal correctness checks for the engine (built by `./build.sh check`).
+//
+// Each case runs to completion and reports through its CheckState: a failed
+// expectation marks the case failed (the first few are printed), and note()
+// prints a line of measurements, e.g. the worst error seen against a bound.
+// The program exits non-zero if any case failed, so it can gate a build.
+
+struct CheckConfig
+{
+    std::string filter; // run only cases whose name contains this
+};
+
+class CheckState
+{
+    private:
+        std::string name;
+        int failures = 0;
+
+    public:
+        explicit CheckState(const std::string &name_) : name(name_) {}
+
+        // fails the case unless `ok`; `what` says what was expected
+        void expect(bool ok, const std::string &what);
+        void note(const std::string &line) const;
+
+        bool passed() const { return failures == 0; }
+};
+
+using CheckFunction = std::function<void(CheckState &)>;
+
+struct CheckCase
+{
+    std::string name;
+    CheckFunction run;
+};
+
+// called from a static initialiser in each *_check.cpp
+bool register_check_cases(std::vector<CheckCase> cases);
+
+int run_checks(const CheckConfig &config);
@@ -0,0 +1,115 @@
+#include "check.h"
+#include "json_codec.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// ---------------- allocation counting ----------------
+// Replaces the global operator new for the whole check program; only
+// allocations made by the counting thread while a codec call runs matter.
+static thread_local bool counting = false;
+static thread_local uint64_t counted = 0;
+
+static void *check_alloc(std::size_t size)
+{
+    if (counting)
+        ++counted;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) { return check_alloc(size); }
+void *operator new[](std::size_t size) { return check_alloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+// allocations made by call(); the inputs are built before it starts
+template <typename F>
+static uint64_t allocations(F &&call)
+{
+    counted = 0;
+    counting = true;
+    call();
+    counting = false;
+    return counted;
+}
+
+
+// ---------------- check ----------------
+// The promise is about json_codec alone: the routes around it still
+// allocate (cpp-httplib's request, headers and body strings, and the copy of
+// the encoded body into the response).
+static void check_codec_allocations(CheckState &state)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const std::vector<Quote> quotes = {
+        {0.5, 0.5, 7208.0, 1},
+        {0.123456789, 0.876543211, 0.0, 2},
+        {1e-300, 1.0, 2147483647.0, 3},
+        {nan, inf, -1.0, 4},
+    };
+    const std::vector<Order> orders = {
+        {1, Money::from_micros(10'000'000), Money::from_micros(500'000), Money::from_micros(19'990'000), Side::YES, Money()},
+        {2147483647, Money::from_micros(1), Money::from_micros(999'999), Money::from_micros(-5), Side::NO, Money()},
+    };
+    const std::vector<std::string> messages = {
+        "Market is closed",
+        "quote \" backslash \\ control \x01 tab \t newline \n",
+        std::string(4000, 'x'), // longer than the buffer: cut, not grown
+    };
+    const std::vector<std::string> bodies = {
+        R"({"stake": 10, "side": "yes"})",
+        R"({ "side" : "no" , "stake" : 1.5e2 , "note" : null })",
+        R"({"stake": 10})",
+        R"({})",
+        R"({"stake": "10", "side": "yes"})",      // not ours: FALLBACK
+        R"({"stake": 10, "side": "y\u0065s"})", // escape: FALLBACK
+        R"({"stake": 1e999, "side": "yes"})",     // out of range: FALLBACK
+        R"({"stake": 10, "side": "yes"} trailing)",
+        "",
+    };
+
+    uint64_t total = 0, calls = 0;
+    auto expect_none = [&](uint64_t made, const std::string &what) {
+        state.expect(made == 0, what + " allocated " + std::to_string(made) + " times");
+        total += made;
+        ++calls;
+    };
+
+    for (const Quote &quote : quotes)
+        expect_none(allocations([&] { quote_json(quote); }), "quote_json");
+    for (const Order &order : orders)
+        expect_none(allocations([&] { order_json(order); }), "order_json");
+    for (const std::string &message : messages)
+        expect_none(allocations([&] { error_json(message); }), "error_json (" + std::to_string(message.size()) + " chars)");
+    for (int max_stake : {0, 7208, -2147483647 - 1})
+        expect_none(allocations([&] { stake_error_json(max_stake); }), "stake_error_json");
+    for (const std::string &body : bodies)
+    {
+        double stake = 0.0;
+        std::string_view side;
+        expect_none(allocations([&] { parse_order_body(body, stake, side); }), "parse_order_body(" + body + ")");
+    }
+
+    // and the counter itself works (volatile: a new/delete pair may be elided)
+    uint64_t control = allocations([] {
+        int *volatile p = new int(1);
+        delete p;
+    });
+    state.expect(control == 1, "operator new replacement counted " + std::to_string(control) + " of 1 allocation");
+
+    state.note(std::to_string(calls) + " codec calls, " + std::to_string(total) + " allocations");
+}
+
+
+static const bool registered = register_check_cases({
+    {"json_codec/no_alloc", check_codec_allocations},
+});
@@ -0,0 +1,314 @@
+#include "check.h"
+#include "lmsr_engine.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// The binary LmsrEngine uses closed forms (log1p cost, logistic price,
+// expm1/log1p sizing). These checks hold them against the numeric solver
+// they replaced: the cost as a shifted log-sum-exp, and max_stake and
+// solve_delta_q found by bisection on that cost. The reference runs in long
+// double and bisects until the bracket stops shrinking, so its own error is
+// known: about LDBL_EPSILON * (|C| + b) in the cost (the log of a sum near
+// one), divided by the slope of the cost (a price) for a bisected quantity.
+//
+// Each error is divided by the error the closed form may make in double
+// (a few ulps of the result, more where e^(imbalance/b) amplifies rounding)
+// plus the reference's own, and must stay below a fixed number of ulps.
+
+using Binary = LmsrEngine<2>;
+
+static constexpr double eps = DBL_EPSILON;
+static constexpr long double eps_ref = LDBL_EPSILON;
+
+// b = risk_cap / log(2) from a millionth of a dollar to a hundred million
+static const double risk_caps[] = {1e-6, 1e-2, 1.0, 100.0, 1e4, 1e8};
+
+// q_i / b: zero, tiny and huge imbalances on either side (|q0 - q1| / b up
+// to 1400, far past the point where e^(-|q0-q1|/b) underflows in log1p)
+static const double offsets[] = {0.0, 1e-12, 1e-6, 0.3, 1.0, 5.0, 36.0, 700.0, -1e-9, -2.0, -40.0, -700.0};
+
+// money / b: from deep in expm1's linear range to far beyond the cap
+static const double spends[] = {1e-14, 1e-9, 1e-5, 1e-2, 0.5, 3.0, 30.0};
+
+
+// ---------------- reference: the numeric solver ----------------
+struct Reference
+{
+    long double b;
+
+    long double cost(long double q0, long double q1) const
+    {
+        long double m = std::max(q0, q1);
+        return m + b * std::log(std::exp((q0 - m) / b) + std::exp((q1 - m) / b));
+    }
+
+    long double price(size_t i, long double q0, long double q1) const
+    {
+        long double m = std::max(q0, q1);
+        long double e0 = std::exp((q0 - m) / b), e1 = std::exp((q1 - m) / b);
+        return (i == 0 ? e0 : e1) / (e0 + e1);
+    }
+
+    // smallest d >= 0 with increase(d) >= target: expand, then bisect to
+    // the last representable bracket
+    template <typename Increase>
+    static long double bisect(Increase increase, long double target, long double start)
+    {
+        long double low = 0.0L, high = start;
+        for (int i = 0; i < 16384 && increase(high) < target; ++i)
+            high *= 2.0L;
+        while (true)
+        {
+            long double mid = 0.5L * (low + high);
+            if (mid <= low || mid >= high)
+                return mid;
+            if (increase(mid) < target)
+                low = mid;
+            else
+                high = mid;
+        }
+    }
+
+    // shares of outcome i that cost `money`
+    long double solve_delta_q(size_t i, long double q0, long double q1, long double money) const
+    {
+        long double base = cost(q0, q1);
+        auto increase = [&](long double d) {
+            return (i == 0 ? cost(q0 + d, q1) : cost(q0, q1 + d)) - base;
+        };
+        return bisect(increase, money, b);
+    }
+
+    // the old sizing rule: dq of both outcomes uses up the remaining risk,
+    // priced at outcome 0
+    long double max_stake(long double q0, long double q1, long double risk_cap) const
+    {
+        long double base = cost(q0, q1);
+        long double remaining = risk_cap - (base - cost(0.0L, 0.0L));
+        if (remaining <= 0)
+            return 0.0L;
+        auto increase = [&](long double dq) { return cost(q0 + dq, q1 + dq) - base; };
+        long double dq = bisect(increase, remaining, b);
+        return b * price(0, q0, q1) * std::expm1(dq / b);
+    }
+};
+
+
+// ---------------- error bookkeeping ----------------
+// worst error of one quantity, in units of its allowed error
+class WorstError
+{
+    private:
+        std::string quantity;
+        double bound;
+        double worst = 0.0;
+        std::string where;
+
+    public:
+        WorstError(const std::string &quantity_, double bound_) : quantity(quantity_), bound(bound_) {}
+
+        void add(double error, double scale, const std::string &context)
+        {
+            double normalised = error / scale;
+            if (!(normalised <= worst)) // NaN counts as the worst
+            {
+                worst = normalised;
+                where = context;
+            }
+        }
+
+        void report(CheckState &state) const
+        {
+            std::ostringstream line;
+            line << quantity << ": worst " << worst << " of " << bound << " allowed";
+            if (!where.empty())
+                line << " (" << where << ")";
+            state.note(line.str());
+            state.expect(worst <= bound, quantity + " error " + std::to_string(worst) + " above " + std::to_string(bound) + " at " + where);
+        }
+};
+
+static std::string context(double risk_cap, double t0, double t1, double x = NAN)
+{
+    std::ostringstream out;
+    out << "cap=" << risk_cap << " q/b=(" << t0 << ", " << t1 << ")";
+    if (!std::isnan(x))
+        out << " money/b=" << x;
+    return out.str();
+}
+
+
+// ---------------- checks ----------------
+static void check_cost_and_price(CheckState &state)
+{
+    WorstError cost_error("cost", 8.0), price_error("price", 8.0), sum_error("price(0) + price(1)", 2.0);
+    for (double risk_cap : risk_caps)
+        for (double t0 : offsets)
+            for (double t1 : offsets)
+            {
+                Binary engine(risk_cap);
+                double b = engine.liquidity();
+                double q0 = t0 * b, q1 = t1 * b;
+                engine.set_quantities({q0, q1});
+                Reference ref{b};
+                std::string where = context(risk_cap, t0, t1);
+
+                long double c = ref.cost(q0, q1);
+                double scale = eps * (std::max(std::fabs(q0), std::fabs(q1)) + b) + double(eps_ref * (std::fabs(c) + b));
+                cost_error.add(std::fabs(engine.cost() - double(c)), scale, where);
+
+                // the logistic's rounding grows with its exponent |q0 - q1|/b
+                double z = std::fabs(q0 - q1) / b;
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    long double p = ref.price(i, q0, q1);
+                    price_error.add(std::fabs(engine.price(i) - double(p)), eps * double(p) * (2.0 + z) + DBL_MIN, where);
+                }
+                sum_error.add(std::fabs(engine.price(0) + engine.price(1) - 1.0), eps, where);
+            }
+    cost_error.report(state);
+    price_error.report(state);
+    sum_error.report(state);
+}
+
+static void check_max_stake(CheckState &state)
+{
+    // inventories only grow from zero (below zero the remaining risk, and
+    // e^(R/b) with it, is unbounded); besides the offsets, balanced markets
+    // with a sliver f of the cap left: q0 = q1 = log(2)*(1 - f)*b
+    std::vector<std::pair<double, double>> inventories;
+    for (double t0 : offsets)
+        for (double t1 : offsets)
+            if (t0 >= 0.0 && t1 >= 0.0)
+                inventories.emplace_back(t0, t1);
+    for (double f : {1e-12, 1e-9, 1e-6, 1e-3})
+        inventories.emplace_back(std::log(2.0) * (1.0 - f), std::log(2.0) * (1.0 - f));
+
+    WorstError stake_error("max_stake", 16.0);
+    int compared = 0;
+    for (double risk_cap : risk_caps)
+        for (auto [t0, t1] : inventories)
+        {
+            Binary engine(risk_cap);
+            double b = engine.liquidity();
+            double q0 = t0 * b, q1 = t1 * b;
+            engine.set_quantities({q0, q1});
+            Reference ref{b};
+            std::string where = context(risk_cap, t0, t1);
+
+            long double expected = ref.max_stake(q0, q1, risk_cap);
+            double actual = engine.max_stake(0);
+            if (expected == 0.0L)
+            {
+                // a market at its cap: both say zero unless the
+                // remaining risk is within rounding of the cap
+                double slack = 8.0 * eps * (std::fabs(engine.cost()) + risk_cap + b);
+                state.expect(actual == 0.0 || engine.remaining_risk() <= slack,
+                             "max_stake " + std::to_string(actual) + " on a full market at " + where);
+                continue;
+            }
+            ++compared;
+
+            // d(max_stake)/d(remaining) = p*e^(R/b): the remaining risk
+            // is a difference of costs, so it carries their rounding
+            long double p = ref.price(0, q0, q1);
+            long double c = ref.cost(q0, q1);
+            double slope = double(p * std::exp((long double)engine.remaining_risk() / b));
+            double z = std::fabs(q0 - q1) / b;
+            double scale = slope * (eps * (std::fabs(q0) + std::fabs(q1) + risk_cap + b) + double(4 * eps_ref * (std::fabs(c) + risk_cap + b)))
+                         + eps * double(expected) * (4.0 + z) + DBL_MIN;
+            stake_error.add(std::fabs(actual - double(expected)), scale, where);
+        }
+    stake_error.report(state);
+    state.note("markets with room: " + std::to_string(compared));
+    state.expect(compared > 0, "some markets below their cap");
+}
+
+// Only where p and expm1(money/b) / p fit a double (|q0 - q1|/b < ~708,
+// money/b - log(p) < ~709). Past that the closed form is inf; a market
+// inside its cap has |q0 - q1|/b <= 2*log(2) and money below max_stake,
+// far from there.
+static void check_solve_delta_q(CheckState &state)
+{
+    WorstError delta_error("solve_delta_q", 16.0);
+    int overflowing = 0;
+    for (double risk_cap : risk_caps)
+        for (double t0 : offsets)
+            for (double t1 : offsets)
+                for (double x : spends)
+                {
+                    Binary engine(risk_cap);
+                    double b = engine.liquidity();
+                    double q0 = t0 * b, q1 = t1 * b;
+                    engine.set_quantities({q0, q1});
+                    Reference ref{b};
+                    double money = x * b;
+
+                    for (size_t i = 0; i < 2; ++i)
+                    {
+                        long double p = ref.price(i, q0, q1);
+                        if (p < DBL_MIN || std::expm1((long double)x) / p > DBL_MAX)
+                        {
+                            ++overflowing;
+                            continue;
+                        }
+                        long double expected = ref.solve_delta_q(i, q0, q1, money);
+                        double actual = engine.solve_delta_q(i, money);
+
+                        // the bisection resolves the cost to eps_ref*(|C| + b),
+                        // and d to that over the price where it stops
+                        long double end0 = q0 + (i == 0 ? expected : 0.0L), end1 = q1 + (i == 1 ? expected : 0.0L);
+                        long double slope = ref.price(i, end0, end1);
+                        long double c = std::fabs(ref.cost(q0, q1)) + std::fabs(ref.cost(end0, end1)) + b;
+                        double z = std::fabs(q0 - q1) / b;
+                        double scale = double(4 * eps_ref * c / slope) + eps * (double(expected) * (4.0 + z) + b * z) + DBL_MIN;
+                        delta_error.add(std::fabs(actual - double(expected)), scale, context(risk_cap, t0, t1, x) + " side " + std::to_string(i));
+                    }
+                }
+    delta_error.report(state);
+    state.note("skipped past double range: " + std::to_string(overflowing));
+}
+
+// Where money/b is tiny, d = b*log1p(expm1(x)/p) is within
+// (x/p)^2 of its series x*b/p * (1 + x*(1 - 1/p)/2). Writing it as
+// b*log(1 + (e^x - 1)/p) instead would lose every digit below
+// 1e-16/x; the bisection cannot resolve these either.
+static void check_small_spend_branch(CheckState &state)
+{
+    WorstError series_error("solve_delta_q, money/b < 1e-8", 8.0);
+    const double tiny[] = {1e-300, 1e-200, 1e-100, 1e-30, 1e-16, 1e-12, 1e-9};
+    for (double risk_cap : risk_caps)
+        for (double t0 : {0.0, 1.0, -2.0, 5.0})
+            for (double x : tiny)
+            {
+                Binary engine(risk_cap);
+                double b = engine.liquidity();
+                engine.set_quantities({t0 * b, 0.0});
+                for (size_t i = 0; i < 2; ++i)
+                {
+                    long double p = 1.0L / (1.0L + std::exp(-(long double)(i == 0 ? t0 : -t0)));
+                    long double money = (long double)(x * b);
+                    long double xr = money / b;
+                    long double series = money / p * (1.0L + xr * (1.0L - 1.0L / p) / 2.0L);
+                    long double truncation = series * (xr / p) * (xr / p);
+                    double actual = engine.solve_delta_q(i, x * b);
+                    series_error.add(std::fabs(actual - double(series)), double(8 * eps * series + truncation) + DBL_TRUE_MIN,
+                                     context(risk_cap, t0, 0.0, x) + " side " + std::to_string(i));
+                }
+            }
+    series_error.report(state);
+}
+
+
+static const bool registered = register_check_cases({
+    {"lmsr/precision/cost_price", check_cost_and_price},
+    {"lmsr/precision/max_stake", check_max_stake},
+    {"lmsr/precision/solve_delta_q", check_solve_delta_q},
+    {"lmsr/precision/solve_delta_q_small_spend", check_small_spend_branch},
+});
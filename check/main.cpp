@@ -0,0 +1,34 @@
+#include "check.h"
+#include <iostream>
+#include <string>
+
+
+static void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --filter=TEXT         run only checks whose name contains TEXT\n"
+              << "  --help                show this message\n";
+}
+
+int main(int argc, char *argv[])
+{
+    CheckConfig config;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        if (key == "--filter")
+            config.filter = value;
+        else
+        {
+            print_usage(argv[0]);
+            return key == "--help" ? 0 : 1;
+        }
+    }
+
+    return run_checks(config);
+}
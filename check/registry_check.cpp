@@ -0,0 +1,261 @@
+#include "check.h"
+#include "contract.h"
+#include "journal.h"
+#include "registry.h"
+#include "sequencer.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// 32 threads on one MarketRegistry: 4 writers insert and remove markets while
+// 28 traders find them and buy. Removed markets are closed first, as a
+// resolve does, so a trader holding a pointer from before the removal must
+// get MARKET_CLOSED or a fill, never a dangling object. Each round uses a
+// fresh registry, so the chunks of the radix table are allocated while
+// lookups race them. Seeds come from the clock, so every run explores other
+// interleavings; the seed is printed for a failing run.
+//
+// Afterwards: every fill is in exactly one market's deposits, each id is
+// listed exactly when its writer last inserted it, and size() and
+// for_each() agree with that.
+
+static constexpr int writer_threads = 4;
+static constexpr int trader_threads = 28;
+static constexpr int rounds = 4;
+static constexpr int writer_ops = 4000;
+static constexpr int trader_ops = 6000;
+static constexpr int ids = 5 * static_cast<int>(MarketRegistry::chunk_size) + 17; // across six chunks
+static constexpr double stress_risk_cap = 1e9; // never the reason an order fails
+
+
+struct Failures
+{
+    std::mutex mutex;
+    std::vector<std::string> messages;
+
+    void add(const std::string &message)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.push_back(message);
+    }
+};
+
+struct Round
+{
+    MarketRegistry registry;
+    std::atomic<bool> go{false};
+    std::atomic<int64_t> fills{0};
+    Failures failures;
+
+    // per writer: every contract it created (the registry owns them), and
+    // which of its ids it left listed
+    std::vector<std::vector<LMSRContract *>> created = std::vector<std::vector<LMSRContract *>>(writer_threads);
+    std::vector<std::vector<bool>> listed = std::vector<std::vector<bool>>(writer_threads, std::vector<bool>(ids, false));
+};
+
+static void wait_for_go(const Round &round)
+{
+    while (!round.go.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+// ids with id % writer_threads == w belong to writer w alone, so it knows
+// what insert() and remove() must answer
+static void writer(Round &round, int w, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> pick(0, ids / writer_threads - 1);
+    auto &listed = round.listed[w];
+    wait_for_go(round);
+
+    for (int op = 0; op < writer_ops; ++op)
+    {
+        int id = pick(rng) * writer_threads + w;
+        if (id >= ids)
+            continue;
+        if (listed[id])
+        {
+            if (rng() % 4 == 0)
+            {
+                auto duplicate = std::make_unique<LMSRContract>(id, "stress", stress_risk_cap);
+                if (round.registry.insert(std::move(duplicate)))
+                    round.failures.add("insert of listed id " + std::to_string(id) + " succeeded");
+                continue;
+            }
+            LMSRContract *contract = round.registry.find(id);
+            if (!contract)
+            {
+                round.failures.add("listed id " + std::to_string(id) + " not found by its writer");
+                continue;
+            }
+            contract->close();
+            if (!round.registry.remove(id))
+                round.failures.add("remove of listed id " + std::to_string(id) + " failed");
+            listed[id] = false;
+        }
+        else
+        {
+            if (rng() % 8 == 0 && round.registry.remove(id))
+                round.failures.add("remove of unlisted id " + std::to_string(id) + " succeeded");
+            auto contract = std::make_unique<LMSRContract>(id, "stress", stress_risk_cap);
+            LMSRContract *raw = contract.get();
+            if (!round.registry.insert(std::move(contract)))
+            {
+                round.failures.add("insert of unlisted id " + std::to_string(id) + " failed");
+                continue;
+            }
+            round.created[w].push_back(raw);
+            listed[id] = true;
+        }
+    }
+}
+
+static void trader(Round &round, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> pick(0, ids - 1);
+    const Money stake = Money::from_micros(Money::scale); // $1
+    int64_t fills = 0;
+    wait_for_go(round);
+
+    for (int op = 0; op < trader_ops; ++op)
+    {
+        int id = pick(rng);
+        unsigned action = rng() % 1000;
+        if (action == 0)
+        {
+            // rare: a full scan, racing the writers
+            int previous = -1;
+            round.registry.for_each([&](const LMSRContract &contract) {
+                if (contract.contract_id <= previous || contract.contract_id >= ids)
+                    round.failures.add("for_each visited id " + std::to_string(contract.contract_id) + " after " + std::to_string(previous));
+                previous = contract.contract_id;
+            });
+            continue;
+        }
+
+        LMSRContract *contract = round.registry.find(id);
+        if (!contract)
+            continue;
+        if (contract->contract_id != id)
+        {
+            round.failures.add("find(" + std::to_string(id) + ") returned market " + std::to_string(contract->contract_id));
+            continue;
+        }
+        if (action < 200)
+        {
+            contract->generate_quote();
+            continue;
+        }
+
+        // the writer may close and unlist it meanwhile; the pointer stays good
+        OrderStatus status;
+        Order order = contract->buy(rng() & 1 ? Side::YES : Side::NO, stake, &status);
+        if (status == OrderStatus::FILLED)
+        {
+            ++fills;
+            if (order.event_id != id)
+                round.failures.add("order on market " + std::to_string(id) + " filled for " + std::to_string(order.event_id));
+        }
+        else if (status != OrderStatus::MARKET_CLOSED)
+            round.failures.add("order on market " + std::to_string(id) + " failed with status " + std::to_string(static_cast<int>(status)));
+    }
+    round.fills.fetch_add(fills);
+}
+
+static void verify(Round &round, CheckState &state)
+{
+    // every fill landed in one market, retired or not
+    int64_t orders = 0;
+    Money deposits;
+    for (const auto &contracts : round.created)
+        for (const LMSRContract *contract : contracts)
+        {
+            MarketSnapshot snapshot = contract->snapshot();
+            orders += snapshot.order_count;
+            deposits += snapshot.total_deposits;
+        }
+    int64_t fills = round.fills.load();
+    state.expect(orders == fills, std::to_string(fills) + " fills but " + std::to_string(orders) + " orders in the markets");
+    state.expect(deposits == Money::from_micros(fills * Money::scale), "deposits do not add up to the fills");
+
+    // the table matches what the writers left
+    size_t expected = 0;
+    for (int w = 0; w < writer_threads; ++w)
+        for (int id = w; id < ids; id += writer_threads)
+        {
+            bool listed = round.listed[w][id];
+            expected += listed;
+            LMSRContract *contract = round.registry.find(id);
+            if (listed != (contract != nullptr) || (contract && contract->contract_id != id))
+                state.expect(false, "id " + std::to_string(id) + (listed ? " missing" : " still listed"));
+        }
+    size_t visited = 0;
+    round.registry.for_each([&](const LMSRContract &) { ++visited; });
+    state.expect(round.registry.size() == expected, "size() " + std::to_string(round.registry.size()) + ", expected " + std::to_string(expected));
+    state.expect(visited == expected, "for_each visited " + std::to_string(visited) + ", expected " + std::to_string(expected));
+}
+
+static void run_stress(CheckState &state)
+{
+    JournalConfig journal;
+    journal.durability = Durability::NONE;
+    order_journal().start(journal);
+
+    uint64_t seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    state.note("seed " + std::to_string(seed) + ", " + std::to_string(writer_threads) + " writers, " + std::to_string(trader_threads) + " traders");
+
+    int64_t total_fills = 0;
+    size_t total_markets = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        auto round = std::make_unique<Round>();
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writer_threads; ++w)
+            threads.emplace_back(writer, std::ref(*round), w, seed + 1000 * r + w);
+        for (int t = 0; t < trader_threads; ++t)
+            threads.emplace_back(trader, std::ref(*round), seed + 1000 * r + writer_threads + t);
+        round->go.store(true, std::memory_order_release);
+        for (auto &thread : threads)
+            thread.join();
+
+        for (const auto &message : round->failures.messages)
+            state.expect(false, "round " + std::to_string(r) + ": " + message);
+        verify(*round, state);
+        total_fills += round->fills.load();
+        for (const auto &contracts : round->created)
+            total_markets += contracts.size();
+    }
+    state.note(std::to_string(rounds) + " rounds: " + std::to_string(total_markets) + " markets inserted, " + std::to_string(total_fills) + " fills");
+
+    order_journal().start(JournalConfig{});
+}
+
+static void check_registry_stress(CheckState &state)
+{
+    run_stress(state);
+}
+
+// the same, with buys queued on sequencer threads: a removed market may
+// still be in a shard's queue when the writer retires it
+static void check_registry_stress_sequenced(CheckState &state)
+{
+    SequencerConfig config;
+    config.mode = ExecutionMode::SEQUENCED;
+    config.threads = 4;
+    order_sequencer().start(config);
+    run_stress(state);
+    order_sequencer().stop();
+}
+
+
+static const bool registered = register_check_cases({
+    {"registry/stress", check_registry_stress},
+    {"registry/stress/sequenced", check_registry_stress_sequenced},
+});
@@ -0,0 +1,145 @@
+#include "wire_client.h"
+#include <cstring>
+
+#if defined(MSG_NOSIGNAL)
+static constexpr int send_flags = MSG_NOSIGNAL; // a closed server is an error, not SIGPIPE
+#else
+static constexpr int send_flags = 0;
+#endif
+
+
+bool WireClient::connect(const std::string &host, int port)
+{
+    close();
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+        return false;
+
+    for (addrinfo *a = addresses; a && socket == INVALID_SOCKET; a = a->ai_next)
+    {
+        socket_t s = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == INVALID_SOCKET)
+            continue;
+        if (::connect(s, a->ai_addr, static_cast<int>(a->ai_addrlen)) == 0)
+            socket = s;
+        else
+            httplib::detail::close_socket(s);
+    }
+    freeaddrinfo(addresses);
+    if (socket == INVALID_SOCKET)
+        return false;
+
+    int yes = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&yes), sizeof yes);
+    next_sequence = 1;
+    buffered = consumed = 0;
+    return true;
+}
+
+void WireClient::close()
+{
+    if (socket != INVALID_SOCKET)
+        httplib::detail::close_socket(socket);
+    socket = INVALID_SOCKET;
+}
+
+bool WireClient::send_frame(const uint8_t *frame, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t sent = httplib::detail::send_socket(socket, frame, size, send_flags);
+        if (sent <= 0)
+        {
+            close();
+            return false;
+        }
+        frame += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+uint64_t WireClient::send_order(int event_id, Side side, Money stake)
+{
+    uint8_t frame[wire_max_frame_size];
+    uint64_t sequence = next_sequence;
+    size_t size = wire_encode_order(frame, sequence, static_cast<uint32_t>(event_id), side, stake);
+    if (!connected() || !send_frame(frame, size))
+        return 0;
+    ++next_sequence;
+    return sequence;
+}
+
+uint64_t WireClient::send_quote_request(int event_id)
+{
+    uint8_t frame[wire_max_frame_size];
+    uint64_t sequence = next_sequence;
+    size_t size = wire_encode_quote_request(frame, sequence, static_cast<uint32_t>(event_id));
+    if (!connected() || !send_frame(frame, size))
+        return 0;
+    ++next_sequence;
+    return sequence;
+}
+
+bool WireClient::read_reply(Reply &reply)
+{
+    if (!connected())
+        return false;
+
+    // until a whole frame is buffered
+    while (true)
+    {
+        size_t available = buffered - consumed;
+        if (available >= wire_header_size)
+        {
+            WireFrame header(buffer + consumed);
+            WireType type = header.type();
+            if (!header.valid_header() || (type != WireType::ACK && type != WireType::QUOTE && type != WireType::REJECT))
+            {
+                close();
+                return false;
+            }
+            if (available >= header.length())
+                break;
+        }
+        if (consumed > 0)
+        {
+            std::memmove(buffer, buffer + consumed, available);
+            buffered = available;
+            consumed = 0;
+        }
+        ssize_t received = httplib::detail::read_socket(socket, buffer + buffered, sizeof buffer - buffered, 0);
+        if (received <= 0)
+        {
+            close();
+            return false;
+        }
+        buffered += static_cast<size_t>(received);
+    }
+
+    WireFrame frame(buffer + consumed);
+    consumed += frame.length();
+
+    reply.type = frame.type();
+    reply.sequence = frame.sequence();
+    reply.event_id = static_cast<int>(frame.event_id());
+    switch (reply.type)
+    {
+    case WireType::ACK:
+        reply.order = Order{reply.event_id, frame.stake(), frame.price(), frame.expected_cashout(), frame.side(), Money()};
+        break;
+    case WireType::QUOTE:
+        reply.quote = Quote{frame.price_yes(), frame.price_no(), frame.max_stake(), frame.quote_version()};
+        break;
+    case WireType::REJECT:
+        reply.reason = frame.reason();
+        break;
+    default:
+        break;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "httplib.h" // socket_t and the platform socket headers
+#include "wire_protocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Client side of the binary order-entry protocol (wire_protocol.h): one
+// blocking TCP connection, used from one thread.
+//
+// order() and quote() send a request and wait for its reply. To pipeline,
+// send several with send_order() / send_quote_request() and collect the
+// replies, which arrive in request order, with read_reply().
+class WireClient
+{
+    public:
+        struct Reply
+        {
+            WireType type;       // ACK, QUOTE or REJECT
+            uint64_t sequence;   // of the request it answers
+            int event_id;
+            Order order{};       // ACK
+            Quote quote{};       // QUOTE
+            WireReject reason{}; // REJECT
+        };
+
+    private:
+        socket_t socket = INVALID_SOCKET;
+        uint64_t next_sequence = 1;
+        uint8_t buffer[16 * 1024];
+        size_t buffered = 0;  // received bytes in buffer
+        size_t consumed = 0;  // of which already returned
+
+        bool send_frame(const uint8_t *frame, size_t size);
+
+    public:
+        WireClient() = default;
+        ~WireClient() { close(); }
+        WireClient(const WireClient &) = delete;
+        WireClient &operator=(const WireClient &) = delete;
+
+        bool connect(const std::string &host, int port);
+        void close();
+        bool connected() const { return socket != INVALID_SOCKET; }
+
+        // sequence number of the request sent, 0 if the connection failed
+        uint64_t send_order(int event_id, Side side, Money stake);
+        uint64_t send_quote_request(int event_id);
+
+        // next reply; false (and the connection closed) on a transport or
+        // protocol error
+        bool read_reply(Reply &reply);
+
+        bool order(int event_id, Side side, Money stake, Reply &reply)
+        {
+            return send_order(event_id, side, stake) != 0 && read_reply(reply);
+        }
+        bool quote(int event_id, Reply &reply) { return send_quote_request(event_id) != 0 && read_reply(reply); }
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+// HDR-style latency histogram: log-linear buckets with 64 sub-buckets per
+// power of two, so any recorded value is reported within ~1.6% of its true
+// value, from 1 ns up to hours, in a fixed ~30 KiB table. Not thread-safe;
+// give each thread its own and merge() at the end.
+class LatencyHistogram
+{
+    private:
+        static constexpr int sub_bits = 6;
+        static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+        static constexpr size_t bucket_count = (64 - sub_bits + 1) * sub_count;  // covers every uint64_t
+
+        std::array<uint64_t, bucket_count> counts{};
+        uint64_t total = 0;
+        uint64_t min_ns = UINT64_MAX;
+        uint64_t max_ns = 0;
+        double sum_ns = 0;
+
+        static int highest_bit(uint64_t v)
+        {
+            int bit = 0;
+            while (v >>= 1)
+                ++bit;
+            return bit;
+        }
+
+        // values below 128 get exact buckets; above that, the top 7 bits
+        // (leading 1 + 6 sub-bucket bits) select the bucket
+        static size_t bucket_of(uint64_t ns)
+        {
+            if (ns < 2 * sub_count)
+                return static_cast<size_t>(ns);
+            int shift = highest_bit(ns) - sub_bits;
+            return static_cast<size_t>(shift) * sub_count + static_cast<size_t>(ns >> shift);
+        }
+
+        // largest value that falls into `bucket`
+        static uint64_t bucket_upper(size_t bucket)
+        {
+            if (bucket < 2 * sub_count)
+                return bucket;
+            size_t shift = bucket / sub_count - 1;
+            uint64_t top = bucket - shift * sub_count;
+            return (top << shift) + (uint64_t(1) << shift) - 1;
+        }
+
+    public:
+        void record(uint64_t ns)
+        {
+            ++counts[bucket_of(ns)];
+            ++total;
+            sum_ns += static_cast<double>(ns);
+            min_ns = std::min(min_ns, ns);
+            max_ns = std::max(max_ns, ns);
+        }
+
+        void merge(const LatencyHistogram &other)
+        {
+            for (size_t i = 0; i < bucket_count; ++i)
+                counts[i] += other.counts[i];
+            total += other.total;
+            sum_ns += other.sum_ns;
+            min_ns = std::min(min_ns, other.min_ns);
+            max_ns = std::max(max_ns, other.max_ns);
+        }
+
+        uint64_t count() const { return total; }
+        uint64_t min() const { return total ? min_ns : 0; }
+        uint64_t max() const { return max_ns; }
+        double mean() const { return total ? sum_ns / static_cast<double>(total) : 0.0; }
+
+        // value at quantile q in [0, 1] (upper edge of its bucket, capped at max)
+        uint64_t percentile(double q) const
+        {
+            if (total == 0)
+                return 0;
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucket_count; ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                    return std::min(bucket_upper(i), max_ns);
+            }
+            return max_ns;
+        }
+};
@@ -0,0 +1,302 @@
+#include "loadgen.h"
+#include "httplib.h"
+#include "json.hpp"
+#include "wire_client.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+
+const char *route_name(Route route)
+{
+    switch (route)
+    {
+    case Route::QUOTE:  return "/quote";
+    case Route::QUOTES: return "/quotes";
+    case Route::ORDER:  return "/order";
+    case Route::EVENTS: return "/events";
+    }
+    return "?";
+}
+
+void RouteStats::merge(const RouteStats &other)
+{
+    latency.merge(other.latency);
+    ok += other.ok;
+    rejected += other.rejected;
+    http_errors += other.http_errors;
+    transport_errors += other.transport_errors;
+}
+
+
+// ---------------- one connection ----------------
+struct Worker
+{
+    std::array<RouteStats, route_count> routes;
+    double max_lag_ms = 0;
+};
+
+// HTTP status of one request; 0 if there was no response
+static int send_request(httplib::Client &client, Route route, const LoadConfig &config, std::mt19937_64 &rng)
+{
+    std::uniform_int_distribution<size_t> pick_market(0, config.market_ids.size() - 1);
+    std::string id = std::to_string(config.market_ids[pick_market(rng)]);
+
+    httplib::Result result;
+    switch (route)
+    {
+    case Route::QUOTE:
+        result = client.Get("/quote/" + id);
+        break;
+    case Route::QUOTES:
+        result = client.Get("/quotes");
+        break;
+    case Route::ORDER:
+    {
+        std::uniform_real_distribution<double> stake(config.stake_min, config.stake_max);
+        nlohmann::json body{{"stake", stake(rng)}, {"side", (rng() & 1) ? "yes" : "no"}};
+        result = client.Post("/order/" + id, body.dump(), "application/json");
+        break;
+    }
+    case Route::EVENTS:
+        result = client.Get("/events");
+        break;
+    }
+    return result ? result->status : 0;
+}
+
+// the same over the binary protocol, with its replies mapped to the HTTP
+// statuses the route would have answered
+static int send_request(WireClient &client, Route route, const LoadConfig &config, std::mt19937_64 &rng)
+{
+    std::uniform_int_distribution<size_t> pick_market(0, config.market_ids.size() - 1);
+    int id = config.market_ids[pick_market(rng)];
+
+    if (!client.connected() && !client.connect(config.host, config.wire_port))
+        return 0;
+
+    WireClient::Reply reply;
+    bool answered;
+    if (route == Route::ORDER)
+    {
+        std::uniform_real_distribution<double> stake(config.stake_min, config.stake_max);
+        answered = client.order(id, (rng() & 1) ? Side::YES : Side::NO, Money::from_double(stake(rng)), reply);
+    }
+    else
+        answered = client.quote(id, reply);
+
+    if (!answered)
+        return 0;
+    if (reply.type != WireType::REJECT)
+        return 200;
+    if (reply.reason == WireReject::MARKET_NOT_FOUND)
+        return 404;
+    return reply.reason == WireReject::BAD_SEQUENCE ? 400 : 409;
+}
+
+static void run_worker(const LoadConfig &config, int index, Clock::time_point start, Worker &out)
+{
+    httplib::Client client(config.host, config.port);
+    client.set_keep_alive(true);
+    client.set_tcp_nodelay(true);
+    client.set_connection_timeout(5);
+    client.set_read_timeout(10);
+    WireClient wire;
+
+    std::mt19937_64 rng(config.seed * 1000003 + static_cast<uint64_t>(index));
+    std::discrete_distribution<size_t> pick_route(config.mix.begin(), config.mix.end());
+
+    const Clock::time_point measure_from = start + std::chrono::duration_cast<Clock::duration>(
+                                                       std::chrono::duration<double>(config.warmup_s));
+    const Clock::time_point end = measure_from + std::chrono::duration_cast<Clock::duration>(
+                                                     std::chrono::duration<double>(config.duration_s));
+
+    // open loop: this connection sends every `interval`, offset so the
+    // connections interleave instead of firing together
+    const bool open_loop = config.rate > 0;
+    Clock::duration interval{};
+    Clock::time_point next_send = start;
+    if (open_loop)
+    {
+        interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(config.connections / config.rate));
+        next_send += interval * index / config.connections;
+    }
+
+    while (true)
+    {
+        Clock::time_point scheduled;
+        if (open_loop)
+        {
+            scheduled = next_send;
+            next_send += interval;
+            // a server slower than the schedule leaves a backlog; stop on time anyway
+            if (scheduled >= end || Clock::now() >= end)
+                break;
+            std::this_thread::sleep_until(scheduled);
+        }
+        else
+        {
+            scheduled = Clock::now();
+            if (scheduled >= end)
+                break;
+        }
+
+        Clock::time_point sent = Clock::now();
+        Route route = static_cast<Route>(pick_route(rng));
+        int status = config.binary ? send_request(wire, route, config, rng) : send_request(client, route, config, rng);
+        Clock::time_point done = Clock::now();
+
+        if (scheduled < measure_from)
+            continue;
+
+        RouteStats &stats = out.routes[static_cast<size_t>(route)];
+        if (status == 0)
+            ++stats.transport_errors;
+        else if (status >= 200 && status < 300)
+            ++stats.ok;
+        else if (status == 409)
+            ++stats.rejected;
+        else
+            ++stats.http_errors;
+
+        stats.latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(done - scheduled).count()));
+        if (open_loop)
+            out.max_lag_ms = std::max(out.max_lag_ms,
+                                      std::chrono::duration<double, std::milli>(sent - scheduled).count());
+    }
+}
+
+LoadReport run_load(const LoadConfig &config)
+{
+    std::vector<Worker> workers(static_cast<size_t>(config.connections));
+    std::vector<std::thread> threads;
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < config.connections; ++i)
+        threads.emplace_back(run_worker, std::cref(config), i, start, std::ref(workers[static_cast<size_t>(i)]));
+    for (auto &t : threads)
+        t.join();
+
+    LoadReport report;
+    report.elapsed_s = config.duration_s;
+    for (const auto &w : workers)
+    {
+        for (size_t r = 0; r < route_count; ++r)
+            report.routes[r].merge(w.routes[r]);
+        report.max_schedule_lag_ms = std::max(report.max_schedule_lag_ms, w.max_lag_ms);
+    }
+    return report;
+}
+
+
+// ---------------- reporting ----------------
+static double us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+static void print_row(const std::string &name, const RouteStats &s, double elapsed_s)
+{
+    const LatencyHistogram &h = s.latency;
+    uint64_t errors = s.http_errors + s.transport_errors;
+    double error_pct = s.total() ? 100.0 * static_cast<double>(errors) / static_cast<double>(s.total()) : 0.0;
+
+    std::cout << std::left << std::setw(9) << name << std::right << std::fixed
+              << std::setw(10) << s.total()
+              << std::setprecision(0) << std::setw(10) << static_cast<double>(s.total()) / elapsed_s
+              << std::setw(9) << s.rejected
+              << std::setprecision(2) << std::setw(8) << error_pct << "%"
+              << std::setprecision(0)
+              << std::setw(9) << us(h.percentile(0.50))
+              << std::setw(9) << us(h.percentile(0.90))
+              << std::setw(9) << us(h.percentile(0.99))
+              << std::setw(10) << us(h.percentile(0.999))
+              << std::setw(10) << us(h.max()) << "\n";
+}
+
+void print_report(const LoadConfig &config, const LoadReport &report)
+{
+    std::cout << "\n"
+              << (config.rate > 0 ? "open loop at " + std::to_string(static_cast<long>(config.rate)) + " req/s"
+                                  : std::string("closed loop"))
+              << ", " << config.connections << (config.binary ? " binary" : " HTTP") << " connections, "
+              << config.duration_s << " s measured\n"
+              << "latency in microseconds" << (config.rate > 0 ? " from scheduled send time" : "") << "\n\n";
+
+    std::cout << std::left << std::setw(9) << "route" << std::right
+              << std::setw(10) << "requests" << std::setw(10) << "req/s" << std::setw(9) << "409"
+              << std::setw(9) << "errors" << std::setw(9) << "p50" << std::setw(9) << "p90"
+              << std::setw(9) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n"
+              << std::string(94, '-') << "\n";
+
+    RouteStats all;
+    for (size_t r = 0; r < route_count; ++r)
+    {
+        if (report.routes[r].total() == 0)
+            continue;
+        print_row(route_name(static_cast<Route>(r)), report.routes[r], report.elapsed_s);
+        all.merge(report.routes[r]);
+    }
+    print_row("all", all, report.elapsed_s);
+
+    if (config.rate > 0 && report.max_schedule_lag_ms > 100.0)
+        std::cout << "\nwarning: sends fell up to " << std::setprecision(0) << report.max_schedule_lag_ms
+                  << " ms behind schedule; the target rate was not sustained.\n";
+}
+
+static nlohmann::json stats_json(const RouteStats &s, double elapsed_s)
+{
+    const LatencyHistogram &h = s.latency;
+    return {
+        {"requests", s.total()},
+        {"requests_per_second", static_cast<double>(s.total()) / elapsed_s},
+        {"ok", s.ok},
+        {"rejected", s.rejected},
+        {"http_errors", s.http_errors},
+        {"transport_errors", s.transport_errors},
+        {"latency_us", {
+            {"min", us(h.min())},
+            {"mean", h.mean() / 1000.0},
+            {"p50", us(h.percentile(0.50))},
+            {"p90", us(h.percentile(0.90))},
+            {"p99", us(h.percentile(0.99))},
+            {"p99_9", us(h.percentile(0.999))},
+            {"max", us(h.max())}
+        }}
+    };
+}
+
+bool write_report_json(const LoadConfig &config, const LoadReport &report, const std::string &path)
+{
+    nlohmann::json j;
+    j["config"] = {
+        {"protocol", config.binary ? "binary" : "http"},
+        {"connections", config.connections},
+        {"duration_s", config.duration_s},
+        {"warmup_s", config.warmup_s},
+        {"rate", config.rate},
+        {"markets", config.market_ids.size()},
+        {"seed", config.seed}
+    };
+    RouteStats all;
+    for (size_t r = 0; r < route_count; ++r)
+    {
+        j["mix"][route_name(static_cast<Route>(r))] = config.mix[r];
+        if (report.routes[r].total() == 0)
+            continue;
+        j["routes"][route_name(static_cast<Route>(r))] = stats_json(report.routes[r], report.elapsed_s);
+        all.merge(report.routes[r]);
+    }
+    j["all"] = stats_json(all, report.elapsed_s);
+    j["max_schedule_lag_ms"] = report.max_schedule_lag_ms;
+
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out << j.dump(2) << "\n";
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "histogram.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Routes the generator can exercise. The binary protocol carries QUOTE (a
+// quote request) and ORDER only.
+enum class Route {
+    QUOTE,   // GET  /quote/<id>
+    QUOTES,  // GET  /quotes
+    ORDER,   // POST /order/<id>
+    EVENTS   // GET  /events
+};
+constexpr size_t route_count = 4;
+
+const char *route_name(Route route);
+
+struct LoadConfig
+{
+    std::string host = "127.0.0.1";
+    int port = 4444;
+    bool binary = false;            // quotes and orders over the binary protocol
+    int wire_port = 4445;
+    int connections = 8;            // keep-alive clients, one thread each
+    double duration_s = 10.0;       // measured part of the run
+    double warmup_s = 1.0;          // requests before this are not recorded
+    double rate = 0.0;              // open loop: total requests/s; 0 = closed loop
+    std::array<double, route_count> mix{70.0, 0.0, 25.0, 5.0}; // relative weights
+    double stake_min = 1.0;
+    double stake_max = 50.0;
+    uint64_t seed = 1;
+    std::vector<int> market_ids;    // markets to quote and order on
+};
+
+struct RouteStats
+{
+    LatencyHistogram latency;
+    uint64_t ok = 0;                // 2xx (binary: ACK or QUOTE)
+    uint64_t rejected = 0;          // 409: order refused by the engine (binary: REJECT)
+    uint64_t http_errors = 0;       // any other status (binary: unknown market, bad sequence)
+    uint64_t transport_errors = 0;  // no response (connect, timeout, reset)
+
+    uint64_t total() const { return ok + rejected + http_errors + transport_errors; }
+    void merge(const RouteStats &other);
+};
+
+struct LoadReport
+{
+    std::array<RouteStats, route_count> routes;
+    double elapsed_s = 0;          // measured wall time
+    double max_schedule_lag_ms = 0; // open loop: how far sends fell behind the schedule
+};
+
+// Drives the server at config.host:port and returns the merged statistics.
+// In open-loop mode each request's latency is measured from its scheduled
+// send time, so a stalled server cannot hide queueing delay (no coordinated
+// omission).
+LoadReport run_load(const LoadConfig &config);
+
+void print_report(const LoadConfig &config, const LoadReport &report);
+bool write_report_json(const LoadConfig &config, const LoadReport &report, const std::string &path);
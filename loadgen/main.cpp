@@ -0,0 +1,269 @@
+#include "loadgen.h"
+#include "console.h"
+#include "connection.h"
+#include "database.h"
+#include "httplib.h"
+#include "json.hpp"
+#include "options.h"
+#include "utils.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+
+static void print_usage(const char *program)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --target=HOST:PORT        load an already running server instead of starting one\n"
+              << "  --port=N                  port for the self-hosted server (default 4444)\n"
+              << "  --markets=N               markets created for the self-hosted server (default 100)\n"
+              << "  --durability=sync|group|async|none\n"
+              << "                            self-hosted server's durability (default sync)\n"
+              << "  --storage=sqlite|binlog   self-hosted server's storage engine (default sqlite)\n"
+              << "  --execution=locked|sequenced\n"
+              << "                            self-hosted server's order execution (default locked)\n"
+              << "  --protocol=http|binary    binary: quotes and orders over the binary order-entry\n"
+              << "                            protocol instead of HTTP (default http)\n"
+              << "  --wire-port=N             binary protocol port (default 4445)\n"
+              << "  --connections=N           keep-alive connections, one thread each (default 8)\n"
+              << "  --duration=S              measured seconds (default 10)\n"
+              << "  --warmup=S                unrecorded seconds before that (default 1)\n"
+              << "  --rate=R                  open loop: total requests/s (default 0 = closed loop)\n"
+              << "  --mix=ROUTE=W,...         weights for quote, quotes, order, events\n"
+              << "                            (default quote=70,order=25,events=5)\n"
+              << "  --stake=MIN:MAX           order stake range (default 1:50)\n"
+              << "  --seed=N                  random seed (default 1)\n"
+              << "  --json=FILE               also write the report as JSON\n"
+              << "  --help                    show this message\n";
+}
+
+static bool parse_mix(const std::string &spec, std::array<double, route_count> &mix)
+{
+    std::array<double, route_count> parsed{};
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos)
+            return false;
+        std::string name = "/" + item.substr(0, eq);
+        double weight;
+        try { weight = std::stod(item.substr(eq + 1)); } catch (...) { return false; }
+        if (weight < 0)
+            return false;
+
+        size_t r = 0;
+        while (r < route_count && name != route_name(static_cast<Route>(r)))
+            ++r;
+        if (r == route_count)
+            return false;
+        parsed[r] = weight;
+    }
+    for (double w : parsed)
+        if (w > 0)
+        {
+            mix = parsed;
+            return true;
+        }
+    return false;
+}
+
+// ids of the open markets on a running server
+static bool fetch_market_ids(const LoadConfig &config, std::vector<int> &ids)
+{
+    httplib::Client client(config.host, config.port);
+    httplib::Result res = client.Get("/events");
+    if (!res || res->status != 200)
+        return false;
+    try
+    {
+        nlohmann::json events = nlohmann::json::parse(res->body);
+        for (const auto &e : events)
+            ids.push_back(e.at("id").get<int>());
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+// engine output would drown the report; it is discarded while self-hosting
+class NullBuffer : public std::streambuf
+{
+    protected:
+        int overflow(int c) override { return c; }
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+int main(int argc, char *argv[])
+{
+    LoadConfig config;
+    Options server;
+    bool self_host = true;
+    int markets = 100;
+    std::string json_path;
+    bool mix_given = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+        bool ok = true;
+
+        if (key == "--target" && value.find(':') != std::string::npos)
+        {
+            self_host = false;
+            config.host = value.substr(0, value.rfind(':'));
+            ok = is_integer(value.substr(value.rfind(':') + 1));
+            if (ok)
+                config.port = std::stoi(value.substr(value.rfind(':') + 1));
+        }
+        else if (key == "--port" && is_integer(value))
+            config.port = std::stoi(value);
+        else if (key == "--markets" && is_integer(value) && std::stoi(value) > 0)
+            markets = std::stoi(value);
+        else if (key == "--durability" || key == "--storage" || key == "--execution")
+        {
+            // same values as the server's own flags
+            std::string flag = key + "=" + value;
+            char *args[] = {argv[0], &flag[0]};
+            ok = parse_options(2, args, server);
+        }
+        else if (key == "--connections" && is_integer(value) && std::stoi(value) > 0)
+            config.connections = std::stoi(value);
+        else if (key == "--duration" && is_positive_number(value))
+            config.duration_s = std::stod(value);
+        else if (key == "--warmup" && (value == "0" || is_positive_number(value)))
+            config.warmup_s = std::stod(value);
+        else if (key == "--rate" && (value == "0" || is_positive_number(value)))
+            config.rate = std::stod(value);
+        else if (key == "--mix")
+            ok = mix_given = parse_mix(value, config.mix);
+        else if (key == "--protocol" && (value == "http" || value == "binary"))
+            config.binary = value == "binary";
+        else if (key == "--wire-port" && is_integer(value) && std::stoi(value) > 0)
+            config.wire_port = std::stoi(value);
+        else if (key == "--stake" && value.find(':') != std::string::npos)
+        {
+            std::string lo = value.substr(0, value.find(':')), hi = value.substr(value.find(':') + 1);
+            ok = is_positive_number(lo) && is_positive_number(hi) && std::stod(lo) <= std::stod(hi);
+            if (ok)
+            {
+                config.stake_min = std::stod(lo);
+                config.stake_max = std::stod(hi);
+            }
+        }
+        else if (key == "--seed" && is_integer(value))
+            config.seed = std::stoull(value);
+        else if (key == "--json" && !value.empty())
+            json_path = value;
+        else
+        {
+            print_usage(argv[0]);
+            return key == "--help" ? 0 : 1;
+        }
+
+        if (!ok)
+        {
+            error_msg("Invalid option: '" + arg + "'");
+            return 1;
+        }
+    }
+
+    if (config.binary)
+    {
+        std::array<double, route_count> &mix = config.mix;
+        size_t quotes = static_cast<size_t>(Route::QUOTES), events = static_cast<size_t>(Route::EVENTS);
+        if (mix_given && (mix[quotes] > 0 || mix[events] > 0))
+        {
+            error_msg("The binary protocol carries only quote and order.");
+            return 1;
+        }
+        mix[quotes] = mix[events] = 0;
+    }
+
+    // ---------------- self-hosted server on a temporary database ----------------
+    std::string db_path;
+    NullBuffer null_buffer;
+    std::streambuf *console_out = nullptr;
+    std::unique_ptr<Console> console;
+
+    if (self_host)
+    {
+        db_path = (std::filesystem::temp_directory_path() /
+                   ("ecb-loadgen-" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".db"))
+                      .string();
+        database_path = db_path.c_str();
+        server.journal.binlog.directory = db_path + "-binlog";
+        std::cerr << "Self-hosting on " << config.host << ":" << config.port << " with " << markets
+                  << " markets (database " << db_path << ")\n";
+
+        console_out = std::cout.rdbuf(&null_buffer);
+        bool ready = initialize_database() == 0;
+        for (int m = 0; ready && m < markets; ++m)
+            ready = new_event("lg" + std::to_string(m), "Load test market " + std::to_string(m),
+                              "2099-01-01 00:00:00", Money::from_micros(1'000'000 * Money::scale)) > 0;
+
+        server.http_host = config.host;
+        server.http_port = config.port;
+        if (config.binary)
+            server.wire_port = config.wire_port;
+        console = std::make_unique<Console>(server);
+        if (ready)
+            ready = console->start();
+        if (!ready)
+        {
+            std::cout.rdbuf(console_out);
+            error_msg("Could not set up the self-hosted server.");
+            return 1;
+        }
+    }
+
+    int status = 0;
+    bool ran = false;
+    LoadReport report;
+    if (!fetch_market_ids(config, config.market_ids) || config.market_ids.empty())
+    {
+        std::cerr << "No open markets reachable at " << config.host << ":" << config.port << "\n";
+        status = 1;
+    }
+    else
+    {
+        std::cerr << "Running " << config.warmup_s << " s warm-up + " << config.duration_s << " s against "
+                  << config.market_ids.size() << " markets...\n";
+        report = run_load(config);
+        ran = true;
+    }
+
+    if (console)
+    {
+        console->stop();
+        console.reset();
+        std::cout.rdbuf(console_out);
+        if (DbConnection *conn = db_connection())
+            conn->close();
+        for (const char *suffix : {"", "-wal", "-shm"})
+            std::remove((db_path + suffix).c_str());
+        std::filesystem::remove_all(server.journal.binlog.directory);
+    }
+
+    if (ran)
+    {
+        print_report(config, report);
+        if (!json_path.empty())
+        {
+            if (write_report_json(config, report, json_path))
+                std::cout << "\nReport written to " << json_path << "\n";
+            else
+                status = 1;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,979 @@
+#include "binlog.h"
+#include "database.h" // for record_logged_fills, load_binlog_position
+#include "logger.h"
+#include "trace.h"
+#include "utils.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+
+// ---------------- CRC-32C ----------------
+// slice-by-8 over a table built on first use; portable, ~1 byte per cycle
+struct Crc32cTable
+{
+    uint32_t t[8][256];
+
+    Crc32cTable()
+    {
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1u)));
+            t[0][i] = c;
+        }
+        for (int s = 1; s < 8; ++s)
+            for (uint32_t i = 0; i < 256; ++i)
+                t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+};
+
+static uint32_t crc32c(const void *data, size_t size)
+{
+    static const Crc32cTable table;
+    const auto &t = table.t;
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    uint32_t crc = 0xFFFFFFFFu;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= crc;
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    while (size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return ~crc;
+}
+
+
+// ---------------- mapped files ----------------
+// A file mapped read-write in full. open() creates the file or grows it to
+// `size` (0: keep the existing size); flush() forces a range to disk.
+class MappedFile
+{
+    private:
+        uint8_t *base = nullptr;
+        size_t length = 0;
+#if defined(_WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#else
+        int fd = -1;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool open(const std::string &path, size_t size);
+        void close();
+        bool flush(size_t offset, size_t bytes);
+
+        uint8_t *data() const { return base; }
+        size_t size() const { return length; }
+};
+
+#if defined(_WIN32)
+bool MappedFile::open(const std::string &path, size_t size)
+{
+    close();
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER current;
+    if (!GetFileSizeEx(file, &current))
+    {
+        close();
+        return false;
+    }
+    length = std::max(static_cast<size_t>(current.QuadPart), size);
+    if (length == 0)
+    {
+        close();
+        return false;
+    }
+
+    // mapping past the end of the file extends it (zero-filled)
+    uint64_t wanted = length;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(wanted >> 32),
+                                 static_cast<DWORD>(wanted & 0xFFFFFFFFu), nullptr);
+    base = mapping ? static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, length)) : nullptr;
+    if (!base)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (base)
+        UnmapViewOfFile(base);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    base = nullptr;
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+    length = 0;
+}
+
+bool MappedFile::flush(size_t offset, size_t bytes)
+{
+    return FlushViewOfFile(base + offset, bytes) && FlushFileBuffers(file);
+}
+
+static void sync_directory(const std::string &) {} // NTFS journals directory entries
+#else
+bool MappedFile::open(const std::string &path, size_t size)
+{
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close();
+        return false;
+    }
+    length = std::max(static_cast<size_t>(st.st_size), size);
+    if (length == 0)
+    {
+        close();
+        return false;
+    }
+    if (static_cast<size_t>(st.st_size) < length)
+    {
+        // reserve the blocks now: a full disk fails here, not as SIGBUS on a later store
+#if defined(__linux__)
+        bool grown = posix_fallocate(fd, 0, static_cast<off_t>(length)) == 0;
+#else
+        bool grown = ftruncate(fd, static_cast<off_t>(length)) == 0;
+#endif
+        if (!grown || fsync(fd) != 0)
+        {
+            close();
+            return false;
+        }
+    }
+
+    void *mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    base = static_cast<uint8_t *>(mapped);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (base)
+        munmap(base, length);
+    if (fd >= 0)
+        ::close(fd);
+    base = nullptr;
+    fd = -1;
+    length = 0;
+}
+
+bool MappedFile::flush(size_t offset, size_t bytes)
+{
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offset / page * page;
+    return msync(base + start, offset + bytes - start, MS_SYNC) == 0;
+}
+
+// makes a created or renamed file's directory entry durable
+static void sync_directory(const std::string &directory)
+{
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    fsync(fd);
+    ::close(fd);
+}
+#endif
+
+
+// ---------------- on-disk format ----------------
+// Native byte order: a log is read back by the machine that wrote it.
+// Version 2 stores amounts as Money micro-units; version 1 had doubles.
+static const char segment_magic[8] = {'E', 'C', 'B', 'L', 'O', 'G', '0', '2'};
+static const char segment_magic_v1[8] = {'E', 'C', 'B', 'L', 'O', 'G', '0', '1'};
+static const char snapshot_magic[8] = {'E', 'C', 'B', 'S', 'N', 'A', 'P', '2'};
+static constexpr size_t segment_header_bytes = 64;
+
+struct SegmentHeader
+{
+    char magic[8];
+    uint32_t record_bytes;
+    uint32_t reserved;
+    uint64_t first_seq;
+};
+
+// one fill and the market state it left behind
+struct BinlogRecord
+{
+    uint64_t seq;
+    int32_t event_id;
+    uint8_t side;
+    uint8_t reserved0[3];
+    int64_t order_count;
+    int64_t stake, price, expected_cashout; // micro-units
+    double q_yes, q_no;
+    int64_t event_funds;
+    int64_t yes_stake, no_stake, largest_stake, yes_liability, no_liability;
+    uint8_t reserved1[12];
+    uint32_t crc; // CRC-32C of everything before it
+};
+static_assert(sizeof(BinlogRecord) == 128, "binlog records are 128 bytes");
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint64_t seq;        // state through this record
+    uint64_t count;      // entries that follow
+    uint32_t entry_bytes;
+    uint32_t crc;        // CRC-32C of the entries
+};
+
+struct SnapshotEntry
+{
+    int32_t event_id;
+    uint32_t reserved;
+    int64_t order_count;
+    double q_yes, q_no;
+    int64_t event_funds;
+    int64_t yes_stake, no_stake, largest_stake, yes_liability, no_liability;
+};
+
+static OrderAggregates aggregates_of(int64_t yes_stake, int64_t no_stake, int64_t largest_stake, int64_t yes_liability,
+                                     int64_t no_liability)
+{
+    return OrderAggregates{Money::from_micros(yes_stake), Money::from_micros(no_stake), Money::from_micros(largest_stake),
+                           Money::from_micros(yes_liability), Money::from_micros(no_liability)};
+}
+
+static LoggedMarketState state_of(const BinlogRecord &r)
+{
+    return LoggedMarketState{r.q_yes, r.q_no, Money::from_micros(r.event_funds), r.order_count,
+                             aggregates_of(r.yes_stake, r.no_stake, r.largest_stake, r.yes_liability, r.no_liability)};
+}
+
+static bool record_valid(const BinlogRecord &r, uint64_t seq)
+{
+    return r.seq == seq && r.crc == crc32c(&r, offsetof(BinlogRecord, crc));
+}
+
+// the next segment's file while the feeder prepares it; not a *.seg name
+static std::string spare_path(const std::string &directory)
+{
+    return (fs::path(directory) / "spare.seg.tmp").string();
+}
+
+static std::string numbered(const std::string &directory, const char *prefix, uint64_t seq, const char *suffix)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%020" PRIu64 "%s", prefix, seq, suffix);
+    return (fs::path(directory) / name).string();
+}
+
+// files named <prefix><number><suffix> in `directory`, by ascending number
+static std::vector<std::pair<uint64_t, std::string>> list_numbered(const std::string &directory, const std::string &prefix,
+                                                                   const std::string &suffix)
+{
+    std::vector<std::pair<uint64_t, std::string>> found;
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator(directory, ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.size() != prefix.size() + 20 + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        std::string digits = name.substr(prefix.size(), 20);
+        if (digits.find_first_not_of("0123456789") != std::string::npos)
+            continue;
+        found.emplace_back(std::stoull(digits), entry.path().string());
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+
+// ---------------- open + recovery ----------------
+Binlog::Binlog() = default;
+
+Binlog::~Binlog()
+{
+    close();
+}
+
+bool Binlog::open(const BinlogConfig &config_)
+{
+    close();
+    config = config_;
+    failed = false;
+    spare_ready = false;
+    if (config.segment_bytes < segment_header_bytes + 1024 * sizeof(BinlogRecord))
+        config.segment_bytes = segment_header_bytes + 1024 * sizeof(BinlogRecord);
+
+    std::error_code ec;
+    fs::create_directories(config.directory, ec);
+    if (ec)
+    {
+        error_msg("Cannot create binlog directory '" + config.directory + "': " + ec.message());
+        return false;
+    }
+    if (!load_binlog_position(fed) || !recover())
+    {
+        segments.clear();
+        state.clear();
+        return false;
+    }
+
+    running = true;
+    feeder = std::thread(&Binlog::feed_loop, this);
+    return true;
+}
+
+// newest snapshot whose checksum holds, into `into`; `seq` is the record it covers through
+bool Binlog::load_snapshot(std::unordered_map<int, LoggedMarketState> &into, uint64_t &seq) const
+{
+    auto snapshots = list_numbered(config.directory, "snapshot-", ".snap");
+    for (auto it = snapshots.rbegin(); it != snapshots.rend(); ++it)
+    {
+        MappedFile file;
+        if (!file.open(it->second, 0) || file.size() < sizeof(SnapshotHeader))
+            continue;
+        SnapshotHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 ||
+            header.entry_bytes != sizeof(SnapshotEntry) ||
+            file.size() < sizeof(header) + header.count * sizeof(SnapshotEntry) ||
+            header.crc != crc32c(file.data() + sizeof(header), header.count * sizeof(SnapshotEntry)))
+        {
+            log_warn("Skipping damaged binlog snapshot.", {{"file", it->second}});
+            continue;
+        }
+
+        for (uint64_t i = 0; i < header.count; ++i)
+        {
+            SnapshotEntry e;
+            std::memcpy(&e, file.data() + sizeof(header) + i * sizeof(e), sizeof(e));
+            into[e.event_id] = LoggedMarketState{
+                e.q_yes, e.q_no, Money::from_micros(e.event_funds), e.order_count,
+                aggregates_of(e.yes_stake, e.no_stake, e.largest_stake, e.yes_liability, e.no_liability)};
+        }
+        seq = header.seq;
+        return true;
+    }
+    return false;
+}
+
+bool Binlog::recover()
+{
+    TraceSpan span("Binlog::recover");
+    load_snapshot(state, snapshot_seq);
+
+    // replay every valid record after the snapshot; a log ends at its first
+    // invalid record, which may only be followed by a segment continuing
+    // exactly there (segments are rolled early to keep a batch in one), or
+    // past records SQLite already has
+    uint64_t expected = 0; // next seq; 0 until the first segment
+    size_t replayed = 0;
+
+    // segments ending before fed + 1 are wholly in SQLite; a log continuing
+    // after a gap there does not need them, and keeping them would leave
+    // the gap for the next start
+    auto drop_fed_segments = [&]() {
+        std::vector<std::string> paths;
+        for (const Segment &segment : segments)
+            paths.push_back(segment.path);
+        segments.clear();
+        for (const std::string &path : paths)
+            std::remove(path.c_str());
+        sync_directory(config.directory);
+        log_info("Dropped binlog segments already in SQLite", {{"segments", paths.size()}, {"through_seq", expected - 1}});
+    };
+    for (const auto &found : list_numbered(config.directory, "", ".seg"))
+    {
+        auto file = std::unique_ptr<MappedFile>(new MappedFile());
+        SegmentHeader header;
+        if (!file->open(found.second, 0) || file->size() < segment_header_bytes)
+        {
+            error_msg("Cannot open binlog segment " + found.second);
+            return false;
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, segment_magic_v1, sizeof(header.magic)) == 0)
+        {
+            error_msg("Binlog segment " + found.second + " was written by an older build; start that build once "
+                      "to feed it into SQLite, then remove the binlog directory.");
+            return false;
+        }
+        if (std::memcmp(header.magic, segment_magic, sizeof(header.magic)) != 0 ||
+            header.record_bytes != sizeof(BinlogRecord) || header.first_seq != found.first)
+        {
+            error_msg("Binlog segment " + found.second + " has an invalid header.");
+            return false;
+        }
+        if (expected != 0 && header.first_seq > expected && header.first_seq - 1 <= fed)
+            drop_fed_segments();
+        else if (expected != 0 && header.first_seq != expected)
+        {
+            error_msg("Binlog is missing records " + std::to_string(expected) + " to " +
+                      std::to_string(header.first_seq - 1) + " (before " + found.second + ").");
+            return false;
+        }
+
+        size_t capacity = (file->size() - segment_header_bytes) / sizeof(BinlogRecord);
+        uint64_t seq = header.first_seq;
+        for (size_t i = 0; i < capacity; ++i, ++seq)
+        {
+            BinlogRecord r;
+            std::memcpy(&r, file->data() + segment_header_bytes + i * sizeof(r), sizeof(r));
+            if (!record_valid(r, seq))
+                break;
+            if (seq > snapshot_seq)
+            {
+                state[r.event_id] = state_of(r);
+                ++replayed;
+            }
+        }
+        expected = seq;
+        segments.push_back(Segment{header.first_seq, capacity, found.second, std::move(file)});
+    }
+
+    next_seq = std::max({expected, snapshot_seq + 1, fed + 1, uint64_t(1)});
+    written.store(next_seq - 1, std::memory_order_release);
+    synced.store(next_seq - 1, std::memory_order_release);
+
+    // appends continue in the last segment only if it ends exactly at next_seq
+    if (segments.empty() || expected != next_seq)
+    {
+        if (!segments.empty() && expected - 1 <= fed)
+            drop_fed_segments();
+        if (!add_segment(next_seq))
+            return false;
+    }
+
+    if (replayed > 0 || next_seq > fed + 1)
+        log_info("Binlog recovered", {{"snapshot_seq", snapshot_seq}, {"replayed", replayed},
+                                      {"last_seq", next_seq - 1}, {"sqlite_behind", next_seq - 1 - fed}});
+    return true;
+}
+
+// creates a segment whose first record is `first_seq` and appends to it from
+// now on; caller holds mutex (or is recovering)
+bool Binlog::add_segment(uint64_t first_seq)
+{
+    std::string path = numbered(config.directory, "", first_seq, ".seg");
+    std::error_code ec;
+    bool prepared = false;
+    if (spare_ready)
+    {
+        // allocated and zero-filled by the feeder: it only needs a name and a header
+        spare_ready = false;
+        fs::rename(spare_path(config.directory), path, ec);
+        prepared = !ec;
+        if (ec)
+            log_warn("Cannot use the preallocated binlog segment.", {{"path", path}, {"error", ec.message()}});
+    }
+    bool reused = !prepared && fs::exists(path, ec); // left over from a log that was cut short
+    auto file = std::unique_ptr<MappedFile>(new MappedFile());
+    if (!file->open(path, config.segment_bytes) || file->size() < segment_header_bytes + sizeof(BinlogRecord))
+    {
+        log_error("Cannot create binlog segment.", {{"path", path}});
+        return false;
+    }
+
+    // a new file is zero-filled already; a reused one has to be cleared
+    if (reused)
+        std::memset(file->data(), 0, file->size());
+    SegmentHeader header{};
+    std::memcpy(header.magic, segment_magic, sizeof(header.magic));
+    header.record_bytes = sizeof(BinlogRecord);
+    header.first_seq = first_seq;
+    std::memcpy(file->data(), &header, sizeof(header));
+    if (!file->flush(0, reused ? file->size() : sizeof(header)))
+    {
+        log_error("Cannot write binlog segment.", {{"path", path}});
+        return false;
+    }
+    sync_directory(config.directory);
+
+    size_t capacity = (file->size() - segment_header_bytes) / sizeof(BinlogRecord);
+    segments.push_back(Segment{first_seq, capacity, path, std::move(file)});
+    return true;
+}
+
+// allocates the next segment's file once the current one is half full, so
+// the append that rolls over only renames it (allocating 64 MiB under
+// `mutex` would stall every appender); runs on the feeder thread
+bool Binlog::prepare_spare()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare_ready || failed || segments.empty())
+            return true;
+        const Segment &segment = segments.back();
+        if (next_seq - segment.first_seq < segment.capacity / 2)
+            return true;
+    }
+
+    // add_segment() only takes the file once it is ready, so nobody else touches it
+    std::string path = spare_path(config.directory);
+    std::remove(path.c_str());
+    {
+        MappedFile file;
+        if (!file.open(path, config.segment_bytes))
+        {
+            log_warn("Cannot preallocate the next binlog segment.", {{"path", path}});
+            std::remove(path.c_str());
+            return false;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    spare_ready = true;
+    return true;
+}
+
+
+// ---------------- append ----------------
+bool Binlog::append(const std::vector<Fill> &fills, bool durable)
+{
+    TraceSpan span("Binlog::append");
+    if (fills.empty())
+        return true;
+
+    uint64_t last;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (failed)
+            return false;
+
+        // a batch never spans segments, so it is whole or absent after a crash
+        Segment *segment = &segments.back();
+        if (next_seq - segment->first_seq + fills.size() > segment->capacity)
+        {
+            if (!add_segment(next_seq))
+                return false;
+            segment = &segments.back();
+            if (fills.size() > segment->capacity)
+                return false;
+        }
+
+        uint8_t *slot = segment->file->data() + segment_header_bytes +
+                        (next_seq - segment->first_seq) * sizeof(BinlogRecord);
+        for (const Fill &fill : fills)
+        {
+            BinlogRecord r{};
+            r.seq = next_seq++;
+            r.event_id = fill.event_id;
+            r.side = fill.side == Side::YES ? 1 : 0;
+            r.order_count = fill.order_count;
+            r.stake = fill.stake.micros();
+            r.price = fill.price.micros();
+            r.expected_cashout = fill.expected_cashout.micros();
+            r.q_yes = fill.q_yes;
+            r.q_no = fill.q_no;
+            r.event_funds = fill.event_funds.micros();
+            r.yes_stake = fill.aggregates.yes_stake.micros();
+            r.no_stake = fill.aggregates.no_stake.micros();
+            r.largest_stake = fill.aggregates.largest_stake.micros();
+            r.yes_liability = fill.aggregates.yes_liability.micros();
+            r.no_liability = fill.aggregates.no_liability.micros();
+            r.crc = crc32c(&r, offsetof(BinlogRecord, crc));
+            std::memcpy(slot, &r, sizeof(r));
+            slot += sizeof(r);
+            state[fill.event_id] = state_of(r);
+        }
+        last = next_seq - 1;
+        written.store(last, std::memory_order_release);
+    }
+    return !durable || sync_to(last);
+}
+
+// msyncs everything appended so far if `seq` is not on disk yet; callers
+// arriving while another sync runs usually find their records covered by it
+bool Binlog::sync_to(uint64_t seq)
+{
+    if (synced.load(std::memory_order_acquire) >= seq)
+        return true;
+
+    std::lock_guard<std::mutex> sync_lock(sync_mutex);
+    uint64_t from = synced.load(std::memory_order_relaxed) + 1;
+    if (from > seq)
+        return true;
+    if (failed)
+        return false; // discarded with the flush that failed
+
+    struct Range { MappedFile *file; size_t offset, bytes; };
+    std::vector<Range> ranges;
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        target = written.load(std::memory_order_acquire);
+        for (size_t i = 0; i < segments.size(); ++i)
+        {
+            const Segment &segment = segments[i];
+            uint64_t seg_end = segment_end(i);
+            if (seg_end <= from || segment.first_seq > target)
+                continue;
+            uint64_t lo = std::max(from, segment.first_seq);
+            uint64_t hi = std::min(target + 1, seg_end);
+            ranges.push_back(Range{segment.file.get(), segment_header_bytes + (lo - segment.first_seq) * sizeof(BinlogRecord),
+                                   static_cast<size_t>(hi - lo) * sizeof(BinlogRecord)});
+        }
+    }
+
+    TraceSpan span("Binlog msync");
+    for (const Range &range : ranges)
+        if (!range.file->flush(range.offset, range.bytes))
+        {
+            log_error("Binlog msync failed.", {{"seq", seq}});
+            discard_unsynced();
+            std::lock_guard<std::mutex> feed_lock(feed_mutex);
+            feed_cv.notify_all(); // wait_fed() callers may be waiting for discarded records
+            return false;
+        }
+    synced.store(target, std::memory_order_release);
+    return true;
+}
+
+// after a failed msync: clears the records past `synced` (their callers are
+// told they failed, so neither the feeder nor a restart may see them) and
+// refuses appends from then on, so no seq is handed out twice; caller holds
+// sync_mutex
+void Binlog::discard_unsynced()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    failed = true;
+    uint64_t keep = synced.load(std::memory_order_relaxed);
+    uint64_t last = written.load(std::memory_order_relaxed);
+    if (last <= keep)
+        return;
+
+    // segments rolled after the last good flush hold discarded records only
+    while (segments.size() > 1 && segments.back().first_seq > keep + 1)
+    {
+        std::string path = segments.back().path;
+        segments.pop_back();
+        std::remove(path.c_str());
+    }
+    sync_directory(config.directory);
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        Segment &segment = segments[i];
+        uint64_t lo = std::max(keep + 1, segment.first_seq);
+        uint64_t hi = std::min(last + 1, segment_end(i));
+        if (lo >= hi)
+            continue;
+        size_t offset = segment_header_bytes + (lo - segment.first_seq) * sizeof(BinlogRecord);
+        size_t bytes = static_cast<size_t>(hi - lo) * sizeof(BinlogRecord);
+        std::memset(segment.file->data() + offset, 0, bytes);
+        if (!segment.file->flush(offset, bytes))
+            log_error("Cannot clear discarded binlog records.", {{"path", segment.path}});
+    }
+
+    next_seq = keep + 1;
+    written.store(keep, std::memory_order_release);
+    replay_state(keep);
+    log_error("Binlog discarded the records that did not reach disk; appends are refused until restart.",
+              {{"from_seq", keep + 1}, {"to_seq", last}});
+}
+
+// rebuilds `state` from the newest snapshot and the records through
+// `through`; caller holds mutex
+void Binlog::replay_state(uint64_t through)
+{
+    state.clear();
+    uint64_t seq = 0;
+    load_snapshot(state, seq);
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        const Segment &segment = segments[i];
+        const uint8_t *base = segment.file->data() + segment_header_bytes;
+        uint64_t end = std::min(through + 1, segment_end(i));
+        for (uint64_t s = std::max(seq + 1, segment.first_seq); s < end; ++s)
+        {
+            BinlogRecord r;
+            std::memcpy(&r, base + (s - segment.first_seq) * sizeof(r), sizeof(r));
+            if (record_valid(r, s))
+                state[r.event_id] = state_of(r);
+        }
+    }
+}
+
+bool Binlog::logged_state(int event_id, LoggedMarketState &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = state.find(event_id);
+    if (it == state.end())
+        return false;
+    out = it->second;
+    return true;
+}
+
+
+// ---------------- feeding SQLite ----------------
+static constexpr size_t feed_batch = 4096; // records per SQLite transaction
+
+// one past the last record segment i holds (or can hold); caller holds mutex
+uint64_t Binlog::segment_end(size_t i) const
+{
+    return i + 1 < segments.size() ? segments[i + 1].first_seq : segments[i].first_seq + segments[i].capacity;
+}
+
+// decodes up to `max` records after `after` into `out`, stopping at the last
+// one on disk; `last` is the seq of the final one, or past a gap in the log
+// that had to be skipped
+size_t Binlog::read_records(uint64_t after, size_t max, std::vector<Fill> &out, uint64_t &last)
+{
+    out.clear();
+    uint64_t end = synced.load(std::memory_order_acquire);
+    uint64_t seq = after + 1;
+    while (seq <= end && out.size() < max)
+    {
+        const uint8_t *base = nullptr;
+        uint64_t first = 0, stop = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < segments.size() && !base; ++i)
+                if (seq >= segments[i].first_seq && seq < segment_end(i))
+                {
+                    base = segments[i].file->data() + segment_header_bytes;
+                    first = segments[i].first_seq;
+                    stop = segment_end(i);
+                }
+            if (!base)
+            {
+                // the database is behind the oldest retained record (e.g. the
+                // log directory was replaced); continue with what the log has
+                auto next = std::find_if(segments.begin(), segments.end(),
+                                         [&](const Segment &s) { return s.first_seq > seq; });
+                if (next == segments.end())
+                    break;
+                log_error("Binlog records missing from SQLite cannot be fed.",
+                          {{"from", seq}, {"to", next->first_seq - 1}});
+                seq = next->first_seq;
+                last = seq - 1;
+                continue;
+            }
+        }
+
+        for (; seq <= end && seq < stop && out.size() < max; ++seq)
+        {
+            BinlogRecord r;
+            std::memcpy(&r, base + (seq - first) * sizeof(r), sizeof(r));
+            out.push_back(Fill{r.event_id, r.side ? Side::YES : Side::NO, Money::from_micros(r.stake),
+                               Money::from_micros(r.price), Money::from_micros(r.expected_cashout), r.q_yes, r.q_no,
+                               Money::from_micros(r.event_funds), r.order_count,
+                               aggregates_of(r.yes_stake, r.no_stake, r.largest_stake, r.yes_liability, r.no_liability)});
+            last = seq;
+        }
+    }
+    return out.size();
+}
+
+void Binlog::feed_loop()
+{
+    std::vector<Fill> batch;
+    batch.reserve(feed_batch);
+    auto next_snapshot = std::chrono::steady_clock::now() + config.snapshot_interval;
+    auto next_spare = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(feed_mutex);
+    uint64_t position = fed;
+    while (true)
+    {
+        bool stopping = !running;
+        lock.unlock();
+
+        // ASYNC appends reach disk here, within one feeder pass; only records
+        // on disk are fed, so SQLite never gets ahead of the log
+        sync_to(written.load(std::memory_order_acquire));
+
+        uint64_t last = position;
+        bool ok = true;
+        read_records(position, feed_batch, batch, last);
+        if (last != position)
+        {
+            ok = record_logged_fills(batch, last);
+            if (!ok)
+                log_error("Could not copy binlog records into SQLite; retrying.", {{"after_seq", position}});
+        }
+
+        if (std::chrono::steady_clock::now() >= next_snapshot)
+        {
+            write_snapshot();
+            prune();
+            next_snapshot = std::chrono::steady_clock::now() + config.snapshot_interval;
+        }
+        if (std::chrono::steady_clock::now() >= next_spare && !prepare_spare())
+            next_spare = std::chrono::steady_clock::now() + std::chrono::seconds(1); // e.g. disk full: appends roll inline
+
+        lock.lock();
+        if (ok && last != position)
+        {
+            position = fed = last;
+            feed_cv.notify_all();
+            continue; // there may be more right away
+        }
+        if (stopping)
+            return; // drained (or SQLite keeps failing: the records stay in the log)
+        // appenders never signal (it would cost them a lock); poll instead
+        feed_cv.wait_for(lock, ok ? std::chrono::milliseconds(5) : std::chrono::milliseconds(1000));
+    }
+}
+
+void Binlog::wait_fed()
+{
+    uint64_t target = written.load(std::memory_order_acquire);
+    std::unique_lock<std::mutex> lock(feed_mutex);
+    // a failed msync may discard records, so the target can shrink
+    feed_cv.wait(lock, [&]() { return fed >= std::min(target, written.load(std::memory_order_acquire)) || !running; });
+}
+
+
+// ---------------- snapshots ----------------
+// every market's logged state as of one record, written to a new file and
+// renamed into place; the records it covers must be on disk first
+bool Binlog::write_snapshot()
+{
+    TraceSpan span("Binlog::write_snapshot");
+    uint64_t seq;
+    std::vector<SnapshotEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        seq = next_seq - 1;
+        if (seq == snapshot_seq)
+            return true;
+        entries.reserve(state.size());
+        for (const auto &entry : state)
+        {
+            const LoggedMarketState &s = entry.second;
+            entries.push_back(SnapshotEntry{entry.first, 0, s.order_count, s.q_yes, s.q_no, s.event_funds.micros(),
+                                            s.aggregates.yes_stake.micros(), s.aggregates.no_stake.micros(),
+                                            s.aggregates.largest_stake.micros(), s.aggregates.yes_liability.micros(),
+                                            s.aggregates.no_liability.micros()});
+        }
+    }
+    if (!sync_to(seq))
+        return false;
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.seq = seq;
+    header.count = entries.size();
+    header.entry_bytes = sizeof(SnapshotEntry);
+    header.crc = crc32c(entries.data(), entries.size() * sizeof(SnapshotEntry));
+
+    std::string path = numbered(config.directory, "snapshot-", seq, ".snap");
+    std::string temp = path + ".tmp";
+    {
+        MappedFile file;
+        size_t bytes = sizeof(header) + entries.size() * sizeof(SnapshotEntry);
+        if (!file.open(temp, bytes))
+        {
+            log_error("Cannot write binlog snapshot.", {{"path", temp}});
+            return false;
+        }
+        std::memcpy(file.data(), &header, sizeof(header));
+        if (!entries.empty())
+            std::memcpy(file.data() + sizeof(header), entries.data(), entries.size() * sizeof(SnapshotEntry));
+        if (!file.flush(0, bytes))
+        {
+            log_error("Cannot write binlog snapshot.", {{"path", temp}});
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec)
+    {
+        log_error("Cannot write binlog snapshot.", {{"path", path}, {"error", ec.message()}});
+        return false;
+    }
+    sync_directory(config.directory);
+    snapshot_seq = seq;
+    return true;
+}
+
+// drops older snapshots, and segments both SQLite and the snapshot cover
+void Binlog::prune()
+{
+    for (const auto &old : list_numbered(config.directory, "snapshot-", ".snap"))
+        if (old.first < snapshot_seq)
+            std::remove(old.second.c_str());
+
+    uint64_t covered;
+    {
+        std::lock_guard<std::mutex> lock(feed_mutex);
+        covered = std::min(snapshot_seq, fed);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // segment i ends where segment i + 1 begins; the last one is still appended to
+    while (segments.size() > 1 && segments[1].first_seq - 1 <= covered)
+    {
+        std::string path = segments.front().path;
+        segments.erase(segments.begin());
+        std::remove(path.c_str());
+    }
+}
+
+
+// ---------------- close ----------------
+void Binlog::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(feed_mutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    feed_cv.notify_all();
+    feeder.join();
+
+    sync_to(written.load(std::memory_order_acquire));
+    write_snapshot();
+    prune();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    segments.clear();
+    state.clear();
+    spare_ready = false;
+    std::remove(spare_path(config.directory).c_str());
+}
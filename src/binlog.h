@@ -0,0 +1,118 @@
+#pragma once
+#include "orders.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+
+struct BinlogConfig {
+    std::string directory = "binlog";
+    size_t segment_bytes = 64u << 20;                  // preallocated size of each segment file
+    std::chrono::seconds snapshot_interval{60};       // market state snapshot period
+};
+
+// A market's state as of its latest logged fill.
+struct LoggedMarketState {
+    double q_yes = 0.0;
+    double q_no = 0.0;
+    Money event_funds;
+    int64_t order_count = 0;
+    OrderAggregates aggregates;
+};
+
+class MappedFile;
+
+// Append-only fill log: the storage engine behind --storage=binlog.
+//
+// Every fill becomes one fixed-size, CRC-checked record (carrying the
+// market's absolute state after the fill) appended to a memory-mapped
+// segment file; making a fill durable is an msync of the pages it touched,
+// shared by every fill appended meanwhile. A background thread copies the
+// records into SQLite in large transactions (orders, events rows and the
+// fed position in `binlog_position`, so each record lands exactly once)
+// and periodically writes a snapshot of every market's logged state.
+//
+// Recovery loads the newest snapshot and replays the records after it; a
+// torn record at the end of the last segment (crash mid-append) ends the
+// log there. Segments are deleted once both SQLite and a snapshot cover them,
+// or at recovery when SQLite is past their end and the log resumes after it.
+//
+// A failed msync discards every record not yet on disk (the fills whose
+// callers are told they failed, and any ASYNC ones appended after the last
+// good flush) and refuses appends until the log is reopened.
+class Binlog {
+    private:
+        struct Segment {
+            uint64_t first_seq;
+            size_t capacity;                    // records
+            std::string path;
+            std::unique_ptr<MappedFile> file;
+        };
+
+        BinlogConfig config;
+        mutable std::mutex mutex;               // appends, segments, state
+        std::vector<Segment> segments;          // ascending first_seq; the last one is appended to
+        uint64_t next_seq = 1;
+        std::unordered_map<int, LoggedMarketState> state; // by event id, through next_seq - 1
+        std::atomic<uint64_t> written{0};       // records through this seq are complete in memory
+        bool spare_ready = false;               // the feeder has allocated the next segment's file (spare.seg.tmp)
+
+        std::mutex sync_mutex;                  // serialises msync calls
+        std::atomic<uint64_t> synced{0};        // ... and through this seq are on disk
+        bool failed = false;                    // an msync failed: appends are refused (set under both mutexes)
+
+        std::mutex feed_mutex;
+        std::condition_variable feed_cv;        // wakes the feeder (stop) and wait_fed() callers
+        uint64_t fed = 0;                       // records through this seq are in SQLite
+        uint64_t snapshot_seq = 0;              // newest snapshot covers through this seq
+        bool running = false;
+        std::thread feeder;
+
+        bool recover();
+        bool load_snapshot(std::unordered_map<int, LoggedMarketState> &into, uint64_t &seq) const;
+        void replay_state(uint64_t through);
+        bool write_snapshot();
+        void prune();
+        bool add_segment(uint64_t first_seq);
+        bool prepare_spare();
+        uint64_t segment_end(size_t i) const;
+        bool sync_to(uint64_t seq);
+        void discard_unsynced();
+        size_t read_records(uint64_t after, size_t max, std::vector<Fill> &out, uint64_t &last);
+        void feed_loop();
+
+    public:
+        Binlog();
+        ~Binlog();
+        Binlog(const Binlog &) = delete;
+        Binlog &operator=(const Binlog &) = delete;
+
+        // opens (creating if needed) the log in config.directory, recovers
+        // the logged market state and starts feeding SQLite; false on I/O
+        // error or a corrupt log
+        bool open(const BinlogConfig &config_);
+
+        // feeds SQLite everything logged, writes a final snapshot and closes
+        void close();
+
+        // appends the fills as consecutive records; with `durable`, returns
+        // once they are on disk. False if the log could not grow, the flush
+        // failed (the records are then gone) or an earlier flush failed.
+        bool append(const std::vector<Fill> &fills, bool durable);
+
+        // blocks until SQLite holds every record appended so far
+        void wait_fed();
+
+        // the logged state of a market; false if the log has no fill for it
+        bool logged_state(int event_id, LoggedMarketState &out) const;
+
+        uint64_t last_seq() const { return written.load(std::memory_order_acquire); }
+};
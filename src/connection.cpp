@@ -0,0 +1,95 @@
+#include "connection.h"
+#include "database.h" // for database_path
+#include "logger.h"
+#include "utils.h"
+
+
+DbConnection::~DbConnection()
+{
+    close();
+}
+
+// ---------------- open + per-connection pragmas ----------------
+bool DbConnection::open(const char *path_)
+{
+    close();
+
+    if (sqlite3_open(path_, &db) != SQLITE_OK)
+    {
+        error_msg("Can't open database: " + std::string(db ? sqlite3_errmsg(db) : "unknown"));
+        if (db)
+            sqlite3_close(db);
+        db = nullptr;
+        return false;
+    }
+
+    // connection-scoped settings, applied once instead of per statement
+    sqlite3_busy_timeout(db, 5000);
+    if (!exec("PRAGMA foreign_keys = ON;"))
+    {
+        close();
+        return false;
+    }
+
+    path = path_;
+    return true;
+}
+
+void DbConnection::close()
+{
+    for (auto &entry : statements)
+        sqlite3_finalize(entry.second);
+    statements.clear();
+
+    if (db)
+        sqlite3_close(db);
+    db = nullptr;
+    path.clear();
+}
+
+bool DbConnection::is_open_for(const char *path_) const
+{
+    return db != nullptr && path == path_;
+}
+
+const char *DbConnection::errmsg() const
+{
+    return db ? sqlite3_errmsg(db) : "database not open";
+}
+
+bool DbConnection::exec(const char *sql)
+{
+    char *errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
+    {
+        log_error("SQL error", {{"error", errMsg ? errMsg : ""}});
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+// ---------------- statement cache ----------------
+sqlite3_stmt *DbConnection::prepare(const char *sql)
+{
+    auto it = statements.find(sql);
+    if (it != statements.end())
+        return it->second;
+
+    sqlite3_stmt *stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK)
+        return nullptr;
+
+    statements.emplace(sql, stmt);
+    return stmt;
+}
+
+
+DbConnection *db_connection()
+{
+    thread_local DbConnection connection;
+
+    if (!connection.is_open_for(database_path) && !connection.open(database_path))
+        return nullptr;
+    return &connection;
+}
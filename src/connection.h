@@ -0,0 +1,62 @@
+#pragma once
+#include "sqlite3.h"
+#include <string>
+#include <unordered_map>
+
+
+// Long-lived SQLite connection that caches its prepared statements.
+// A connection is owned by exactly one thread (see db_connection()),
+// so neither the handle nor the statement cache needs locking.
+class DbConnection
+{
+    private:
+        sqlite3 *db = nullptr;
+        std::string path;
+        // keyed by the address of the SQL text: callers pass string literals
+        std::unordered_map<const char *, sqlite3_stmt *> statements;
+
+    public:
+        DbConnection() = default;
+        ~DbConnection();
+        DbConnection(const DbConnection &) = delete;
+        DbConnection &operator=(const DbConnection &) = delete;
+
+        bool open(const char *path_);
+        void close();
+        bool is_open_for(const char *path_) const;
+
+        sqlite3 *handle() const { return db; }
+        const char *errmsg() const;
+
+        // run a statement without result rows (BEGIN, COMMIT, PRAGMA ...)
+        bool exec(const char *sql);
+
+        // cached prepare; `sql` must have static storage duration
+        sqlite3_stmt *prepare(const char *sql);
+};
+
+// This thread's connection to `database_path`, opened on first use and
+// reopened if the path changed. Returns nullptr if the open failed.
+DbConnection *db_connection();
+
+
+// Resets a cached statement (and clears its bindings) when leaving scope,
+// so it can be reused by the next caller on this thread.
+class StmtGuard
+{
+    private:
+        sqlite3_stmt *stmt;
+
+    public:
+        explicit StmtGuard(sqlite3_stmt *stmt_) : stmt(stmt_) {}
+        ~StmtGuard()
+        {
+            if (stmt)
+            {
+                sqlite3_reset(stmt);
+                sqlite3_clear_bindings(stmt);
+            }
+        }
+        StmtGuard(const StmtGuard &) = delete;
+        StmtGuard &operator=(const StmtGuard &) = delete;
+};
@@ -1,73 +1,53 @@
 #include "contract.h"
-#include "database.h" // for new_order, update_event_state
-#include "utils.h"    // for new_order, update_event_state
+#include "journal.h"  // for order_journal
+#include "metrics.h"  // for TimedLock, metrics_count_order
+#include "logger.h"
+#include "quote_stream.h"
+#include "sequencer.h"
+#include "trace.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
 
 
-LMSRContract::LMSRContract(int contract_id_, const std::string &name_, double risk_cap_, double q_T_, double q_F_, double total_deposits_)
-    : contract_id(contract_id_), name(name_), risk_cap(risk_cap_), q_T(q_T_), q_F(q_F_), total_deposits(total_deposits_)
+static std::atomic<uint64_t> state_epoch{0};
+
+uint64_t market_state_epoch()
+{
+    return state_epoch.load(std::memory_order_acquire);
+}
+
+LMSRContract::LMSRContract(int contract_id_, const std::string &name_, double risk_cap_, double q_T_, double q_F_, Money total_deposits_, int64_t order_count_,
+                           const OrderAggregates &aggregates_)
+    : lmsr(risk_cap_, {q_T_, q_F_}), total_deposits(total_deposits_), order_count(order_count_), aggregates(aggregates_),
+      contract_id(contract_id_), name(name_)
 {
-    b = risk_cap / std::log(2);
+    publish_quote();
 }
 
 // ---------------- Cost function ----------------
+// C(q) = b*log(e^(qT/b) + e^(qF/b)) = max(qT, qF) + b*log1p(e^(-|qT-qF|/b))
 double LMSRContract::cost(double qT, double qF) const
 {
-    double m = std::max(qT, qF);
-    return b * (m/b + std::log(std::exp((qT-m)/b) + std::exp((qF-m)/b)));
+    return lmsr.cost({qT, qF});
 }
 
 // ---------------- Current price / odds ----------------
-std::map<Side, double> LMSRContract::price() const
+// binary LMSR price is the logistic of the inventory imbalance (q_side - q_other)/b
+double LMSRContract::price(Side side) const
 {
-    double m = std::max(q_T, q_F);
-    double exp_T = std::exp((q_T - m) / b);
-    double exp_F = std::exp((q_F - m) / b);
-    double total = exp_T + exp_F;
-    return {{Side::YES, exp_T / total}, {Side::NO, exp_F / total}};
+    return lmsr.price(outcome(side));
 }
 
 // ---------------- compute max stake ----------------
+// one size for both sides, from the YES price (the NO price gives the same
+// effect)
 double LMSRContract::max_stake() const
 {
-    // remaining risk
-    double remaining_risk = risk_cap - (cost(q_T, q_F) - cost(0, 0));
-    if (remaining_risk <= 0)
-        return 0.0;
-
-    // binary search to find dq such that adding dq shares consumes remaining risk
-    double low = 0.0;
-    double high = 1.0;
-    double base_cost = cost(q_T, q_F);
-
-    // expand high until cost increase exceeds remaining risk
-    for (int i = 0; i < 60; ++i) {
-        double new_cost = cost(q_T + high, q_F + high); // both sides incremented
-        if (new_cost - base_cost >= remaining_risk)
-            break;
-        high *= 2.0;
-    }
-
-    // binary search
-    for (int i = 0; i < 60; ++i) {
-        double mid = 0.5 * (low + high);
-        double new_cost = cost(q_T + mid, q_F + mid);
-        if (new_cost - base_cost < remaining_risk)
-            low = mid;
-        else
-            high = mid;
-    }
-
-    double dq = 0.5 * (low + high);
-
-    // use current LMSR price (mid-point probability) for stake calculation
-    auto p = price();
-    double p_self = p.at(Side::YES); // could also use NO, same effect
-
-    double max_stake = b * p_self * (std::exp(dq / b) - 1.0);
-    return max_stake;
+    return lmsr.max_stake(outcome(Side::YES));
 }
 
 
@@ -75,72 +55,264 @@ double LMSRContract::max_stake() const
 
 
 // ---------------- Trade Execution ----------------
-Order LMSRContract::buy(Side side, double stake)
+OrderStatus LMSRContract::execute(Side side, Money stake, Order &order, Fill &fill)
 {
-    // ensure thread safety
-    std::lock_guard<std::mutex> guard(contract_mutex); 
+    TraceSpan span("LMSRContract::execute");
+    if (closed)
+        return OrderStatus::MARKET_CLOSED;
 
-    // Compute current max stake allowed for this side
-    double current_loss = cost(q_T, q_F) - cost(0, 0);
-    double remaining_risk = risk_cap - current_loss;
+    if (stake <= Money())
+        return OrderStatus::INVALID_ORDER;
 
-    if (remaining_risk <= 0.0) {
-        warning_msg("Market has reached risk capacity. Order ignored.");
-        return Order{}; // no room for trades
+    // Compute current max stake allowed for this side
+    if (lmsr.remaining_risk() <= 0.0) {
+        log_warn("Market has reached risk capacity. Order ignored.", {{"event_id", contract_id}});
+        return OrderStatus::RISK_CAP_REACHED; // no room for trades
     }
 
     // Compute max stake that would fit without exceeding risk_cap
-    auto current_prices = price();
-    double p_self = (side == Side::YES) ? current_prices[Side::YES] : current_prices[Side::NO];
     double max_stake_allowed = max_stake();  // approximate
-    if (stake > max_stake_allowed) {
-        warning_msg("Stake: $" + std::to_string(round_figure(stake)) + " exceeds max allowed: $" + std::to_string(round_figure(max_stake_allowed)) + "  for this market. Order ignored.");
-        return Order{}; // refuse the order
+    double amount = stake.to_double();
+    if (amount > max_stake_allowed) {
+        log_warn("Stake exceeds max allowed for this market. Order ignored.",
+                 {{"event_id", contract_id}, {"stake", stake}, {"max_stake", max_stake_allowed}});
+        return OrderStatus::EXCEEDS_MAX_STAKE; // refuse the order
     }
 
-    // Compute delta_q exactly for two-outcome LMSR
-    double delta_q = b * std::log(1 + stake / (b * p_self));
-
     // Update quantities
-    if (side == Side::YES)
-        q_T += delta_q;
-    else
-        q_F += delta_q;
+    lmsr.add_shares(outcome(side), lmsr.shares_for_stake(outcome(side), amount));
 
     total_deposits += stake;
+    ++order_count;
 
     // Recalculate price after update
-    current_prices = price();
-    double side_price = (side == Side::YES) ? current_prices[Side::YES] : current_prices[Side::NO];
+    double side_price = price(side);
 
     // Create order object
-    Order order{contract_id, stake, round_figure(side_price), round_figure(stake / side_price), side, 0.0};
+    order = Order{contract_id, stake, Money::from_double(side_price), Money::from_double(amount / side_price), side, Money()};
+    aggregates.add(side, stake, order.expected_cashout);
+    fill = Fill{contract_id, side, stake, order.price, order.expected_cashout, lmsr.quantity(0), lmsr.quantity(1),
+                total_deposits, order_count, aggregates};
+    return OrderStatus::FILLED;
+}
+
+Order LMSRContract::buy(Side side, Money stake, OrderStatus *status)
+{
+    TraceSpan span("LMSRContract::buy");
+    OrderStatus result;
+    if (!status)
+        status = &result;
+
+    Order order;
+    if (!order_sequencer().buy(*this, side, stake, order, *status))
+        order = place_order(side, stake, status);
+    metrics_count_order(*status);
+    return order;
+}
+
+Order LMSRContract::place_order(Side side, Money stake, OrderStatus *status)
+{
+    Order order;
+    std::future<bool> durable;
+    State before;
 
-    // Persist to database
-    new_order(contract_id, (side == Side::YES), stake, order.price, order.expected_cashout);
-    update_event_state(contract_id, q_T, q_F, total_deposits);
+    {
+        // ensure thread safety
+        TimedLock guard(contract_mutex);
+
+        // kept aside until the fill is persisted
+        before = save_state();
+
+        Fill fill;
+        *status = execute(side, stake, order, fill);
+        if (*status != OrderStatus::FILLED)
+            return Order{};
+
+        // Persist order + new state in one transaction before confirming
+        Durability durability = order_journal().durability();
+        if (durability == Durability::SYNC || durability == Durability::NONE) {
+            if (durability == Durability::SYNC && !order_journal().persist({fill})) {
+                restore_state(before);
+                *status = OrderStatus::PERSIST_FAILED;
+                return Order{};
+            }
+            publish_quote();
+            return order;
+        }
+
+        // group/async commit: wait outside the lock so later orders on this
+        // market can join the same batch
+        durable = order_journal().submit({fill});
+        publish_quote();
+    }
 
+    bool persisted;
+    {
+        TraceSpan wait("journal wait");
+        persisted = durable.get();
+    }
+    if (!persisted) {
+        fail_closed(before);
+        *status = OrderStatus::PERSIST_FAILED;
+        return Order{};
+    }
     return order;
 }
 
+void LMSRContract::fail_closed(const State &before)
+{
+    TimedLock guard(contract_mutex);
+    if (before.order_count < order_count) {
+        restore_state(before);
+        publish_quote();
+    }
+    if (!closed)
+        log_error("Market closed: a fill could not be persisted and was rolled back.", {{"event_id", contract_id}});
+    closed = true;
+}
 
+// ---------------- Batch Execution ----------------
+std::vector<LMSRContract::BatchResult> LMSRContract::buy_batch(const std::vector<BatchLeg> &legs)
+{
+    TraceSpan span("LMSRContract::buy_batch");
+    std::future<bool> durable;
+    std::vector<BatchUndo> undo;
+    std::vector<BatchResult> results = execute_batch(legs, durable, undo);
+
+    if (durable.valid()) {
+        TraceSpan wait("journal wait");
+        if (!durable.get()) {
+            fail_filled(results);
+            undo_batch(undo);
+        }
+    }
+    // legs without a market are counted by the caller, which knows why
+    for (size_t i = 0; i < legs.size(); ++i)
+        if (legs[i].contract)
+            metrics_count_order(results[i].status);
+    return results;
+}
+
+std::vector<LMSRContract::BatchResult> LMSRContract::execute_batch(const std::vector<BatchLeg> &legs, std::future<bool> &durable,
+                                                                   std::vector<BatchUndo> &undo, bool independent)
+{
+    std::vector<BatchResult> results(legs.size(), BatchResult{OrderStatus::MARKET_NOT_FOUND, Order{}});
+
+    // lock ordering: every distinct market once, by ascending contract_id
+    std::vector<LMSRContract *> touched;
+    for (const auto &leg : legs)
+        if (leg.contract)
+            touched.push_back(leg.contract);
+    std::sort(touched.begin(), touched.end(), [](const LMSRContract *a, const LMSRContract *b) {
+        return a->contract_id < b->contract_id;
+    });
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    std::vector<TimedLock> locks;
+    std::vector<State> before;
+    locks.reserve(touched.size());
+    before.reserve(touched.size());
+    for (LMSRContract *contract : touched) {
+        locks.emplace_back(contract->contract_mutex);
+        before.push_back(contract->save_state());
+    }
+
+    std::vector<Fill> fills;
+    for (size_t i = 0; i < legs.size(); ++i) {
+        if (!legs[i].contract)
+            continue;
+        Fill fill;
+        results[i].status = legs[i].contract->execute(legs[i].side, legs[i].stake, results[i].order, fill);
+        if (results[i].status == OrderStatus::FILLED)
+            fills.push_back(fill);
+    }
+
+    Durability durability = order_journal().durability();
+    if (durability == Durability::SYNC) {
+        if (!order_journal().persist(fills)) {
+            for (size_t k = 0; k < touched.size(); ++k)
+                touched[k]->restore_state(before[k]);
+            if (!independent) {
+                fail_filled(results);
+                return results;
+            }
+            // separate orders: redo each with its own commit, as the
+            // single-order path would have, so a bad fill fails only itself
+            for (size_t i = 0; i < legs.size(); ++i) {
+                LMSRContract *contract = legs[i].contract;
+                if (!contract)
+                    continue;
+                State leg_before = contract->save_state();
+                Fill fill;
+                results[i] = BatchResult{OrderStatus::FILLED, Order{}};
+                results[i].status = contract->execute(legs[i].side, legs[i].stake, results[i].order, fill);
+                if (results[i].status == OrderStatus::FILLED && !order_journal().persist({fill})) {
+                    contract->restore_state(leg_before);
+                    results[i] = BatchResult{OrderStatus::PERSIST_FAILED, Order{}};
+                }
+            }
+        }
+    } else if (durability != Durability::NONE && !fills.empty()) {
+        durable = order_journal().submit(std::move(fills));
+        for (size_t k = 0; k < touched.size(); ++k)
+            if (touched[k]->order_count != before[k].order_count)
+                undo.push_back(BatchUndo{touched[k], before[k]});
+    }
+
+    for (LMSRContract *contract : touched)
+        contract->publish_quote();
+    return results;
+}
+
+void LMSRContract::undo_batch(const std::vector<BatchUndo> &undo)
+{
+    for (const BatchUndo &market : undo)
+        market.contract->fail_closed(market.before);
+}
+
+void LMSRContract::fail_filled(std::vector<BatchResult> &results)
+{
+    for (BatchResult &result : results)
+        if (result.status == OrderStatus::FILLED)
+            result = BatchResult{OrderStatus::PERSIST_FAILED, Order{}};
+}
 
-// ---------------- pull realtime quote ----------------
-Quote LMSRContract::generate_quote() const {
-    // ensure thread safety
-    std::lock_guard<std::mutex> guard(contract_mutex); 
 
-    auto p = price(); // current LMSR prices
 
+// ---------------- publish quote snapshot ----------------
+// caller holds contract_mutex (or is the constructor)
+void LMSRContract::publish_quote()
+{
     // YES and NO prices from LMSR
-    double yes_price = p.at(Side::YES);
-    double no_price  = p.at(Side::NO);
+    double yes_price = price(Side::YES);
+    double no_price  = price(Side::NO);
 
     // Maximum trade size based on remaining risk
     double size = max_stake();
 
-    return Quote{yes_price, no_price, size};
+    Quote quote{yes_price, no_price, size, ++quote_version};
+    market_snapshot.store(MarketSnapshot{quote, lmsr.quantity(0), lmsr.quantity(1), total_deposits, order_count, aggregates});
+    state_epoch.fetch_add(1, std::memory_order_release);
+    // the constructor's first publish is a new market, not a change
+    if (quote_version > 1)
+        quote_stream().notify(*this);
+}
+
+// ---------------- close market ----------------
+void LMSRContract::close()
+{
+    std::lock_guard<std::mutex> guard(contract_mutex);
+    closed = true;
+}
+
+// ---------------- pull realtime quote ----------------
+// lock-free: readers never wait behind a fill that is committing to disk
+Quote LMSRContract::generate_quote() const {
+    return market_snapshot.load().quote;
+}
 
+MarketSnapshot LMSRContract::snapshot() const {
+    return market_snapshot.load();
 }
 
 
@@ -149,38 +321,9 @@ Quote LMSRContract::generate_quote() const {
 
 
 // ---------------- Solve delta_q for LMSR ----------------
+// shares of `side` that cost exactly `money`:
+// C(q + d*e_side) - C(q) = money  =>  d = b*log1p(expm1(money/b) / p_side)
 double LMSRContract::solve_delta_q(Side side, double money) const
 {
-    double low = 0.0;
-    double high = 1.0;
-
-    // 1. Expand high bound until cost_inc exceeds money
-    for (int i = 0; i < 60; ++i)
-    {
-        double cost_inc =
-            (side == Side::YES)
-                ? cost(q_T + high, q_F) - cost(q_T, q_F)
-                : cost(q_T, q_F + high) - cost(q_T, q_F);
-
-        if (cost_inc >= money)
-            break;     // high is now big enough
-        high *= 2;     // expand exponentially
-    }
-
-    // 2. Binary search
-    for (int i = 0; i < 60; ++i)
-    {
-        double mid = 0.5 * (low + high);
-        double cost_inc =
-            (side == Side::YES)
-                ? cost(q_T + mid, q_F) - cost(q_T, q_F)
-                : cost(q_T, q_F + mid) - cost(q_T, q_F);
-
-        if (cost_inc < money)
-            low = mid;
-        else
-            high = mid;
-    }
-
-    return 0.5 * (low + high);
+    return lmsr.solve_delta_q(outcome(side), money);
 }
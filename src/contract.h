@@ -1,9 +1,13 @@
 // contract.h
 #pragma once
+#include "lmsr_engine.h"
 #include "orders.h"
+#include "seqlock.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
 #include <vector>
 #include <string>
-#include <map>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
@@ -15,30 +19,118 @@ struct Quote {
     double price_no;      // LMSR NO mid-price (1 - price_yes)
 
     double size;         // maximum stake size for either side
+
+    uint64_t version;    // bumped every time the market state changes
+};
+
+// Everything a reader needs about a market, published after each fill.
+struct MarketSnapshot {
+    Quote quote;
+    double q_T;
+    double q_F;
+    Money total_deposits;
+    int64_t order_count;
+    OrderAggregates aggregates;
 };
 
+// Bumped after every snapshot publish of any market: a cheap "has anything
+// changed" check for views over all markets (GET /events).
+uint64_t market_state_epoch();
+
 class LMSRContract {
     private:
         mutable std::mutex contract_mutex; 
-        double risk_cap;
-        double b;
-        double q_T;
-        double q_F;
-        double total_deposits;
+        LmsrEngine<2> lmsr;            // q = {YES, NO}
+        Money total_deposits;
+        int64_t order_count;
+        OrderAggregates aggregates;
+
+        // last published state; written under contract_mutex, read lock-free
+        SeqLock<MarketSnapshot> market_snapshot;
+        uint64_t quote_version = 0;
+        bool closed = false;
+        void publish_quote();
+
+        // set while the market waits in the quote stream's next dispatch
+        friend class QuoteStream;
+        std::atomic<bool> stream_queued{false};
+
+        // market state saved before a fill so it can be undone
+        struct State { LmsrEngine<2>::Quantities q; Money total_deposits; int64_t order_count; OrderAggregates aggregates; };
+        State save_state() const { return State{lmsr.quantities(), total_deposits, order_count, aggregates}; }
+        void restore_state(const State &s)
+        {
+            lmsr.set_quantities(s.q); total_deposits = s.total_deposits; order_count = s.order_count; aggregates = s.aggregates;
+        }
+
+        static size_t outcome(Side side) { return side == Side::YES ? 0 : 1; }
+
+        // a GROUP commit of a fill made from `before` failed: go back to
+        // `before` (unless an earlier failed fill already went further back)
+        // and stop trading; the journal fails every later fill of the market
+        void fail_closed(const State &before);
+
+        // applies one order to the in-memory state; caller holds contract_mutex
+        OrderStatus execute(Side side, Money stake, Order &order, Fill &fill);
+
+        // buy() without the bookkeeping: lock, execute, persist
+        Order place_order(Side side, Money stake, OrderStatus *status);
     public:
         int contract_id;
         std::string name;
 
     
-    LMSRContract(int contract_id_, const std::string &name_, double risk_cap_ = 100.0, double q_T_ = 0.0, double q_F_ = 0.0, double total_deposits_ = 0.0);
+    LMSRContract(int contract_id_, const std::string &name_, double risk_cap_ = 100.0, double q_T_ = 0.0, double q_F_ = 0.0, Money total_deposits_ = Money(), int64_t order_count_ = 0,
+                 const OrderAggregates &aggregates_ = OrderAggregates{});
     
     double cost(double qT, double qF) const;
-    std::map<Side,double> price() const;
-    Order buy(Side side, double stake);
+    double price(Side side) const;
+    Order buy(Side side, Money stake, OrderStatus *status = nullptr);
     double solve_delta_q(Side side, double money) const;
     double max_stake() const;
     
     Quote generate_quote() const;
+    MarketSnapshot snapshot() const;
+
+    // fixed at construction, safe to read without the lock
+    double liquidity_param() const { return lmsr.liquidity(); }
+    double risk_limit() const { return lmsr.risk_limit(); }
+
+    // stop accepting orders; returns once any in-flight buy has finished
+    void close();
+
+    // One order of a batch; `contract` is nullptr when the market was not found.
+    struct BatchLeg {
+        LMSRContract *contract;
+        Side side;
+        Money stake;
+    };
+    struct BatchResult {
+        OrderStatus status;
+        Order order;
+    };
+    // a market a batch filled, and its state before the batch
+    struct BatchUndo {
+        LMSRContract *contract;
+        State before;
+    };
+
+    // Executes the legs in order and persists all fills in one transaction.
+    // Results of legs with a market are counted in the order metrics.
+    // Markets are locked in ascending contract_id order (each once), so
+    // concurrent batches and single orders cannot deadlock.
+    static std::vector<BatchResult> buy_batch(const std::vector<BatchLeg> &legs);
+
+    // buy_batch() up to the journal: with GROUP/ASYNC durability the fills
+    // are submitted and `durable` is left to the caller, who must turn the
+    // FILLED results into PERSIST_FAILED (fail_filled) and undo_batch(undo)
+    // if it comes back false. With `independent` legs (separate orders, not
+    // one batch) a failed SYNC commit is retried one order at a time rather
+    // than failing every leg. Counts no metrics.
+    static std::vector<BatchResult> execute_batch(const std::vector<BatchLeg> &legs, std::future<bool> &durable,
+                                                  std::vector<BatchUndo> &undo, bool independent = false);
+    static void fail_filled(std::vector<BatchResult> &results);
+    static void undo_batch(const std::vector<BatchUndo> &undo);
 };
 
 
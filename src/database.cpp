@@ -1,71 +1,34 @@
 #include "database.h"
+#include "connection.h"
+#include "logger.h"
+#include "metrics.h"
+#include "migrations.h"
+#include "trace.h"
 #include "utils.h"
 
 const char *database_path = "database.db";
 
-// Function to initialize the database and create necessary tables
+// Function to initialize the database and bring its schema up to date
 int initialize_database()
 {
-    sqlite3 *db;
-
-    if (sqlite3_open(database_path, &db))
+    TraceSpan span("initialize_database");
+    DbConnection *conn = db_connection();
+    if (!conn)
     {
-        error_msg("Failed to open database." + std::string(sqlite3_errmsg(db)));
+        error_msg("Failed to open database.");
         return 1;
     }
 
-    const char *events_sql = R"(
-        CREATE TABLE IF NOT EXISTS events (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            tag TEXT NOT NULL UNIQUE,
-            name TEXT NOT NULL,
-            risk_cap REAL,
-            outcome BOOLEAN DEFAULT NULL,
-            resolved BOOLEAN DEFAULT 0,
-            q_yes REAL DEFAULT 0,
-            q_no REAL DEFAULT 0,
-            event_funds REAL DEFAULT 0,
-            win_payout REAL DEFAULT 0,
-            order_count INTEGER DEFAULT 0,
-            profit_loss REAL DEFAULT 0,
-            maturity DATETIME NOT NULL,
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-            resolved_at DATETIME NULL
-        );
-    )";
-
-    const char *order_book_sql = R"(
-        CREATE TABLE IF NOT EXISTS order_book (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            event_id INTEGER NOT NULL,
-            side INTEGER NOT NULL,
-            stake REAL NOT NULL,
-            expected_cashout REAL NOT NULL,
-            price REAL NOT NULL,
-            pay_out REAL DEFAULT NULL,
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-            FOREIGN KEY(event_id) REFERENCES events(id)
-        );
-    )";
-
-    char *errMsg = nullptr;
-    if (sqlite3_exec(db, events_sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
-    {
-        error_msg("SQL error (events table): " + std::string(errMsg));
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
+    // tables and indexes live in versioned migrations (migrations.cpp)
+    if (!migrate_database(conn))
         return 1;
-    }
 
-    if (sqlite3_exec(db, order_book_sql, nullptr, nullptr, &errMsg) != SQLITE_OK)
-    {
-        error_msg("SQL error (order_book table): " + std::string(errMsg));
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
+    // WAL lets quote/list readers proceed while a fill commits, and makes
+    // each commit a single append + fsync of the log. The mode is stored in
+    // the database file, so setting it here covers every later connection.
+    if (!conn->exec("PRAGMA journal_mode = WAL;"))
         return 1;
-    }
 
-    sqlite3_close(db);
     return 0;
 }
 
@@ -73,8 +36,9 @@ int initialize_database()
 ** Event Related Functions
 *************************************************************************/
 /** create a new event in the events table */
-int new_event(const std::string &tag, const std::string &name, const std::string &maturity, double risk_cap)
+int new_event(const std::string &tag, const std::string &name, const std::string &maturity, Money risk_cap)
 {
+    TraceSpan span("new_event");
     // maturity must follow "YYYY-MM-DD HH:MM:SS"
 
     if (!valid_maturity(maturity))
@@ -122,58 +86,49 @@ int new_event(const std::string &tag, const std::string &name, const std::string
         return -1;
     }
 
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
-    int rc = sqlite3_open(database_path, &db);
-    if (rc != SQLITE_OK)
-    {
-        error_msg("Can't open database: " + std::string(db ? sqlite3_errmsg(db) : "unknown"));
-        if (db)
-            sqlite3_close(db);
+    DbConnection *conn = db_connection();
+    if (!conn)
         return -1;
-    }
+    sqlite3 *db = conn->handle();
 
     // Check for existing tag to avoid UNIQUE constraint error
     const char *check_sql = "SELECT id FROM events WHERE tag = ?;";
-    rc = sqlite3_prepare_v2(db, check_sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(check_sql);
+    if (!stmt)
     {
         error_msg("Failed to prepare tag-check statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
         return -1;
     }
-    sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_TRANSIENT);
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW)
     {
-        int existing_id = sqlite3_column_int(stmt, 0);
-        error_msg("Event with tag '" + tag + "' already exists (id=" + to_string_safe(existing_id) + ").");
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        return -1;
+        StmtGuard guard(stmt);
+        sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            int existing_id = sqlite3_column_int(stmt, 0);
+            error_msg("Event with tag '" + tag + "' already exists (id=" + to_string_safe(existing_id) + ").");
+            return -1;
+        }
     }
-    sqlite3_finalize(stmt);
-    stmt = nullptr;
 
     const char *sql = R"(
         INSERT INTO events (tag, name, risk_cap, maturity)
         VALUES (?, ?, ?, ?)
     )";
 
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
-    if (rc != SQLITE_OK)
+    stmt = conn->prepare(sql);
+    if (!stmt)
     {
         error_msg("Failed to prepare insert statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
         return -1;
     }
+    StmtGuard guard(stmt);
 
     sqlite3_bind_text(stmt, 1, tag.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, name.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_double(stmt, 3, risk_cap);
+    sqlite3_bind_int64(stmt, 3, risk_cap.micros());
     sqlite3_bind_text(stmt, 4, maturity.c_str(), -1, SQLITE_TRANSIENT);
 
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     int new_id = -1;
     if (rc != SQLITE_DONE)
     {
@@ -185,277 +140,106 @@ int new_event(const std::string &tag, const std::string &name, const std::string
         success_msg("Event added successfully (id=" + to_string_safe(new_id) + ").");
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-
     return new_id;
 }
 
-// update event outcome and resolve it
-void resolve_event_outcome(int event_id, bool outcome)
+// resolve an event synchronously: the same chunked settlement the
+// background settler runs (see Settlement Related Functions)
+bool resolve_event_outcome(int event_id, bool outcome)
 {
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
-    char *errMsg = nullptr;
-
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(sqlite3_errmsg(db)));
-        if (db)
-            sqlite3_close(db);
-        return;
-    }
-
-    // Begin transaction
-    if (sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-    {
-        error_msg("Failed to begin transaction: " + std::string(errMsg ? errMsg : ""));
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
-        return;
-    }
-
-    bool success = true;
-    double event_funds = 0.0;
-    double win_payout = 0.0;
-    int resolved_flag = 0;
-
-    // Check if event already resolved & get event funds + current win_payout
-    const char *select_event_sql = "SELECT resolved, event_funds, win_payout FROM events WHERE id = ?;";
-    if (sqlite3_prepare_v2(db, select_event_sql, -1, &stmt, nullptr) != SQLITE_OK)
-    {
-        error_msg("Failed to prepare select statement: " + std::string(sqlite3_errmsg(db)));
-        success = false;
-    }
-    else
-    {
-        sqlite3_bind_int(stmt, 1, event_id);
-
-        if (sqlite3_step(stmt) == SQLITE_ROW)
-        {
-            resolved_flag = sqlite3_column_int(stmt, 0);
-            event_funds = sqlite3_column_double(stmt, 1);
-            win_payout = sqlite3_column_double(stmt, 2);
-
-            if (resolved_flag)
-            {
-                error_msg("Event already resolved (id=" + std::to_string(event_id) + ").");
-                success = false;
-            }
-        }
-        else
-        {
-            error_msg("Event not found (id=" + std::to_string(event_id) + ").");
-            success = false;
-        }
-        sqlite3_finalize(stmt);
-    }
-
-    if (success)
-    {
-        // Prepare select + update statements for order payouts
-        const char *select_orders_sql = R"(
-            SELECT id, side, expected_cashout
-            FROM order_book
-            WHERE event_id = ? AND pay_out IS NULL;
-        )";
-
-        const char *update_order_sql = R"(
-            UPDATE order_book
-            SET pay_out = ?
-            WHERE id = ?;
-        )";
-
-        sqlite3_stmt *select_orders_stmt = nullptr;
-        sqlite3_stmt *update_order_stmt = nullptr;
-
-        if (sqlite3_prepare_v2(db, select_orders_sql, -1, &select_orders_stmt, nullptr) != SQLITE_OK)
-        {
-            error_msg("Failed to prepare select statement for orders: " + std::string(sqlite3_errmsg(db)));
-            success = false;
-        }
-
-        if (success && sqlite3_prepare_v2(db, update_order_sql, -1, &update_order_stmt, nullptr) != SQLITE_OK)
-        {
-            error_msg("Failed to prepare update statement for orders: " + std::string(sqlite3_errmsg(db)));
-            success = false;
-        }
-
-        double total_payouts = 0.0;
-
-        // Iterate through orders and update payouts
-        if (success)
-        {
-            sqlite3_bind_int(select_orders_stmt, 1, event_id);
-
-            while (sqlite3_step(select_orders_stmt) == SQLITE_ROW)
-            {
-                int order_id = sqlite3_column_int(select_orders_stmt, 0);
-                int side_int = sqlite3_column_int(select_orders_stmt, 1);
-                double expected_cashout = sqlite3_column_double(select_orders_stmt, 2);
-
-                bool order_side = (side_int != 0);
-                double payout = (order_side == outcome) ? expected_cashout : 0.0;
-                total_payouts += payout;
-
-                sqlite3_reset(update_order_stmt);
-                sqlite3_clear_bindings(update_order_stmt);
-                sqlite3_bind_double(update_order_stmt, 1, payout);
-                sqlite3_bind_int(update_order_stmt, 2, order_id);
-
-                if (sqlite3_step(update_order_stmt) != SQLITE_DONE)
-                {
-                    error_msg("Failed to update order payout (id=" + std::to_string(order_id) + "): " + std::string(sqlite3_errmsg(db)));
-                    success = false;
-                    break;
-                }
-            }
-        }
-
-        if (select_orders_stmt)
-            sqlite3_finalize(select_orders_stmt);
-        if (update_order_stmt)
-            sqlite3_finalize(update_order_stmt);
-
-        // Update event record with aggregated payouts & profit/loss
-        if (success)
-        {
-            const char *update_event_sql = R"(
-        UPDATE events
-        SET outcome = ?,
-            resolved = 1,
-            win_payout = COALESCE(win_payout, 0) + ?,
-            profit_loss = COALESCE(event_funds, 0) - ?,
-            resolved_at = CURRENT_TIMESTAMP
-        WHERE id = ?;
-    )";
-
-            if (sqlite3_prepare_v2(db, update_event_sql, -1, &stmt, nullptr) == SQLITE_OK)
-            {
-                sqlite3_bind_int(stmt, 1, outcome ? 1 : 0);  // outcome
-                sqlite3_bind_double(stmt, 2, total_payouts); // win_payout
-                sqlite3_bind_double(stmt, 3, total_payouts); // profit_loss = event_funds - win_payout
-                sqlite3_bind_int(stmt, 4, event_id);         // event_id
-
-                if (sqlite3_step(stmt) != SQLITE_DONE)
-                {
-                    error_msg("Failed to update event aggregates (id=" + std::to_string(event_id) + "): " + std::string(sqlite3_errmsg(db)));
-                    success = false;
-                }
-                sqlite3_finalize(stmt);
-            }
-            else
-            {
-                error_msg("Failed to prepare event update statement: " + std::string(sqlite3_errmsg(db)));
-                success = false;
-            }
-        }
-    }
-
-    // Commit or rollback transaction
-    if (success)
-    {
-        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-        {
-            error_msg("Failed to commit transaction: " + std::string(errMsg ? errMsg : ""));
-            sqlite3_free(errMsg);
-        }
-    }
-    else
-    {
-        if (sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-        {
-            error_msg("Failed to rollback transaction: " + std::string(errMsg ? errMsg : ""));
-            sqlite3_free(errMsg);
-        }
-    }
-
-    sqlite3_close(db);
+    TraceSpan span("resolve_event_outcome");
+    Settlement settlement;
+    if (!begin_settlement(event_id, outcome) || !load_settlement(event_id, settlement))
+        return false;
+
+    int settled;
+    while ((settled = settle_order_chunk(settlement, 5000)) > 0)
+        ;
+    return settled == 0 && finish_settlement(settlement);
 }
 
-// update event order counts or other stats
-void update_event_state(int event_id, double q_yes, double q_no, double event_funds)
+static Money column_money(sqlite3_stmt *stmt, int column)
 {
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
-
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(sqlite3_errmsg(db)));
-        return;
-    }
-
-    // Round values to 2 decimal places
-    q_yes = q_yes;
-    q_no = q_no;
-    event_funds = round_figure(event_funds);
+    return Money::from_micros(sqlite3_column_int64(stmt, column));
+}
 
-    // Update event: q_yes, q_no, event_funds, increment order_count
-    const char *sql = R"(
-        UPDATE events
-        SET q_yes = ?,
-            q_no = ?,
-            event_funds = ?,
-            order_count = order_count + 1
-        WHERE id = ?
-    )";
+// fill an Event from a row of the standard 20-column events select
+static void read_event_row(sqlite3_stmt *stmt, Event &ev)
+{
+    ev.id = sqlite3_column_int(stmt, 0);
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
-    {
-        error_msg("Failed to prepare update statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
-        return;
-    }
+    const unsigned char *txt = sqlite3_column_text(stmt, 1);
+    ev.tag = txt ? reinterpret_cast<const char *>(txt) : std::string();
 
-    sqlite3_bind_double(stmt, 1, q_yes);
-    sqlite3_bind_double(stmt, 2, q_no);
-    sqlite3_bind_double(stmt, 3, event_funds);
-    sqlite3_bind_int(stmt, 4, event_id);
+    txt = sqlite3_column_text(stmt, 2);
+    ev.name = txt ? reinterpret_cast<const char *>(txt) : std::string();
 
-    int rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE)
-    {
-        error_msg("Failed to update event state: " + std::string(sqlite3_errmsg(db)));
-    }
+    ev.risk_cap = column_money(stmt, 3);
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
+    // NULL: not resolved and not being settled
+    if (sqlite3_column_type(stmt, 4) == SQLITE_NULL)
+        ev.outcome = std::nullopt;
+    else
+        ev.outcome = sqlite3_column_int(stmt, 4) != 0;
+    ev.resolved = sqlite3_column_int(stmt, 5) != 0;
+    ev.q_yes = sqlite3_column_double(stmt, 6);
+    ev.q_no = sqlite3_column_double(stmt, 7);
+    ev.event_funds = column_money(stmt, 8);
+    ev.win_payout = column_money(stmt, 9);
+    ev.order_count = sqlite3_column_int(stmt, 10);
+    ev.profit_loss = column_money(stmt, 11);
+
+    txt = sqlite3_column_text(stmt, 12);
+    ev.maturity = txt ? reinterpret_cast<const char *>(txt) : std::string();
+
+    txt = sqlite3_column_text(stmt, 13);
+    ev.created_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
+
+    txt = sqlite3_column_text(stmt, 14);
+    ev.resolved_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
+
+    ev.aggregates.yes_stake = column_money(stmt, 15);
+    ev.aggregates.no_stake = column_money(stmt, 16);
+    ev.aggregates.largest_stake = column_money(stmt, 17);
+    ev.aggregates.yes_liability = column_money(stmt, 18);
+    ev.aggregates.no_liability = column_money(stmt, 19);
 }
 
 // retrieve event details (for future use)
 Event get_event_details(const std::string &id_or_tag)
 {
-    Event ev = Event{0, "", "", 0.0, std::nullopt, false, 0.0, 0.0, 0.0, 0.0, 0, 0.0, "", "", std::nullopt};
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
+    TraceSpan span("get_event_details");
+    Event ev = Event{0, "", "", Money(), std::nullopt, false, 0.0, 0.0, Money(), Money(), 0, Money(), "", "", std::nullopt, OrderAggregates{}};
 
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(db ? sqlite3_errmsg(db) : "unknown"));
-        if (db)
-            sqlite3_close(db);
+    DbConnection *conn = db_connection();
+    if (!conn)
         return ev;
-    }
 
-    std::string sql = R"(
+    const char *by_id_sql = R"(
         SELECT id, tag, name, risk_cap, outcome, resolved, q_yes, q_no, event_funds,
-               win_payout, order_count, profit_loss, maturity, created_at, resolved_at
+               win_payout, order_count, profit_loss, maturity, created_at, resolved_at,
+               yes_stake, no_stake, largest_stake, yes_liability, no_liability
         FROM events
-        WHERE
+        WHERE id = ?;
+    )";
+
+    const char *by_tag_sql = R"(
+        SELECT id, tag, name, risk_cap, outcome, resolved, q_yes, q_no, event_funds,
+               win_payout, order_count, profit_loss, maturity, created_at, resolved_at,
+               yes_stake, no_stake, largest_stake, yes_liability, no_liability
+        FROM events
+        WHERE tag = ?;
     )";
 
     bool use_id = is_integer(id_or_tag);
-    if (use_id)
-        sql += "id = ?;";
-    else
-        sql += "tag = ?;";
 
-    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(use_id ? by_id_sql : by_tag_sql);
+    if (!stmt)
     {
-        error_msg("Failed to prepare select statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
         return ev;
     }
+    StmtGuard guard(stmt);
 
     if (use_id)
     {
@@ -469,33 +253,7 @@ Event get_event_details(const std::string &id_or_tag)
     int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW)
     {
-        ev.id = sqlite3_column_int(stmt, 0);
-
-        const unsigned char *txt = sqlite3_column_text(stmt, 1);
-        ev.tag = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        txt = sqlite3_column_text(stmt, 2);
-        ev.name = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        ev.risk_cap = sqlite3_column_double(stmt, 3);
-
-        ev.outcome = (sqlite3_column_type(stmt, 4) == SQLITE_NULL) ? -1 : sqlite3_column_int(stmt, 4);
-        ev.resolved = sqlite3_column_int(stmt, 5) != 0;
-        ev.q_yes = sqlite3_column_double(stmt, 6);
-        ev.q_no = sqlite3_column_double(stmt, 7);
-        ev.event_funds = sqlite3_column_double(stmt, 8);
-        ev.win_payout = sqlite3_column_double(stmt, 9);
-        ev.order_count = sqlite3_column_int(stmt, 10);
-        ev.profit_loss = sqlite3_column_double(stmt, 11);
-
-        txt = sqlite3_column_text(stmt, 12);
-        ev.maturity = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        txt = sqlite3_column_text(stmt, 13);
-        ev.created_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        txt = sqlite3_column_text(stmt, 14);
-        ev.resolved_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
+        read_event_row(stmt, ev);
     }
     else if (rc == SQLITE_DONE)
     {
@@ -503,176 +261,260 @@ Event get_event_details(const std::string &id_or_tag)
     }
     else
     {
-        error_msg("Failed to read event: " + std::string(sqlite3_errmsg(db)));
+        error_msg("Failed to read event: " + std::string(conn->errmsg()));
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
     return ev;
 }
 
 std::vector<Event> list_all_events(bool resolved)
 {
+    TraceSpan span("list_all_events");
     std::vector<Event> events;
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
 
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(db ? sqlite3_errmsg(db) : "unknown"));
-        if (db)
-            sqlite3_close(db);
+    DbConnection *conn = db_connection();
+    if (!conn)
         return events;
-    }
 
     const char *sql = R"(
         SELECT id, tag, name, risk_cap, outcome, resolved, q_yes, q_no, event_funds,
-               win_payout, order_count, profit_loss, maturity, created_at, resolved_at
+               win_payout, order_count, profit_loss, maturity, created_at, resolved_at,
+               yes_stake, no_stake, largest_stake, yes_liability, no_liability
         FROM events
-        WHERE resolved = ?
+        WHERE resolved = ?1 AND (?1 = 1 OR outcome IS NULL) -- settling events are neither
         ORDER BY id DESC;
     )";
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(sql);
+    if (!stmt)
     {
-        error_msg("Failed to prepare select statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
         return events;
     }
+    StmtGuard guard(stmt);
 
     sqlite3_bind_int(stmt, 1, resolved ? 1 : 0);
 
     while (sqlite3_step(stmt) == SQLITE_ROW)
     {
         Event ev;
-        ev.id = sqlite3_column_int(stmt, 0);
-
-        const unsigned char *txt = sqlite3_column_text(stmt, 1);
-        ev.tag = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        txt = sqlite3_column_text(stmt, 2);
-        ev.name = txt ? reinterpret_cast<const char *>(txt) : std::string();
-
-        ev.risk_cap = sqlite3_column_double(stmt, 3);
+        read_event_row(stmt, ev);
+        events.push_back(std::move(ev));
+    }
 
-        ev.outcome = (sqlite3_column_type(stmt, 4) == SQLITE_NULL) ? -1 : sqlite3_column_int(stmt, 4);
-        ev.resolved = sqlite3_column_int(stmt, 5) != 0;
-        ev.q_yes = sqlite3_column_double(stmt, 6);
-        ev.q_no = sqlite3_column_double(stmt, 7);
-        ev.event_funds = sqlite3_column_double(stmt, 8);
-        ev.win_payout = sqlite3_column_double(stmt, 9);
-        ev.order_count = sqlite3_column_int(stmt, 10);
-        ev.profit_loss = sqlite3_column_double(stmt, 11);
+    return events;
+}
 
-        txt = sqlite3_column_text(stmt, 12);
-        ev.maturity = txt ? reinterpret_cast<const char *>(txt) : std::string();
+// id span of the open events (first > last if there are none), and with
+// `ids` every open id in ascending order
+bool open_event_ids(int &first_id, int &last_id, std::vector<int> *ids)
+{
+    TraceSpan span("open_event_ids");
+    first_id = 1;
+    last_id = 0;
 
-        txt = sqlite3_column_text(stmt, 13);
-        ev.created_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
 
-        txt = sqlite3_column_text(stmt, 14);
-        ev.resolved_at = txt ? reinterpret_cast<const char *>(txt) : std::string();
+    // open: neither resolved nor settling (outcome recorded)
+    const char *ids_sql = "SELECT id FROM events WHERE resolved = 0 AND outcome IS NULL ORDER BY id;";
+    const char *span_sql = "SELECT MIN(id), MAX(id) FROM events WHERE resolved = 0 AND outcome IS NULL;";
 
-        events.push_back(std::move(ev));
+    sqlite3_stmt *stmt = conn->prepare(ids ? ids_sql : span_sql);
+    if (!stmt)
+    {
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return false;
     }
+    StmtGuard guard(stmt);
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
-    return events;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        if (!ids)
+        {
+            if (sqlite3_column_type(stmt, 0) != SQLITE_NULL)
+            {
+                first_id = sqlite3_column_int(stmt, 0);
+                last_id = sqlite3_column_int(stmt, 1);
+            }
+            continue;
+        }
+        int id = sqlite3_column_int(stmt, 0);
+        if (ids->empty())
+            first_id = id;
+        last_id = id;
+        ids->push_back(id);
+    }
+    if (rc != SQLITE_DONE)
+    {
+        error_msg("Failed to read open events: " + std::string(conn->errmsg()));
+        return false;
+    }
+    return true;
 }
 
-void event_metrics_summary(int event_id)
+static void read_event_state(sqlite3_stmt *stmt, EventState &state)
 {
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
+    state.id = sqlite3_column_int(stmt, 0);
+    state.risk_cap = column_money(stmt, 1);
+    state.q_yes = sqlite3_column_double(stmt, 2);
+    state.q_no = sqlite3_column_double(stmt, 3);
+    state.event_funds = column_money(stmt, 4);
+    state.order_count = sqlite3_column_int64(stmt, 5);
+    state.aggregates.yes_stake = column_money(stmt, 6);
+    state.aggregates.no_stake = column_money(stmt, 7);
+    state.aggregates.largest_stake = column_money(stmt, 8);
+    state.aggregates.yes_liability = column_money(stmt, 9);
+    state.aggregates.no_liability = column_money(stmt, 10);
+}
 
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(sqlite3_errmsg(db)));
-        if (db)
-            sqlite3_close(db);
-        return;
-    }
+/** market state of the open events with first_id <= id <= last_id, appended in id order */
+bool load_event_states(int first_id, int last_id, std::vector<EventState> &out)
+{
+    TraceSpan span("load_event_states");
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
 
-    // 1. Get event info
-    const char *event_sql = R"(
-        SELECT name, risk_cap, outcome, resolved, event_funds, win_payout, profit_loss
+    // a rowid range: each hydration worker scans only its own slice
+    const char *sql = R"(
+        SELECT id, risk_cap, q_yes, q_no, event_funds, order_count,
+               yes_stake, no_stake, largest_stake, yes_liability, no_liability
         FROM events
-        WHERE id = ?;
+        WHERE id BETWEEN ? AND ? AND resolved = 0 AND outcome IS NULL
+        ORDER BY id;
     )";
 
-    if (sqlite3_prepare_v2(db, event_sql, -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(sql);
+    if (!stmt)
     {
-        error_msg("Failed to prepare event query: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
-        return;
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return false;
     }
+    StmtGuard guard(stmt);
+    sqlite3_bind_int(stmt, 1, first_id);
+    sqlite3_bind_int(stmt, 2, last_id);
 
-    sqlite3_bind_int(stmt, 1, event_id);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        out.emplace_back();
+        read_event_state(stmt, out.back());
+    }
+    if (rc != SQLITE_DONE)
+    {
+        error_msg("Failed to read event states: " + std::string(conn->errmsg()));
+        return false;
+    }
+    return true;
+}
 
-    std::string event_name;
-    double risk_cap = 0.0;
-    int outcome = -1;
-    int resolved = 0;
-    double event_funds = 0.0;
-    double win_payout = 0.0;
-    double profit_loss = 0.0;
+/** market state of one open event; false if it is not open (or on error) */
+bool load_event_state(int event_id, EventState &out)
+{
+    std::vector<EventState> states;
+    if (!load_event_states(event_id, event_id, states) || states.empty())
+        return false;
+    out = states.front();
+    return true;
+}
+
+/** tag, name and maturity of every open event, for the GET /events catalog */
+std::vector<EventListing> list_event_listings()
+{
+    TraceSpan span("list_event_listings");
+    std::vector<EventListing> listings;
+
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return listings;
 
-    if (sqlite3_step(stmt) == SQLITE_ROW)
+    const char *sql = "SELECT id, tag, name, maturity FROM events WHERE resolved = 0 AND outcome IS NULL ORDER BY id;";
+
+    sqlite3_stmt *stmt = conn->prepare(sql);
+    if (!stmt)
     {
-        event_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
-        risk_cap = sqlite3_column_double(stmt, 1);
-        outcome = sqlite3_column_type(stmt, 2) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 2);
-        resolved = sqlite3_column_int(stmt, 3);
-        event_funds = sqlite3_column_double(stmt, 4);
-        win_payout = sqlite3_column_double(stmt, 5);
-        profit_loss = sqlite3_column_double(stmt, 6);
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return listings;
     }
-    else
-    {
-        sqlite3_finalize(stmt);
-        sqlite3_close(db);
-        error_msg("Event not found (id=" + std::to_string(event_id) + ")");
+    StmtGuard guard(stmt);
+
+    auto text = [stmt](int column) {
+        const unsigned char *txt = sqlite3_column_text(stmt, column);
+        return txt ? std::string(reinterpret_cast<const char *>(txt)) : std::string();
+    };
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        listings.push_back(EventListing{sqlite3_column_int(stmt, 0), text(1), text(2), text(3)});
+    return listings;
+}
+
+void event_metrics_summary(int event_id)
+{
+    TraceSpan span("event_metrics_summary");
+    DbConnection *conn = db_connection();
+    if (!conn)
         return;
-    }
-    sqlite3_finalize(stmt);
 
-    // Aggregate order book data
-    const char *orders_sql = R"(
-        SELECT COUNT(*),
-               SUM(CASE WHEN side != 0 THEN stake ELSE 0 END),
-               SUM(CASE WHEN side = 0 THEN stake ELSE 0 END),
-               MAX(stake)
-        FROM order_book
-        WHERE event_id = ?;
+    // one row: the order aggregates are kept up to date by record_fills
+    const char *event_sql = R"(
+        SELECT name, risk_cap, outcome, resolved, event_funds, win_payout, profit_loss, order_count,
+               yes_stake, no_stake, largest_stake, yes_liability, no_liability
+        FROM events
+        WHERE id = ?;
     )";
 
-    if (sqlite3_prepare_v2(db, orders_sql, -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(event_sql);
+    if (!stmt)
     {
-        error_msg("Failed to prepare order aggregation: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
+        error_msg("Failed to prepare event query: " + std::string(conn->errmsg()));
         return;
     }
 
-    sqlite3_bind_int(stmt, 1, event_id);
-
+    std::string event_name;
+    Money risk_cap;
+    int outcome = -1;
+    int resolved = 0;
+    Money event_funds;
+    Money win_payout;
+    Money profit_loss;
     int total_orders = 0;
-    double total_yes = 0.0;
-    double total_no = 0.0;
-    double max_stake = 0.0;
+    OrderAggregates totals;
 
-    if (sqlite3_step(stmt) == SQLITE_ROW)
     {
-        total_orders = sqlite3_column_int(stmt, 0);
-        total_yes = sqlite3_column_double(stmt, 1);
-        total_no = sqlite3_column_double(stmt, 2);
-        max_stake = sqlite3_column_double(stmt, 3);
+        StmtGuard guard(stmt);
+        sqlite3_bind_int(stmt, 1, event_id);
+
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            event_name = reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0));
+            risk_cap = column_money(stmt, 1);
+            outcome = sqlite3_column_type(stmt, 2) == SQLITE_NULL ? -1 : sqlite3_column_int(stmt, 2);
+            resolved = sqlite3_column_int(stmt, 3);
+            event_funds = column_money(stmt, 4);
+            win_payout = column_money(stmt, 5);
+            profit_loss = column_money(stmt, 6);
+            total_orders = sqlite3_column_int(stmt, 7);
+            totals.yes_stake = column_money(stmt, 8);
+            totals.no_stake = column_money(stmt, 9);
+            totals.largest_stake = column_money(stmt, 10);
+            totals.yes_liability = column_money(stmt, 11);
+            totals.no_liability = column_money(stmt, 12);
+        }
+        else
+        {
+            error_msg("Event not found (id=" + std::to_string(event_id) + ")");
+            return;
+        }
     }
-    sqlite3_finalize(stmt);
+    Money total_yes = totals.yes_stake;
+    Money total_no = totals.no_stake;
+    Money max_stake = totals.largest_stake;
 
     // Compute winning side & potential loss if opposite side won
     std::string win_side = "N/A";
-    double potential_loss_other_side = 0.0;
+    Money potential_loss_other_side;
 
     if (resolved)
     {
@@ -695,6 +537,10 @@ void event_metrics_summary(int event_id)
                 << " :" << std::right << std::setw(value_width - 1) << value << " |\n";
     };
 
+    auto print_row_money = [print_row](const std::string& key, Money value) {
+        print_row(key, to_string(value));
+    };
+
     auto print_row_double = [label_width, value_width, print_separator](const std::string& key, double value) {
         print_separator();
         std::cout << "| " << std::left << std::setw(label_width) << key
@@ -711,23 +557,23 @@ void event_metrics_summary(int event_id)
     print_row("Resolved", resolved ? "Yes" : "No");
     print_row("Winning Side", win_side);
     print_row("Total Orders", std::to_string(static_cast<int>(total_orders)));
-    print_row_double("Total YES Stake", total_yes);
-    print_row_double("Total NO Stake", total_no);
-    print_row_double("Max Single Stake", max_stake);
-    print_row_double("Event Funds", event_funds);
-    print_row_double("Win Payout", win_payout);
-    print_row_double("Profit/Loss", resolved ? profit_loss : 0.0);
-    print_row_double("Risk Cap", risk_cap);
-    print_row_double("Potential Loss if Opposite Side Wins", resolved ? potential_loss_other_side : 0.0);
-    print_row_double("Total Liquidity Staked", total_yes + total_no);
-    if (resolved && win_payout > 0)
+    print_row_money("Total YES Stake", total_yes);
+    print_row_money("Total NO Stake", total_no);
+    print_row_money("Max Single Stake", max_stake);
+    print_row_money("Event Funds", event_funds);
+    print_row_money("Win Payout", win_payout);
+    print_row_money("Profit/Loss", resolved ? profit_loss : Money());
+    print_row_money("Risk Cap", risk_cap);
+    print_row_money("Potential Loss if Opposite Side Wins", resolved ? potential_loss_other_side : Money());
+    print_row_money("Total Liquidity Staked", total_yes + total_no);
+    print_row_money("Payout if YES Wins", totals.yes_liability);
+    print_row_money("Payout if NO Wins", totals.no_liability);
+    if (resolved && win_payout > Money() && event_funds > Money())
     {
-        print_row_double("Payout Ratio (win/event funds)", win_payout / event_funds);
+        print_row_double("Payout Ratio (win/event funds)", win_payout.to_double() / event_funds.to_double());
     }
 
     std::cout << "+---------------------------------------------------------------+\n";
-
-    sqlite3_close(db);
 }
 
 
@@ -739,20 +585,271 @@ void event_metrics_summary(int event_id)
 
 
 
+/*************************************************************************
+** Settlement Related Functions
+**
+** Settling an event is split into short transactions so it never holds
+** the write lock for long:
+**   1. begin_settlement: record the outcome (the event is now "settling":
+**      outcome set, resolved = 0) and its settlements row;
+**   2. settle_order_chunk, repeated: pay out the next `chunk` unpaid orders
+**      in id order with one set-based UPDATE and advance the cursor and
+**      totals in the same transaction;
+**   3. finish_settlement: mark the event resolved with the totals.
+** Every step is idempotent, so after a crash the settlement resumes from
+** the stored cursor (list_settling_events).
+*************************************************************************/
 
+// runs `body` inside BEGIN IMMEDIATE ... COMMIT, rolling back if it fails
+template <typename Body>
+static bool write_transaction(DbConnection *conn, Body body)
+{
+    if (!conn->exec("BEGIN IMMEDIATE;"))
+    {
+        error_msg("Failed to begin transaction.");
+        return false;
+    }
+    if (body() && conn->exec("COMMIT;"))
+        return true;
+    if (!conn->exec("ROLLBACK;"))
+        error_msg("Failed to rollback transaction.");
+    return false;
+}
 
+/** record the outcome and start (or confirm) the event's settlement */
+bool begin_settlement(int event_id, bool outcome)
+{
+    TraceSpan span("begin_settlement");
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
+
+    return write_transaction(conn, [&]() {
+        sqlite3_stmt *stmt = conn->prepare("SELECT resolved, outcome FROM events WHERE id = ?;");
+        if (!stmt)
+        {
+            error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+            return false;
+        }
+        {
+            StmtGuard guard(stmt);
+            sqlite3_bind_int(stmt, 1, event_id);
+            if (sqlite3_step(stmt) != SQLITE_ROW)
+            {
+                error_msg("Event not found (id=" + std::to_string(event_id) + ").");
+                return false;
+            }
+            if (sqlite3_column_int(stmt, 0))
+            {
+                error_msg("Event already resolved (id=" + std::to_string(event_id) + ").");
+                return false;
+            }
+            if (sqlite3_column_type(stmt, 1) != SQLITE_NULL && (sqlite3_column_int(stmt, 1) != 0) != outcome)
+            {
+                error_msg("Event is already being settled as '" + std::string(outcome ? "NO" : "YES") +
+                          "' (id=" + std::to_string(event_id) + ").");
+                return false;
+            }
+        }
 
+        stmt = conn->prepare("UPDATE events SET outcome = ? WHERE id = ?;");
+        sqlite3_stmt *insert = stmt ? conn->prepare("INSERT OR IGNORE INTO settlements (event_id, outcome) VALUES (?, ?);") : nullptr;
+        if (!insert)
+        {
+            error_msg("Failed to prepare settlement statements: " + std::string(conn->errmsg()));
+            return false;
+        }
+        StmtGuard update_guard(stmt);
+        StmtGuard insert_guard(insert);
+        sqlite3_bind_int(stmt, 1, outcome ? 1 : 0);
+        sqlite3_bind_int(stmt, 2, event_id);
+        sqlite3_bind_int(insert, 1, event_id);
+        sqlite3_bind_int(insert, 2, outcome ? 1 : 0);
+        if (sqlite3_step(stmt) != SQLITE_DONE || sqlite3_step(insert) != SQLITE_DONE)
+        {
+            error_msg("Failed to record settlement (id=" + std::to_string(event_id) + "): " + std::string(conn->errmsg()));
+            return false;
+        }
+        return true;
+    });
+}
 
+/** progress of an unfinished or finished settlement; false if there is none */
+bool load_settlement(int event_id, Settlement &out)
+{
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
 
+    const char *sql = R"(
+        SELECT s.outcome, s.cursor, s.settled_orders, s.total_payout, e.order_count, s.finished_at IS NOT NULL
+        FROM settlements s JOIN events e ON e.id = s.event_id
+        WHERE s.event_id = ?;
+    )";
+    sqlite3_stmt *stmt = conn->prepare(sql);
+    if (!stmt)
+    {
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return false;
+    }
+    StmtGuard guard(stmt);
+    sqlite3_bind_int(stmt, 1, event_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW)
+        return false;
+
+    out.event_id = event_id;
+    out.outcome = sqlite3_column_int(stmt, 0) != 0;
+    out.cursor = sqlite3_column_int64(stmt, 1);
+    out.settled_orders = sqlite3_column_int64(stmt, 2);
+    out.total_payout = column_money(stmt, 3);
+    out.total_orders = sqlite3_column_int64(stmt, 4);
+    out.finished = sqlite3_column_int(stmt, 5) != 0;
+    return true;
+}
 
+/** pay out up to `chunk` orders past the cursor; returns how many (0: none left), -1 on error */
+int settle_order_chunk(Settlement &settlement, int chunk)
+{
+    TraceSpan span("settle_order_chunk");
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return -1;
 
+    // the next chunk of unpaid orders, by the order_book primary key
+    const char *select_sql = R"(
+        SELECT COUNT(*), MAX(id), COALESCE(SUM(CASE WHEN side = ?1 THEN expected_cashout ELSE 0 END), 0)
+        FROM (SELECT id, side, expected_cashout FROM order_book
+              WHERE event_id = ?2 AND id > ?3 AND pay_out IS NULL
+              ORDER BY id LIMIT ?4);
+    )";
+    const char *payout_sql = R"(
+        UPDATE order_book
+        SET pay_out = CASE WHEN side = ?1 THEN expected_cashout ELSE 0 END
+        WHERE id > ?3 AND id <= ?4 AND event_id = ?2 AND pay_out IS NULL;
+    )";
+    const char *progress_sql = R"(
+        UPDATE settlements
+        SET cursor = ?, settled_orders = settled_orders + ?, total_payout = total_payout + ?
+        WHERE event_id = ?;
+    )";
 
+    int64_t count = 0, last_id = 0;
+    Money payout;
+    bool ok = write_transaction(conn, [&]() {
+        sqlite3_stmt *select = conn->prepare(select_sql);
+        sqlite3_stmt *update = select ? conn->prepare(payout_sql) : nullptr;
+        sqlite3_stmt *progress = update ? conn->prepare(progress_sql) : nullptr;
+        if (!progress)
+        {
+            log_error("Failed to prepare settlement statements.", {{"error", conn->errmsg()}});
+            return false;
+        }
 
+        {
+            StmtGuard guard(select);
+            sqlite3_bind_int(select, 1, settlement.outcome ? 1 : 0);
+            sqlite3_bind_int(select, 2, settlement.event_id);
+            sqlite3_bind_int64(select, 3, settlement.cursor);
+            sqlite3_bind_int(select, 4, chunk);
+            if (sqlite3_step(select) != SQLITE_ROW)
+                return false;
+            count = sqlite3_column_int64(select, 0);
+            last_id = sqlite3_column_int64(select, 1);
+            payout = column_money(select, 2);
+        }
+        if (count == 0)
+            return true;
+
+        StmtGuard update_guard(update);
+        sqlite3_bind_int(update, 1, settlement.outcome ? 1 : 0);
+        sqlite3_bind_int(update, 2, settlement.event_id);
+        sqlite3_bind_int64(update, 3, settlement.cursor);
+        sqlite3_bind_int64(update, 4, last_id);
+
+        StmtGuard progress_guard(progress);
+        sqlite3_bind_int64(progress, 1, last_id);
+        sqlite3_bind_int64(progress, 2, count);
+        sqlite3_bind_int64(progress, 3, payout.micros());
+        sqlite3_bind_int(progress, 4, settlement.event_id);
+
+        if (sqlite3_step(update) != SQLITE_DONE || sqlite3_step(progress) != SQLITE_DONE)
+        {
+            log_error("Failed to settle orders.", {{"event_id", settlement.event_id}, {"error", conn->errmsg()}});
+            return false;
+        }
+        return true;
+    });
+    if (!ok)
+        return -1;
 
+    if (count > 0)
+    {
+        settlement.cursor = last_id;
+        settlement.settled_orders += count;
+        settlement.total_payout += payout;
+    }
+    return static_cast<int>(count);
+}
 
+/** mark the event resolved with the settled totals */
+bool finish_settlement(const Settlement &settlement)
+{
+    TraceSpan span("finish_settlement");
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
 
+    const char *update_event_sql = R"(
+        UPDATE events
+        SET resolved = 1,
+            win_payout = COALESCE(win_payout, 0) + ?1,
+            profit_loss = COALESCE(event_funds, 0) - ?1,
+            resolved_at = CURRENT_TIMESTAMP
+        WHERE id = ?2 AND resolved = 0;
+    )";
+    const char *finish_sql = "UPDATE settlements SET finished_at = CURRENT_TIMESTAMP WHERE event_id = ?;";
 
+    return write_transaction(conn, [&]() {
+        sqlite3_stmt *update = conn->prepare(update_event_sql);
+        sqlite3_stmt *finish = update ? conn->prepare(finish_sql) : nullptr;
+        if (!finish)
+        {
+            error_msg("Failed to prepare event update statement: " + std::string(conn->errmsg()));
+            return false;
+        }
+        StmtGuard update_guard(update);
+        StmtGuard finish_guard(finish);
+        sqlite3_bind_int64(update, 1, settlement.total_payout.micros());
+        sqlite3_bind_int(update, 2, settlement.event_id);
+        sqlite3_bind_int(finish, 1, settlement.event_id);
+        if (sqlite3_step(update) != SQLITE_DONE || sqlite3_step(finish) != SQLITE_DONE)
+        {
+            error_msg("Failed to update event aggregates (id=" + std::to_string(settlement.event_id) + "): " + std::string(conn->errmsg()));
+            return false;
+        }
+        return true;
+    });
+}
 
+/** events whose outcome is recorded but whose settlement has not finished */
+std::vector<int> list_settling_events()
+{
+    std::vector<int> ids;
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return ids;
+
+    sqlite3_stmt *stmt = conn->prepare("SELECT id FROM events WHERE resolved = 0 AND outcome IS NOT NULL ORDER BY id;");
+    if (!stmt)
+    {
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return ids;
+    }
+    StmtGuard guard(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        ids.push_back(sqlite3_column_int(stmt, 0));
+    return ids;
+}
 
 
 
@@ -760,145 +857,192 @@ void event_metrics_summary(int event_id)
 ** Order Book Related Functions
 *************************************************************************/
 
-/** add an order to the order_book table and update aggregate fields on events table */
-void new_order(int event_id, bool side, double stake, double price, double expected_cashout)
+// order_book rows + event state/aggregates for each fill; the caller holds
+// the write transaction
+static bool write_fills(DbConnection *conn, const std::vector<Fill> &fills)
 {
-    sqlite3 *db = nullptr;
-    char *errMsg = nullptr;
-
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(sqlite3_errmsg(db)));
-        if (db)
-            sqlite3_close(db);
-        return;
-    }
-
-    // Enable foreign key checks
-    if (sqlite3_exec(db, "PRAGMA foreign_keys = ON;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-    {
-        error_msg("Failed to enable foreign keys: " + std::string(errMsg ? errMsg : ""));
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
-        return;
-    }
-
-    // Begin transaction
-    if (sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-    {
-        error_msg("Failed to begin transaction: " + std::string(errMsg ? errMsg : ""));
-        sqlite3_free(errMsg);
-        sqlite3_close(db);
-        return;
-    }
-
     const char *insert_sql = R"(
         INSERT INTO order_book (event_id, side, stake, expected_cashout, price)
         VALUES (?, ?, ?, ?, ?);
     )";
 
-    sqlite3_stmt *stmt = nullptr;
-    bool success = true;
+    const char *update_sql = R"(
+        UPDATE events
+        SET q_yes = ?,
+            q_no = ?,
+            event_funds = ?,
+            order_count = COALESCE(order_count, 0) + 1,
+            yes_stake = ?,
+            no_stake = ?,
+            largest_stake = ?,
+            yes_liability = ?,
+            no_liability = ?
+        WHERE id = ?;
+    )";
 
-    if (sqlite3_prepare_v2(db, insert_sql, -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *insert_stmt = conn->prepare(insert_sql);
+    sqlite3_stmt *update_stmt = insert_stmt ? conn->prepare(update_sql) : nullptr;
+    if (!update_stmt)
     {
-        error_msg("Failed to prepare insert statement: " + std::string(sqlite3_errmsg(db)));
-        success = false;
+        log_error("Failed to prepare fill statements.", {{"error", conn->errmsg()}});
+        return false;
     }
-    else
+
+    for (const Fill &fill : fills)
     {
-        sqlite3_bind_int(stmt, 1, event_id);
-        sqlite3_bind_int(stmt, 2, side ? 1 : 0);
-        sqlite3_bind_double(stmt, 3, stake);
-        sqlite3_bind_double(stmt, 4, expected_cashout);
-        sqlite3_bind_double(stmt, 5, price);
+        {
+            StmtGuard guard(insert_stmt);
+            sqlite3_bind_int(insert_stmt, 1, fill.event_id);
+            sqlite3_bind_int(insert_stmt, 2, fill.side == Side::YES ? 1 : 0);
+            sqlite3_bind_int64(insert_stmt, 3, fill.stake.micros());
+            sqlite3_bind_int64(insert_stmt, 4, fill.expected_cashout.micros());
+            sqlite3_bind_int64(insert_stmt, 5, fill.price.micros());
+
+            if (sqlite3_step(insert_stmt) != SQLITE_DONE)
+            {
+                log_error("Failed to insert order.", {{"event_id", fill.event_id}, {"error", conn->errmsg()}});
+                return false;
+            }
+        }
 
-        if (sqlite3_step(stmt) != SQLITE_DONE)
+        // write the new market state and aggregates and bump the order count
+        StmtGuard guard(update_stmt);
+        sqlite3_bind_double(update_stmt, 1, fill.q_yes);
+        sqlite3_bind_double(update_stmt, 2, fill.q_no);
+        sqlite3_bind_int64(update_stmt, 3, fill.event_funds.micros());
+        sqlite3_bind_int64(update_stmt, 4, fill.aggregates.yes_stake.micros());
+        sqlite3_bind_int64(update_stmt, 5, fill.aggregates.no_stake.micros());
+        sqlite3_bind_int64(update_stmt, 6, fill.aggregates.largest_stake.micros());
+        sqlite3_bind_int64(update_stmt, 7, fill.aggregates.yes_liability.micros());
+        sqlite3_bind_int64(update_stmt, 8, fill.aggregates.no_liability.micros());
+        sqlite3_bind_int(update_stmt, 9, fill.event_id);
+
+        if (sqlite3_step(update_stmt) != SQLITE_DONE)
+        {
+            log_error("Failed to update event state.", {{"event_id", fill.event_id}, {"error", conn->errmsg()}});
+            return false;
+        }
+        if (sqlite3_changes(conn->handle()) != 1)
         {
-            error_msg("Failed to execute insert statement: " + std::string(sqlite3_errmsg(db)));
-            success = false;
+            log_error("Event not found.", {{"event_id", fill.event_id}});
+            return false;
         }
     }
+    return true;
+}
 
-    if (stmt)
+// write_fills plus `extra` in one BEGIN IMMEDIATE ... COMMIT
+template <typename Extra>
+static bool commit_fills(const std::vector<Fill> &fills, Extra extra)
+{
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
+
+    // take the write lock up front so concurrent fills queue on busy_timeout
+    // instead of failing a read->write upgrade
+    auto begin_start = std::chrono::steady_clock::now();
+    if (!conn->exec("BEGIN IMMEDIATE;"))
     {
-        sqlite3_finalize(stmt);
-        stmt = nullptr;
+        log_error("Failed to begin order-book transaction.");
+        return false;
     }
+    trace_complete("sqlite BEGIN IMMEDIATE", begin_start, std::chrono::steady_clock::now());
 
-    // If insert succeeded, update aggregate fields on events table
-    if (success)
+    // Commit or rollback
+    if (write_fills(conn, fills) && extra(conn))
     {
-        const char *update_sql = R"(
-            UPDATE events
-            SET order_count = COALESCE(order_count, 0) + 1,
-                event_funds = COALESCE(event_funds, 0) + ?
-            WHERE id = ?;
-        )";
+        auto commit_start = std::chrono::steady_clock::now();
+        bool committed = conn->exec("COMMIT;");
+        auto commit_end = std::chrono::steady_clock::now();
+        metrics_observe(MetricHistogram::SQLITE_COMMIT, commit_end - commit_start);
+        trace_complete("sqlite COMMIT", commit_start, commit_end);
+        if (committed)
+            return true;
+        metrics_count(MetricCounter::SQLITE_COMMIT_FAILURES);
+        log_error("Failed to commit order-book transaction.", {{"fills", fills.size()}});
+        conn->exec("ROLLBACK;");
+        return false;
+    }
 
-        if (sqlite3_prepare_v2(db, update_sql, -1, &stmt, nullptr) != SQLITE_OK)
-        {
-            error_msg("Failed to prepare update statement: " + std::string(sqlite3_errmsg(db)));
-            success = false;
-        }
-        else
-        {
-            sqlite3_bind_double(stmt, 1, stake);
-            sqlite3_bind_int(stmt, 2, event_id);
+    metrics_count(MetricCounter::SQLITE_COMMIT_FAILURES);
+    if (!conn->exec("ROLLBACK;"))
+        log_error("Failed to roll back order-book transaction.");
+    return false;
+}
 
-            if (sqlite3_step(stmt) != SQLITE_DONE)
-            {
-                error_msg("Failed to execute update statement: " + std::string(sqlite3_errmsg(db)));
-                success = false;
-            }
-        }
+/** persist fills: order_book rows + event state/aggregates in a single transaction */
+bool record_fills(const std::vector<Fill> &fills)
+{
+    TraceSpan span("record_fills");
+    if (fills.empty())
+        return true;
+
+    if (!commit_fills(fills, [](DbConnection *) { return true; }))
+        return false;
+    log_fills(fills);
+    return true;
+}
 
-        if (stmt)
+/** copy fills from the binlog, advancing the fed position in the same transaction */
+bool record_logged_fills(const std::vector<Fill> &fills, uint64_t through_seq)
+{
+    TraceSpan span("record_logged_fills");
+    const char *position_sql = "INSERT OR REPLACE INTO binlog_position (id, seq) VALUES (1, ?);";
+    return commit_fills(fills, [&](DbConnection *conn) {
+        sqlite3_stmt *stmt = conn->prepare(position_sql);
+        if (!stmt)
         {
-            sqlite3_finalize(stmt);
-            stmt = nullptr;
+            log_error("Failed to prepare binlog position update.", {{"error", conn->errmsg()}});
+            return false;
         }
-    }
+        StmtGuard guard(stmt);
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(through_seq));
+        return sqlite3_step(stmt) == SQLITE_DONE;
+    });
+}
 
-    // Commit or rollback
-    if (success)
-    {
-        if (sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-        {
-            error_msg("Failed to commit transaction: " + std::string(errMsg ? errMsg : ""));
-            sqlite3_free(errMsg);
-        }
-        else
-        {
-            success_msg("Order added successfully (event_id=" + to_string_safe(event_id) + ", stake=" + to_string_safe(stake) + ", cashout=" + to_string_safe(expected_cashout) + ", side=" + (side ? "YES" : "NO") + ").");
-        }
-    }
-    else
+/** last binlog record copied into SQLite (0: none) */
+bool load_binlog_position(uint64_t &seq)
+{
+    DbConnection *conn = db_connection();
+    if (!conn)
+        return false;
+    sqlite3_stmt *stmt = conn->prepare("SELECT seq FROM binlog_position WHERE id = 1;");
+    if (!stmt)
     {
-        if (sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, &errMsg) != SQLITE_OK)
-        {
-            error_msg("Failed to rollback transaction: " + std::string(errMsg ? errMsg : ""));
-            sqlite3_free(errMsg);
-        }
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
+        return false;
     }
+    StmtGuard guard(stmt);
+    int rc = sqlite3_step(stmt);
+    seq = rc == SQLITE_ROW ? static_cast<uint64_t>(sqlite3_column_int64(stmt, 0)) : 0;
+    return rc == SQLITE_ROW || rc == SQLITE_DONE;
+}
+
+void log_fills(const std::vector<Fill> &fills)
+{
+    for (const Fill &fill : fills)
+        log_info("Order added successfully", {{"event_id", fill.event_id},
+                                              {"stake", fill.stake},
+                                              {"cashout", fill.expected_cashout},
+                                              {"side", fill.side == Side::YES ? "YES" : "NO"}});
+}
 
-    sqlite3_close(db);
+bool record_fill(const Fill &fill)
+{
+    return record_fills({fill});
 }
 
 // list event orders
 std::vector<Order> list_event_orders(const int event_id)
 {
+    TraceSpan span("list_event_orders");
     std::vector<Order> orders;
-    sqlite3 *db = nullptr;
-    sqlite3_stmt *stmt = nullptr;
 
-    if (sqlite3_open(database_path, &db))
-    {
-        error_msg("Can't open database: " + std::string(db ? sqlite3_errmsg(db) : "unknown"));
-        if (db)
-            sqlite3_close(db);
+    DbConnection *conn = db_connection();
+    if (!conn)
         return orders;
-    }
 
     const char *sql = R"(
         SELECT event_id, side, stake, price, expected_cashout, pay_out
@@ -907,12 +1051,13 @@ std::vector<Order> list_event_orders(const int event_id)
         ORDER BY id ASC;
     )";
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+    sqlite3_stmt *stmt = conn->prepare(sql);
+    if (!stmt)
     {
-        error_msg("Failed to prepare select statement: " + std::string(sqlite3_errmsg(db)));
-        sqlite3_close(db);
+        error_msg("Failed to prepare select statement: " + std::string(conn->errmsg()));
         return orders;
     }
+    StmtGuard guard(stmt);
 
     sqlite3_bind_int(stmt, 1, event_id);
 
@@ -921,15 +1066,13 @@ std::vector<Order> list_event_orders(const int event_id)
         Order ord;
         ord.event_id = sqlite3_column_int(stmt, 0);
         ord.side = static_cast<Side>(sqlite3_column_int(stmt, 1));
-        ord.stake = sqlite3_column_double(stmt, 2);
-        ord.price = sqlite3_column_double(stmt, 3);
-        ord.expected_cashout = sqlite3_column_double(stmt, 4);
-        ord.payout = sqlite3_column_double(stmt, 5);
+        ord.stake = column_money(stmt, 2);
+        ord.price = column_money(stmt, 3);
+        ord.expected_cashout = column_money(stmt, 4);
+        ord.payout = column_money(stmt, 5);
 
         orders.push_back(std::move(ord));
     }
 
-    sqlite3_finalize(stmt);
-    sqlite3_close(db);
     return orders;
 }
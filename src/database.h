@@ -12,19 +12,38 @@
 
 extern const char* database_path;
 
-// Function to initialize the database and create necessary tables
+// Function to initialize the database and bring its schema up to date
 int initialize_database();
 
 
 // event related functions
-int new_event(const std::string& tag, const std::string& name, const std::string& maturity, const double risk_cap = 1'000.0);
-void update_event_state(int event_id, double q_yes, double q_no, double event_funds);
-void resolve_event_outcome(int event_id, bool outcome);
+int new_event(const std::string& tag, const std::string& name, const std::string& maturity, Money risk_cap = Money::from_micros(1'000 * Money::scale));
+bool resolve_event_outcome(int event_id, bool outcome);
 Event get_event_details(const std::string& id_or_tag);
 std::vector<Event> list_all_events(bool resolved = false);
 void event_metrics_summary(int event_id);
 
+// startup hydration of the open markets (see hydration.h)
+bool open_event_ids(int& first_id, int& last_id, std::vector<int>* ids = nullptr);
+bool load_event_states(int first_id, int last_id, std::vector<EventState>& out);
+bool load_event_state(int event_id, EventState& out);
+std::vector<EventListing> list_event_listings();
+
+
+// settlement (chunked, resumable; see database.cpp)
+bool begin_settlement(int event_id, bool outcome);
+bool load_settlement(int event_id, Settlement& out);
+int settle_order_chunk(Settlement& settlement, int chunk);
+bool finish_settlement(const Settlement& settlement);
+std::vector<int> list_settling_events();
+
 
 // order book related functions
-void new_order(int event_id, bool side, double stake, double price, double expected_cashout);
+bool record_fill(const Fill& fill);
+bool record_fills(const std::vector<Fill>& fills);
+void log_fills(const std::vector<Fill>& fills); // "Order added successfully" per fill
+
+// binlog storage: SQLite is fed from the log (see binlog.h)
+bool record_logged_fills(const std::vector<Fill>& fills, uint64_t through_seq);
+bool load_binlog_position(uint64_t& seq);
 std::vector<Order> list_event_orders(const int event_id);
\ No newline at end of file
@@ -1,4 +1,6 @@
 #pragma once
+#include "orders.h"
+#include <cstdint>
 #include <string>
 #include <optional>
 
@@ -7,16 +9,47 @@ struct  Event{
     int id;
     std::string tag;
     std::string name;
-    double risk_cap;
+    Money risk_cap;
     std::optional<bool> outcome;
     bool resolved;
     double q_yes;
     double q_no;
-    double event_funds;
-    double win_payout;
+    Money event_funds;
+    Money win_payout;
     int order_count;
-    double profit_loss;
+    Money profit_loss;
     std::string maturity;
     std::string created_at; 
     std::optional<std::string> resolved_at;
+    OrderAggregates aggregates;
+};
+
+// the columns a market is rebuilt from at startup: numbers only
+struct EventState {
+    int id = 0;
+    Money risk_cap;
+    double q_yes = 0.0;
+    double q_no = 0.0;
+    Money event_funds;
+    int64_t order_count = 0;
+    OrderAggregates aggregates;
+};
+
+// an open event's GET /events metadata
+struct EventListing {
+    int id;
+    std::string tag;
+    std::string name;
+    std::string maturity;
+};
+
+// progress of an event's settlement (settlements table)
+struct Settlement {
+    int event_id = 0;
+    bool outcome = false;
+    int64_t cursor = 0;          // last order_book id paid out
+    int64_t settled_orders = 0;
+    int64_t total_orders = 0;    // the event's order_count
+    Money total_payout;
+    bool finished = false;
 };
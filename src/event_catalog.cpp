@@ -0,0 +1,117 @@
+#include "event_catalog.h"
+#include "trace.h"
+#include "utils.h"
+#include "json.hpp"
+#include <chrono>
+#include <sstream>
+
+
+EventCatalog::EventCatalog()
+{
+    std::ostringstream id;
+    id << std::hex << std::chrono::system_clock::now().time_since_epoch().count();
+    instance = id.str();
+}
+
+void EventCatalog::add(int event_id, const std::string &tag, const std::string &name, const std::string &maturity,
+                       const LMSRContract *contract)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    entries[event_id] = Entry{tag, name, maturity, contract, std::string(), 0};
+    ++listing_version;
+}
+
+void EventCatalog::remove(int event_id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.erase(event_id) > 0)
+        ++listing_version;
+}
+
+void EventCatalog::load_on_first_use(std::function<std::vector<Listing>()> load)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_load = std::move(load);
+}
+
+std::shared_ptr<const EventCatalog::Body> EventCatalog::body()
+{
+    // read before the snapshots: a fill landing mid-rebuild leaves the cache
+    // one epoch behind, so the next call rebuilds again
+    uint64_t epoch = market_state_epoch();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending_load)
+    {
+        TraceSpan span("EventCatalog load");
+        auto load = std::move(pending_load);
+        pending_load = nullptr;
+        for (Listing &listing : load())
+        {
+            EventListing &e = listing.event;
+            // rows arrive in id order, so the hint makes each insert O(1)
+            entries.emplace_hint(entries.end(), e.id,
+                                 Entry{std::move(e.tag), std::move(e.name), std::move(e.maturity), listing.contract,
+                                       std::string(), 0});
+        }
+        ++listing_version;
+    }
+    if (cached && cached_listing == listing_version && cached_epoch == epoch)
+        return cached;
+
+    TraceSpan span("EventCatalog rebuild");
+    auto fresh = std::make_shared<Body>();
+    size_t size = 2;
+    for (const auto &entry : entries)
+        size += entry.second.json.size() + 1;
+    fresh->json.reserve(size + 64);
+
+    // same fields, format and order as the SQLite-backed listing: newest first
+    fresh->json += '[';
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+        Entry &entry = it->second;
+        MarketSnapshot s = entry.contract->snapshot();
+        if (s.quote.version != entry.json_version)
+        {
+            entry.json = nlohmann::json{
+                {"id", it->first},
+                {"tag", entry.tag},
+                {"name", entry.name},
+                {"liquidity", s.total_deposits.rounded()},
+                {"orders", s.order_count},
+                {"maturity", entry.maturity}
+            }.dump();
+            entry.json_version = s.quote.version;
+        }
+        if (it != entries.rbegin())
+            fresh->json += ',';
+        fresh->json += entry.json;
+    }
+    fresh->json += ']';
+
+    fresh->etag = "\"" + instance + "-" + std::to_string(listing_version) + "-" + std::to_string(epoch) + "\"";
+    cached = std::move(fresh);
+    cached_listing = listing_version;
+    cached_epoch = epoch;
+    return cached;
+}
+
+bool etag_matches(const std::string &if_none_match, const std::string &etag)
+{
+    std::stringstream list(if_none_match);
+    std::string candidate;
+    while (std::getline(list, candidate, ','))
+    {
+        size_t first = candidate.find_first_not_of(" \t");
+        size_t last = candidate.find_last_not_of(" \t");
+        if (first == std::string::npos)
+            continue;
+        candidate = candidate.substr(first, last - first + 1);
+        if (candidate.rfind("W/", 0) == 0) // weak comparison, as If-None-Match requires
+            candidate.erase(0, 2);
+        if (candidate == "*" || candidate == etag)
+            return true;
+    }
+    return false;
+}
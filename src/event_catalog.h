@@ -0,0 +1,79 @@
+#pragma once
+#include "contract.h"
+#include "event.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+// The open events behind GET /events, kept in memory next to the markets.
+//
+// Listing metadata (tag, name, maturity) is registered when a market opens
+// and dropped when it closes; liquidity and order count come from each
+// market's published snapshot. The serialised response is cached together
+// with an ETag and rebuilt only when the set of events changed or some
+// market published a new snapshot since (market_state_epoch), so repeated
+// polls cost a version check and a copy of the cached body. A rebuild
+// re-serialises only the events whose quote version moved and splices the
+// cached JSON of the rest. The listing of the markets open at startup can be
+// deferred to the first body() call (load_on_first_use).
+class EventCatalog
+{
+    public:
+        struct Body
+        {
+            std::string json;
+            std::string etag; // quoted, as sent in the ETag header
+        };
+
+        // an open event as loaded from the database, with its market
+        struct Listing
+        {
+            EventListing event;
+            const LMSRContract *contract;
+        };
+
+    private:
+        struct Entry
+        {
+            std::string tag;
+            std::string name;
+            std::string maturity;
+            const LMSRContract *contract;
+            std::string json;          // this event's object in the response
+            uint64_t json_version = 0; // quote version it was built from (0: never)
+        };
+
+        std::mutex mutex;
+        std::map<int, Entry> entries;   // by event id
+        uint64_t listing_version = 0;   // bumped by add/remove
+        std::shared_ptr<const Body> cached;
+        uint64_t cached_listing = 0;
+        uint64_t cached_epoch = 0;
+        std::string instance;           // keeps ETags from one run apart from the next
+        std::function<std::vector<Listing>()> pending_load;
+
+    public:
+        EventCatalog();
+        EventCatalog(const EventCatalog &) = delete;
+        EventCatalog &operator=(const EventCatalog &) = delete;
+
+        // `contract` must stay valid while listed (MarketRegistry keeps
+        // removed contracts alive)
+        void add(int event_id, const std::string &tag, const std::string &name, const std::string &maturity,
+                 const LMSRContract *contract);
+        void remove(int event_id);
+
+        // runs `load` once, under the catalog lock, before the first body();
+        // its listings join (and never replace) the events add()ed meanwhile
+        void load_on_first_use(std::function<std::vector<Listing>()> load);
+
+        // the current response; never null
+        std::shared_ptr<const Body> body();
+};
+
+// true if an If-None-Match header value lists `etag` (or is "*")
+bool etag_matches(const std::string &if_none_match, const std::string &etag);
@@ -0,0 +1,136 @@
+#include "hydration.h"
+#include "database.h"
+#include "journal.h" // for order_journal
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+// below this many ids per worker the threads cost more than they save
+static constexpr int min_ids_per_worker = 2048;
+
+LMSRContract *MarketHydrator::insert(EventState &state)
+{
+    order_journal().recover(state); // fills logged but not in the database yet
+
+    // the display name lives in the catalog; the engine never reads it
+    auto contract = std::make_unique<LMSRContract>(state.id, std::string(), state.risk_cap.to_double(), state.q_yes, state.q_no,
+                                                   state.event_funds, state.order_count, state.aggregates);
+    LMSRContract *inserted = contract.get();
+    return markets.insert(std::move(contract)) ? inserted : nullptr;
+}
+
+bool MarketHydrator::hydrate_span(int first_id, int last_id, const std::unordered_set<int> *only, size_t &hydrated)
+{
+    if (first_id > last_id)
+        return true;
+
+    size_t workers = config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    int64_t span = int64_t(last_id) - first_id + 1;
+    workers = std::max<size_t>(1, std::min<size_t>(workers, span / min_ids_per_worker));
+
+    std::atomic<size_t> count{0};
+    std::atomic<bool> failed{false};
+    auto hydrate_slice = [&](int first, int last) {
+        std::vector<EventState> states;
+        if (!load_event_states(first, last, states))
+        {
+            failed = true;
+            return;
+        }
+        size_t n = 0;
+        for (EventState &state : states)
+            if ((!only || only->count(state.id)) && insert(state))
+                ++n;
+        count += n;
+    };
+
+    // equal id slices; the last one absorbs the remainder
+    int64_t slice = span / int64_t(workers);
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < workers; ++w)
+        threads.emplace_back(hydrate_slice, int(first_id + slice * int64_t(w)),
+                             w + 1 < workers ? int(first_id + slice * int64_t(w + 1) - 1) : last_id);
+    hydrate_slice(first_id, workers > 1 ? int(first_id + slice - 1) : last_id);
+    for (auto &thread : threads)
+        thread.join();
+
+    hydrated = count;
+    return !failed;
+}
+
+bool MarketHydrator::start(const HydrationConfig &config_)
+{
+    TraceSpan span("MarketHydrator::start");
+    std::lock_guard<std::mutex> lock(mutex);
+    config = config_;
+    cold.clear();
+    cold_count = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    int first_id, last_id;
+    if (config.mode == HydrationMode::LAZY)
+    {
+        std::vector<int> ids;
+        if (!open_event_ids(first_id, last_id, &ids))
+            return false;
+        for (int id : ids)
+            if (!markets.find(id))
+                cold.insert(id);
+        cold_count = cold.size();
+        log_info("Open markets listed for lazy hydration", {{"markets", cold.size()}});
+        return true;
+    }
+
+    size_t hydrated = 0;
+    if (!open_event_ids(first_id, last_id) || !hydrate_span(first_id, last_id, nullptr, hydrated))
+        return false;
+    log_info("Markets hydrated", {{"markets", hydrated},
+                                  {"ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()}});
+    return true;
+}
+
+LMSRContract *MarketHydrator::find(int id)
+{
+    LMSRContract *contract = markets.find(id);
+    if (contract || pending() == 0)
+        return contract;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((contract = markets.find(id)))
+        return contract; // hydrated while we waited
+    auto it = cold.find(id);
+    if (it == cold.end())
+        return nullptr;
+
+    std::vector<EventState> states;
+    if (!load_event_states(id, id, states))
+        return nullptr; // stays cold; the next request retries
+    cold.erase(it);
+    cold_count = cold.size();
+    return states.empty() ? nullptr : insert(states.front());
+}
+
+bool MarketHydrator::hydrate_all()
+{
+    if (pending() == 0)
+        return true;
+
+    TraceSpan span("MarketHydrator::hydrate_all");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cold.empty())
+        return true;
+
+    auto range = std::minmax_element(cold.begin(), cold.end());
+    size_t hydrated = 0;
+    if (!hydrate_span(*range.first, *range.second, &cold, hydrated))
+        return false;
+    log_info("Cold markets hydrated", {{"markets", hydrated}});
+    cold.clear();
+    cold_count = 0;
+    return true;
+}
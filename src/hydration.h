@@ -0,0 +1,56 @@
+#pragma once
+#include "event.h"
+#include "registry.h"
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_set>
+
+
+enum class HydrationMode {
+    EAGER, // every open market before the service reports ready
+    LAZY   // each market on first access; all of them once a full listing is needed
+};
+
+struct HydrationConfig {
+    HydrationMode mode = HydrationMode::EAGER;
+    size_t threads = 0; // workers for a full hydration; 0 = one per hardware thread
+};
+
+// Rebuilds the open markets into a MarketRegistry at startup.
+//
+// Only the numeric events columns are read (load_event_states). A full
+// hydration splits the open id span into one slice per worker; each worker
+// scans its slice on its own connection, builds the contracts and inserts
+// them. In lazy mode start() only collects the open ids, and find() builds a
+// missing market from its row the first time it is asked for.
+class MarketHydrator
+{
+    private:
+        MarketRegistry &markets;
+        HydrationConfig config;
+        std::mutex mutex;                  // serialises hydration
+        std::unordered_set<int> cold;      // open but not hydrated yet (lazy)
+        std::atomic<size_t> cold_count{0}; // cold.size(), read without the lock
+
+        bool hydrate_span(int first_id, int last_id, const std::unordered_set<int> *only, size_t &hydrated);
+        LMSRContract *insert(EventState &state);
+
+    public:
+        explicit MarketHydrator(MarketRegistry &markets_) : markets(markets_) {}
+        MarketHydrator(const MarketHydrator &) = delete;
+        MarketHydrator &operator=(const MarketHydrator &) = delete;
+
+        // eager: hydrates every open market; lazy: only lists them. False if
+        // the database could not be read.
+        bool start(const HydrationConfig &config_);
+
+        // the open market with this id, hydrating it first if it is cold;
+        // nullptr if there is none
+        LMSRContract *find(int id);
+
+        // hydrates every cold market (before iterating all of them)
+        bool hydrate_all();
+
+        size_t pending() const { return cold_count.load(std::memory_order_acquire); }
+};
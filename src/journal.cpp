@@ -0,0 +1,224 @@
+#include "journal.h"
+#include "database.h" // for record_fills, log_fills
+#include "logger.h"
+#include "trace.h"
+#include "utils.h"
+
+
+OrderJournal::~OrderJournal()
+{
+    stop();
+}
+
+bool OrderJournal::start(const JournalConfig &config_)
+{
+    stop();
+    config = config_;
+    failed_markets.clear();
+    if (config.group_max_orders == 0)
+        config.group_max_orders = 1;
+
+    if (config.storage == StorageEngine::BINLOG && config.durability != Durability::NONE)
+    {
+        binlog.reset(new Binlog());
+        if (!binlog->open(config.binlog))
+        {
+            binlog.reset();
+            return false;
+        }
+    }
+
+    if (config.durability == Durability::SYNC || config.durability == Durability::NONE)
+        return true; // fills are committed by the caller (or not at all), no writer needed
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        running = true;
+    }
+    writer = std::thread(&OrderJournal::writer_loop, this);
+    return true;
+}
+
+void OrderJournal::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        running = false;
+    }
+    queue_cv.notify_all();
+    if (writer.joinable())
+        writer.join();
+
+    // after the writer: its last batch still goes to the log
+    if (binlog)
+        binlog->close();
+    binlog.reset();
+}
+
+bool OrderJournal::persist(const std::vector<Fill> &fills)
+{
+    if (!binlog)
+        return record_fills(fills);
+
+    // ASYNC confirms before the disk: the feeder thread msyncs shortly after
+    if (!binlog->append(fills, config.durability != Durability::ASYNC))
+    {
+        log_error("Failed to append fills to the binlog.", {{"fills", fills.size()}});
+        return false;
+    }
+    log_fills(fills);
+    return true;
+}
+
+void OrderJournal::recover(EventState &state) const
+{
+    LoggedMarketState logged;
+    if (!binlog || !binlog->logged_state(state.id, logged) || logged.order_count <= state.order_count)
+        return;
+    state.q_yes = logged.q_yes;
+    state.q_no = logged.q_no;
+    state.event_funds = logged.event_funds;
+    state.order_count = logged.order_count;
+    state.aggregates = logged.aggregates;
+}
+
+std::future<bool> OrderJournal::submit(std::vector<Fill> fills)
+{
+    Pending pending{std::move(fills), std::promise<bool>(), config.durability == Durability::GROUP};
+    std::future<bool> result = pending.durable.get_future();
+
+    if (!pending.has_waiter)
+        pending.durable.set_value(true); // ASYNC: confirmed before it is durable
+
+    size_t queued;
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        if (!running)
+        {
+            // journal not started (or already stopped): commit inline
+            lock.unlock();
+            bool ok = persist(pending.fills);
+            if (pending.has_waiter)
+                pending.durable.set_value(ok);
+            return result;
+        }
+        if (queue.empty())
+            oldest_enqueued = std::chrono::steady_clock::now();
+        queue.push_back(std::move(pending));
+        queued = queue.size();
+    }
+
+    if (queued == 1 || queued >= config.group_max_orders)
+        queue_cv.notify_one();
+
+    return result;
+}
+
+void OrderJournal::sync()
+{
+    std::future<bool> done;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (running)
+        {
+            Pending marker{{}, std::promise<bool>(), true};
+            done = marker.durable.get_future();
+            if (queue.empty())
+                oldest_enqueued = std::chrono::steady_clock::now();
+            queue.push_back(std::move(marker));
+        }
+    }
+    if (done.valid())
+    {
+        queue_cv.notify_one();
+        done.wait();
+    }
+    if (binlog)
+        binlog->wait_fed();
+}
+
+// ---------------- writer thread ----------------
+void OrderJournal::writer_loop()
+{
+    std::vector<Pending> batch;
+
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true)
+    {
+        queue_cv.wait(lock, [this] { return !queue.empty() || !running; });
+        if (queue.empty() && !running)
+            break;
+
+        // let the batch fill up to N orders or until the oldest waited M us
+        auto deadline = oldest_enqueued + config.group_max_delay;
+        queue_cv.wait_until(lock, deadline, [this] {
+            return queue.size() >= config.group_max_orders || !running;
+        });
+
+        batch.swap(queue);
+        lock.unlock();
+
+        flush(batch);
+        batch.clear();
+
+        lock.lock();
+    }
+}
+
+void OrderJournal::flush(std::vector<Pending> &batch)
+{
+    TraceSpan span("OrderJournal::flush");
+    auto follows_failure = [this](const Pending &p) {
+        for (const Fill &fill : p.fills)
+            if (failed_markets.count(fill.event_id))
+                return true;
+        return false;
+    };
+
+    bool clean = true;
+    std::vector<Fill> all;
+    for (const auto &p : batch)
+    {
+        clean = clean && !follows_failure(p);
+        all.insert(all.end(), p.fills.begin(), p.fills.end());
+    }
+
+    if (clean && persist(all))
+    {
+        for (auto &p : batch)
+            if (p.has_waiter)
+                p.durable.set_value(true);
+        return;
+    }
+
+    // one bad submission must not fail the rest of the batch: retry each alone
+    // (a lone submission already failed above, unless it was never tried)
+    size_t failed = 0;
+    for (auto &p : batch)
+    {
+        bool ok = !follows_failure(p) && (batch.size() > 1 || !clean) && persist(p.fills);
+        if (!ok)
+        {
+            failed += p.fills.size();
+            if (config.durability == Durability::GROUP)
+                for (const Fill &fill : p.fills)
+                    failed_markets.insert(fill.event_id);
+        }
+        if (p.has_waiter)
+            p.durable.set_value(ok);
+    }
+
+    if (failed > 0 && config.durability == Durability::GROUP)
+        log_error("[JOURNAL] Fills could not be persisted; their markets are rolled back and closed until restart.",
+                  {{"fills", failed}});
+    else if (failed > 0)
+        log_error("[JOURNAL] Fills could not be persisted; in-memory market state is ahead of the database until restart.",
+                  {{"fills", failed}});
+}
+
+
+OrderJournal &order_journal()
+{
+    static OrderJournal journal;
+    return journal;
+}
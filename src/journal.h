@@ -0,0 +1,95 @@
+#pragma once
+#include "binlog.h"
+#include "event.h"
+#include "orders.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+
+// How a fill has to reach disk before its order is confirmed.
+enum class Durability {
+    SYNC,   // commit inside buy(), one transaction per order
+    GROUP,  // writer thread commits batches; confirm once the batch is durable
+    ASYNC,  // writer thread commits batches; confirm immediately
+    NONE    // never persisted; benchmarks and load tests only
+};
+
+// Where fills are made durable.
+enum class StorageEngine {
+    SQLITE, // order_book rows and events state, one transaction per commit
+    BINLOG  // append-only log (binlog.h); SQLite is fed from it in the background
+};
+
+struct JournalConfig {
+    Durability durability = Durability::SYNC;
+    StorageEngine storage = StorageEngine::SQLITE;
+    BinlogConfig binlog;
+    size_t group_max_orders = 64;                          // flush when this many fills are pending
+    std::chrono::microseconds group_max_delay{2000};      // ... or when the oldest has waited this long
+};
+
+// Funnels fills from every market into a single writer thread so that
+// concurrent orders share one commit (group commit), and owns the storage
+// engine those commits go to.
+class OrderJournal {
+    private:
+        struct Pending {
+            std::vector<Fill> fills;
+            std::promise<bool> durable;
+            bool has_waiter;
+        };
+
+        JournalConfig config;
+        std::mutex queue_mutex;
+        std::condition_variable queue_cv;
+        std::vector<Pending> queue;
+        std::chrono::steady_clock::time_point oldest_enqueued;
+        bool running = false;
+        std::thread writer;
+        std::unique_ptr<Binlog> binlog; // BINLOG storage
+        // GROUP: markets with a fill that could not be persisted. Their later
+        // fills carry state built on top of it, so they fail too (writer
+        // thread only; the waiters roll the market back and close it).
+        std::unordered_set<int> failed_markets;
+
+
+        void writer_loop();
+        void flush(std::vector<Pending> &batch);
+
+    public:
+        ~OrderJournal();
+
+        // false if the storage engine could not be opened
+        bool start(const JournalConfig &config_);
+        void stop();   // drains everything still queued
+
+        Durability durability() const { return config.durability; }
+
+        // Makes fills durable together in the configured storage; false if
+        // they were not persisted. Called by buy() in SYNC mode and by the
+        // writer thread.
+        bool persist(const std::vector<Fill> &fills);
+
+        // Queue fills that must commit together. The future becomes true
+        // once they are durable (GROUP) or right away (ASYNC), false if
+        // the commit failed or, under GROUP, an earlier fill of one of
+        // their markets did. Not used in SYNC or NONE mode.
+        std::future<bool> submit(std::vector<Fill> fills);
+
+        // blocks until every fill submitted so far has been committed
+        // (and, with BINLOG storage, copied into SQLite)
+        void sync();
+
+        // BINLOG storage: replaces an event's stored market state with the
+        // logged one when SQLite has not caught up with the log yet
+        void recover(EventState &state) const;
+};
+
+OrderJournal &order_journal();
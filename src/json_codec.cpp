@@ -0,0 +1,297 @@
+#include "json_codec.h"
+#include "json.hpp" // nlohmann::detail::to_chars, the float formatting dump() uses
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+
+// ---------------- writing ----------------
+// Appends to the calling thread's buffer. Responses here are a few dozen
+// bytes; an oversized error message is cut rather than overflowing.
+class JsonWriter
+{
+    private:
+        static constexpr size_t capacity = 1024;
+        char *begin;
+        char *p;
+
+        bool fits(size_t bytes) const { return static_cast<size_t>(p - begin) + bytes <= capacity; }
+
+    public:
+        JsonWriter()
+        {
+            static thread_local char buffer[capacity];
+            begin = p = buffer;
+        }
+
+        void raw(std::string_view text)
+        {
+            if (!fits(text.size()))
+                return;
+            std::memcpy(p, text.data(), text.size());
+            p += text.size();
+        }
+
+        // dump() of an integer
+        void number(long long value)
+        {
+            p = std::to_chars(p, begin + capacity, value).ptr;
+        }
+
+        // dump() of a double: shortest round-trip digits, ".0" on whole
+        // numbers, null for NaN and infinities
+        void number(double value)
+        {
+            if (!std::isfinite(value))
+                raw("null");
+            else if (fits(32))
+                p = nlohmann::detail::to_chars(p, begin + capacity, value);
+        }
+
+        // a JSON string with dump()'s escapes (ASCII input)
+        void string(std::string_view text)
+        {
+            static const char hex[] = "0123456789abcdef";
+            raw("\"");
+            for (char c : text)
+            {
+                if (!fits(7))
+                    break;
+                switch (c)
+                {
+                case '"':  raw("\\\""); break;
+                case '\\': raw("\\\\"); break;
+                case '\b': raw("\\b"); break;
+                case '\f': raw("\\f"); break;
+                case '\n': raw("\\n"); break;
+                case '\r': raw("\\r"); break;
+                case '\t': raw("\\t"); break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char escaped[] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                        raw(std::string_view(escaped, sizeof escaped));
+                    }
+                    else
+                        *p++ = c;
+                }
+            }
+            if (!fits(2))
+                p = begin + capacity - 2; // keep the closing quote and brace
+            raw("\"");
+        }
+
+        std::string_view text() const { return std::string_view(begin, static_cast<size_t>(p - begin)); }
+};
+
+std::string_view quote_json(const Quote &quote)
+{
+    JsonWriter out;
+    out.raw("{\"max_stake\":");
+    out.number(static_cast<long long>(static_cast<int>(quote.size)));
+    out.raw(",\"no_price\":");
+    out.number(round_cents(quote.price_no));
+    out.raw(",\"yes_price\":");
+    out.number(round_cents(quote.price_yes));
+    out.raw("}");
+    return out.text();
+}
+
+std::string_view order_json(const Order &order)
+{
+    JsonWriter out;
+    out.raw("{\"event_id\":");
+    out.number(static_cast<long long>(order.event_id));
+    out.raw(",\"expected_cashout\":");
+    out.number(order.expected_cashout.rounded());
+    out.raw(",\"price\":");
+    out.number(order.price.rounded());
+    out.raw(order.side == Side::YES ? ",\"side\":\"yes\",\"stake\":" : ",\"side\":\"no\",\"stake\":");
+    out.number(order.stake.rounded());
+    out.raw("}");
+    return out.text();
+}
+
+std::string_view error_json(std::string_view message)
+{
+    JsonWriter out;
+    out.raw("{\"error\":");
+    out.string(message);
+    out.raw("}");
+    return out.text();
+}
+
+std::string_view stake_error_json(int max_stake)
+{
+    JsonWriter out;
+    out.raw("{\"error\":\"Invalid stake amount, must be > 0 and <= ");
+    out.number(static_cast<long long>(max_stake));
+    out.raw("\"}");
+    return out.text();
+}
+
+
+// ---------------- reading ----------------
+namespace
+{
+    enum class ValueKind { STRING, NUMBER, LITERAL };
+
+    struct Cursor
+    {
+        const char *p;
+        const char *end;
+
+        void skip_whitespace()
+        {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+                ++p;
+        }
+
+        bool take(char c)
+        {
+            if (p < end && *p == c)
+            {
+                ++p;
+                return true;
+            }
+            return false;
+        }
+
+        bool digit() const { return p < end && *p >= '0' && *p <= '9'; }
+
+        // a string of printable ASCII without escapes; its contents in `out`
+        bool plain_string(std::string_view &out)
+        {
+            if (!take('"'))
+                return false;
+            const char *start = p;
+            while (p < end && *p != '"')
+            {
+                if (*p == '\\' || static_cast<unsigned char>(*p) < 0x20 || static_cast<unsigned char>(*p) > 0x7E)
+                    return false;
+                ++p;
+            }
+            if (p == end)
+                return false;
+            out = std::string_view(start, static_cast<size_t>(p - start));
+            ++p;
+            return true;
+        }
+
+        // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        bool number(std::string_view &out)
+        {
+            const char *start = p;
+            take('-');
+            if (take('0'))
+                ;
+            else if (digit())
+                while (digit())
+                    ++p;
+            else
+                return false;
+            if (take('.'))
+            {
+                if (!digit())
+                    return false;
+                while (digit())
+                    ++p;
+            }
+            if (take('e') || take('E'))
+            {
+                if (!take('+'))
+                    take('-');
+                if (!digit())
+                    return false;
+                while (digit())
+                    ++p;
+            }
+            out = std::string_view(start, static_cast<size_t>(p - start));
+            return true;
+        }
+
+        bool literal(const char *word)
+        {
+            size_t n = std::strlen(word);
+            if (static_cast<size_t>(end - p) < n || std::memcmp(p, word, n) != 0)
+                return false;
+            p += n;
+            return true;
+        }
+
+        // a scalar value; false for containers and anything malformed
+        bool value(ValueKind &kind, std::string_view &text)
+        {
+            if (p == end)
+                return false;
+            if (*p == '"')
+            {
+                kind = ValueKind::STRING;
+                return plain_string(text);
+            }
+            if (*p == '-' || digit())
+            {
+                kind = ValueKind::NUMBER;
+                return number(text);
+            }
+            kind = ValueKind::LITERAL;
+            return literal("true") || literal("false") || literal("null");
+        }
+    };
+}
+
+OrderBodyParse parse_order_body(std::string_view body, double &stake, std::string_view &side)
+{
+    Cursor in{body.data(), body.data() + body.size()};
+    bool have_stake = false, have_side = false;
+
+    in.skip_whitespace();
+    if (!in.take('{'))
+        return OrderBodyParse::FALLBACK;
+    in.skip_whitespace();
+    if (!in.take('}'))
+    {
+        while (true)
+        {
+            std::string_view key, text;
+            ValueKind kind;
+            in.skip_whitespace();
+            if (!in.plain_string(key))
+                return OrderBodyParse::FALLBACK;
+            in.skip_whitespace();
+            if (!in.take(':'))
+                return OrderBodyParse::FALLBACK;
+            in.skip_whitespace();
+            if (!in.value(kind, text))
+                return OrderBodyParse::FALLBACK;
+
+            if (key == "stake")
+            {
+                // nlohmann would also convert true/false, or throw on a string
+                if (have_stake || kind != ValueKind::NUMBER)
+                    return OrderBodyParse::FALLBACK;
+                auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), stake);
+                if (error != std::errc() || end != text.data() + text.size())
+                    return OrderBodyParse::FALLBACK; // out of range
+                have_stake = true;
+            }
+            else if (key == "side")
+            {
+                if (have_side || kind != ValueKind::STRING)
+                    return OrderBodyParse::FALLBACK;
+                side = text;
+                have_side = true;
+            }
+
+            in.skip_whitespace();
+            if (in.take('}'))
+                break;
+            if (!in.take(','))
+                return OrderBodyParse::FALLBACK;
+        }
+    }
+    in.skip_whitespace();
+    if (in.p != in.end)
+        return OrderBodyParse::FALLBACK;
+    return have_stake && have_side ? OrderBodyParse::OK : OrderBodyParse::MISSING_FIELD;
+}
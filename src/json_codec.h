@@ -0,0 +1,42 @@
+#pragma once
+#include "contract.h"
+#include "orders.h"
+#include <cstddef>
+#include <string_view>
+
+
+// Fixed-schema JSON for the hot routes (GET /quote/<id>, POST /order/<id>).
+//
+// The writers produce exactly what the nlohmann::json objects they replace
+// dump() to (keys in sorted order, the same number formatting), straight
+// into a buffer owned by the calling thread: no tree, no per-key
+// allocation, no fresh string. The result stays valid until the thread's
+// next call to any of them. None of these functions allocates (checked by
+// json_codec/no_alloc); the HTTP routes around them still do.
+//
+// The order-body reader picks `stake` and `side` out of the body in one
+// pass without building a DOM. It only takes the common shape, a flat
+// object of plain strings, numbers and literals; anything else (nesting,
+// escapes, non-ASCII, repeated keys, a `stake` that is not a number...) is
+// left to nlohmann::json::parse, so malformed and odd bodies get the same
+// responses as before.
+
+// {"max_stake":...,"no_price":...,"yes_price":...}
+std::string_view quote_json(const Quote &quote);
+
+// {"event_id":...,"expected_cashout":...,"price":...,"side":"yes","stake":...}
+std::string_view order_json(const Order &order);
+
+// {"error":"<message>"}
+std::string_view error_json(std::string_view message);
+
+// {"error":"Invalid stake amount, must be > 0 and <= <max_stake>"}
+std::string_view stake_error_json(int max_stake);
+
+enum class OrderBodyParse {
+    OK,             // `stake` and `side` are set (`side` points into the body)
+    MISSING_FIELD,  // a valid object without `stake` or `side`
+    FALLBACK        // not handled here: parse the body with nlohmann
+};
+
+OrderBodyParse parse_order_body(std::string_view body, double &stake, std::string_view &side);
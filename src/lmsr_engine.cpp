@@ -0,0 +1,46 @@
+#include "lmsr_engine.h"
+#include "simd.h"
+
+
+double lmsr_exp_sum(const double *q, size_t n, double b, double &shift, double *weights)
+{
+    // pass 1: the largest quantity, so every exponent is <= 0
+    size_t i = 0;
+    double m = q[0];
+#ifdef KERNEL_SIMD
+    if (n >= simd_lanes)
+    {
+        vf64 lane_max = vload(q);
+        for (i = simd_lanes; i + simd_lanes <= n; i += simd_lanes)
+            lane_max = vmax(lane_max, vload(q + i));
+        m = vhmax(lane_max);
+    }
+#endif
+    for (; i < n; ++i)
+        m = vmax(m, q[i]);
+    shift = m;
+
+    // pass 2: e^((q_i - m)/b), summed (and stored)
+    const double inv_b = 1.0 / b;
+    double sum = 0.0;
+    i = 0;
+#ifdef KERNEL_SIMD
+    vf64 lane_sum = vsplat(0.0);
+    for (; i + simd_lanes <= n; i += simd_lanes)
+    {
+        vf64 w = poly_exp((vload(q + i) - m) * inv_b);
+        if (weights)
+            vstore(weights + i, w);
+        lane_sum += w;
+    }
+    sum = vhsum(lane_sum);
+#endif
+    for (; i < n; ++i)
+    {
+        double w = poly_exp((q[i] - m) * inv_b);
+        if (weights)
+            weights[i] = w;
+        sum += w;
+    }
+    return sum;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+
+// ---------------- log-sum-exp kernel ----------------
+// With m = max_i q_i and w_i = e^((q_i - m)/b): returns sum_i w_i and sets
+// `shift` to m; stores the w_i when `weights` is not null. Vectorised on
+// GCC/Clang with the quote kernel's branch-free exp (relative error < 2e-16). C(q) = m + b*log(sum) and p_i = w_i / sum.
+double lmsr_exp_sum(const double *q, size_t n, double b, double &shift, double *weights = nullptr);
+
+// N as a runtime argument instead of a template parameter
+constexpr size_t dynamic_outcomes = 0;
+
+// Pricing state of one logarithmic market scoring rule market maker with N
+// mutually exclusive outcomes (a binary market is N = 2, YES = 0, NO = 1):
+//
+//   C(q) = b * log(sum_i e^(q_i/b)),   p_i = e^(q_i/b) / sum_j e^(q_j/b)
+//
+// The market maker's worst-case loss is b*log(N), so b = risk_cap / log(N)
+// and one cap covers every outcome. Quantities sit in one contiguous array;
+// N > 2 goes through lmsr_exp_sum, while N = 2 keeps the closed forms the
+// binary contract has always used (logistic price, log1p cost), bit for bit.
+// LmsrEngine<dynamic_outcomes> takes the outcome count from its quantities.
+//
+// Not thread-safe; the owner serialises access (LMSRContract's mutex).
+template <size_t N>
+class LmsrEngine
+{
+    static_assert(N == dynamic_outcomes || N >= 2, "an LMSR market needs at least two outcomes");
+
+    public:
+        using Quantities = std::conditional_t<N == dynamic_outcomes, std::vector<double>, std::array<double, N>>;
+
+    private:
+        Quantities q;
+        double risk_cap;
+        double b;
+        double base_cost; // C(0), what an empty market "costs"
+
+    public:
+        // dynamic_outcomes: q_.size() (at least 2) is the outcome count
+        explicit LmsrEngine(double risk_cap_, const Quantities &q_ = Quantities{})
+            : q(q_), risk_cap(risk_cap_), b(risk_cap_ / std::log(static_cast<double>(q_.size())))
+        {
+            Quantities zero = q_;
+            std::fill(zero.begin(), zero.end(), 0.0);
+            base_cost = cost(zero);
+        }
+
+        size_t outcomes() const { return q.size(); }
+        const Quantities &quantities() const { return q; }
+        double quantity(size_t i) const { return q[i]; }
+        void set_quantities(const Quantities &q_) { q = q_; }
+        void add_shares(size_t i, double shares) { q[i] += shares; }
+
+        double liquidity() const { return b; }
+        double risk_limit() const { return risk_cap; }
+
+        double cost(const Quantities &at) const
+        {
+            if constexpr (N == 2)
+            {
+                // = max(q0, q1) + b*log1p(e^(-|q0-q1|/b)), no overflow
+                return std::max(at[0], at[1]) + b * std::log1p(std::exp(-std::fabs(at[0] - at[1]) / b));
+            }
+            else
+            {
+                double shift;
+                double sum = lmsr_exp_sum(at.data(), at.size(), b, shift);
+                return shift + b * std::log(sum);
+            }
+        }
+        double cost() const { return cost(q); }
+
+        // C(q) - C(0): what the market maker has at risk so far
+        double loss() const { return cost() - base_cost; }
+        double remaining_risk() const { return risk_cap - loss(); }
+
+        double price(size_t i) const
+        {
+            if constexpr (N == 2)
+            {
+                // logistic of the inventory imbalance
+                double imbalance = (i == 0) ? (q[0] - q[1]) : (q[1] - q[0]);
+                return 1.0 / (1.0 + std::exp(-imbalance / b));
+            }
+            else
+            {
+                double shift;
+                double sum = lmsr_exp_sum(q.data(), q.size(), b, shift);
+                return std::exp((q[i] - shift) / b) / sum;
+            }
+        }
+
+        // every outcome's price in one pass; `out` holds outcomes() values
+        void prices(double *out) const
+        {
+            if constexpr (N == 2)
+            {
+                out[0] = price(0);
+                out[1] = price(1);
+            }
+            else
+            {
+                double shift;
+                double sum = lmsr_exp_sum(q.data(), q.size(), b, shift, out);
+                double inv_sum = 1.0 / sum;
+                for (size_t i = 0; i < q.size(); ++i)
+                    out[i] *= inv_sum;
+            }
+        }
+
+        // the binary market's sizing rule, per outcome: raising every
+        // quantity by the remaining risk R raises C by exactly R, and a stake
+        // of b*p_i*(e^(R/b) - 1) buys outcome i that far
+        double max_stake(size_t i) const
+        {
+            double remaining = remaining_risk();
+            if (remaining <= 0)
+                return 0.0;
+            return b * price(i) * std::expm1(remaining / b);
+        }
+
+        // shares of outcome i that cost exactly `money`:
+        // C(q + d*e_i) - C(q) = money  =>  d = b*log1p(expm1(money/b) / p_i)
+        double solve_delta_q(size_t i, double money) const
+        {
+            if (money <= 0.0)
+                return 0.0;
+            return b * std::log1p(std::expm1(money / b) / price(i));
+        }
+
+        // shares an order of `stake` on outcome i receives (the fill rule of
+        // LMSRContract::execute)
+        double shares_for_stake(size_t i, double stake) const
+        {
+            return b * std::log(1 + stake / (b * price(i)));
+        }
+};
@@ -0,0 +1,313 @@
+#include "logger.h"
+#include "metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<LogLevel> log_detail::min_level{LogLevel::INFO};
+
+
+// ---------------- per-thread rings ----------------
+struct LogRecord
+{
+    int64_t wall_ns;
+    const char *message;
+    LogLevel level;
+    uint8_t field_count;
+    LogField fields[log_max_fields];
+};
+
+// one producer (the owning thread), one consumer (the writer)
+struct LogRing
+{
+    alignas(64) std::atomic<uint64_t> head{0}; // next record to write
+    alignas(64) std::atomic<uint64_t> tail{0}; // next record to drain
+    LogRecord records[log_ring_capacity];
+};
+
+struct RingList
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<LogRing>> rings;
+};
+
+static RingList &ring_list()
+{
+    static RingList list;
+    return list;
+}
+
+static LogRing &local_ring()
+{
+    thread_local LogRing *ring = nullptr;
+    if (!ring)
+    {
+        auto owned = std::unique_ptr<LogRing>(new LogRing());
+        ring = owned.get();
+        RingList &list = ring_list();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.rings.push_back(std::move(owned));
+    }
+    return *ring;
+}
+
+void log_write(LogLevel level, const char *message, std::initializer_list<LogField> fields)
+{
+    LogRing &ring = local_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= log_ring_capacity)
+    {
+        metrics_count(MetricCounter::LOG_RECORDS_DROPPED);
+        return;
+    }
+
+    LogRecord &record = ring.records[head % log_ring_capacity];
+    record.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+    record.message = message;
+    record.level = level;
+    record.field_count = 0;
+    for (const LogField &field : fields)
+    {
+        if (record.field_count == log_max_fields)
+            break;
+        record.fields[record.field_count++] = field;
+    }
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+
+// ---------------- formatting ----------------
+static const char *level_name(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::DEBUG: return "debug";
+    case LogLevel::INFO:  return "info";
+    case LogLevel::WARN:  return "warn";
+    case LogLevel::ERROR: return "error";
+    case LogLevel::OFF:   break;
+    }
+    return "off";
+}
+
+// same colours as success_msg / warning_msg / error_msg
+static const char *level_colour(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::INFO:  return "\033[92m";
+    case LogLevel::WARN:  return "\033[2;33m";
+    case LogLevel::ERROR: return "\033[91m";
+    default:              return "";
+    }
+}
+
+static void append_text(std::string &out, const char *text)
+{
+    bool quote = *text == '\0' || std::strpbrk(text, " =\"") != nullptr;
+    if (!quote)
+    {
+        out += text;
+        return;
+    }
+    out += '"';
+    for (const char *c = text; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        out += *c;
+    }
+    out += '"';
+}
+
+static void append_fields(std::string &out, const LogRecord &record)
+{
+    char number[32];
+    for (uint8_t f = 0; f < record.field_count; ++f)
+    {
+        const LogField &field = record.fields[f];
+        out += ' ';
+        out += field.key;
+        out += '=';
+        switch (field.kind)
+        {
+        case LogField::Kind::INT:
+            std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(field.i));
+            out += number;
+            break;
+        case LogField::Kind::DOUBLE:
+            std::snprintf(number, sizeof(number), "%.10g", field.d);
+            out += number;
+            break;
+        case LogField::Kind::BOOL:
+            out += field.b ? "true" : "false";
+            break;
+        case LogField::Kind::TEXT:
+            append_text(out, field.text);
+            break;
+        }
+    }
+}
+
+// console: "<colour>message key=value ...<reset>"
+static void format_console(std::string &out, const LogRecord &record)
+{
+    out += level_colour(record.level);
+    out += record.message;
+    append_fields(out, record);
+    out += "\033[0m\n";
+}
+
+// file: logfmt, "ts=2026-01-02T03:04:05.678901Z level=info msg=\"...\" key=value ..."
+static void format_file(std::string &out, const LogRecord &record)
+{
+    std::time_t seconds = static_cast<std::time_t>(record.wall_ns / 1'000'000'000);
+    char stamp[48];
+    size_t n = std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", std::gmtime(&seconds)); // writer thread only
+    std::snprintf(stamp + n, sizeof(stamp) - n, ".%06lldZ",
+                  static_cast<long long>(record.wall_ns % 1'000'000'000 / 1000));
+
+    out += "ts=";
+    out += stamp;
+    out += " level=";
+    out += level_name(record.level);
+    out += " msg=";
+    append_text(out, record.message);
+    append_fields(out, record);
+    out += '\n';
+}
+
+
+// ---------------- writer ----------------
+struct Writer
+{
+    std::mutex mutex; // guards the fields below
+    std::condition_variable wake;
+    std::thread thread;
+    bool stopping = false;
+    FILE *file = nullptr; // null: console
+
+    // reused across drains so the writer does not allocate in steady state
+    std::vector<LogRecord> batch;
+    std::string text;
+};
+
+static Writer writer;
+
+// moves every queued record out of the rings and writes them in time order
+static bool drain(Writer &w)
+{
+    w.batch.clear();
+    {
+        RingList &list = ring_list();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        for (const auto &ring : list.rings)
+        {
+            uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail < head; ++tail)
+                w.batch.push_back(ring->records[tail % log_ring_capacity]);
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+    if (w.batch.empty())
+        return false;
+
+    std::sort(w.batch.begin(), w.batch.end(), [](const LogRecord &a, const LogRecord &b) {
+        return a.wall_ns < b.wall_ns;
+    });
+
+    w.text.clear();
+    for (const LogRecord &record : w.batch)
+    {
+        if (w.file)
+            format_file(w.text, record);
+        else
+            format_console(w.text, record);
+    }
+
+    if (w.file)
+    {
+        std::fwrite(w.text.data(), 1, w.text.size(), w.file);
+        std::fflush(w.file);
+    }
+    else
+    {
+        std::cout.write(w.text.data(), static_cast<std::streamsize>(w.text.size()));
+        std::cout.flush();
+    }
+    return true;
+}
+
+static void writer_loop()
+{
+    std::unique_lock<std::mutex> lock(writer.mutex);
+    while (true)
+    {
+        bool stop = writer.stopping;
+        bool wrote = drain(writer);
+        if (stop)
+            return;
+        // producers never signal (that would cost them a lock); poll instead
+        if (!wrote)
+            writer.wake.wait_for(lock, std::chrono::milliseconds(2));
+    }
+}
+
+bool logger_start(const LogConfig &config)
+{
+    logger_stop();
+
+    FILE *file = nullptr;
+    if (!config.file.empty())
+    {
+        file = std::fopen(config.file.c_str(), "a");
+        if (!file)
+            return false;
+    }
+
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    writer.file = file;
+    writer.stopping = false;
+    writer.batch.reserve(log_ring_capacity * 4);
+    writer.text.reserve(64 * 1024);
+    log_detail::min_level.store(config.level, std::memory_order_relaxed);
+    writer.thread = std::thread(writer_loop);
+    return true;
+}
+
+void logger_stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(writer.mutex);
+        if (!writer.thread.joinable())
+            return;
+        writer.stopping = true;
+    }
+    writer.wake.notify_one();
+    writer.thread.join();
+
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    if (writer.file)
+        std::fclose(writer.file);
+    writer.file = nullptr;
+}
+
+bool parse_log_level(const std::string &name, LogLevel &out)
+{
+    for (LogLevel level : {LogLevel::DEBUG, LogLevel::INFO, LogLevel::WARN, LogLevel::ERROR, LogLevel::OFF})
+        if (name == level_name(level))
+        {
+            out = level;
+            return true;
+        }
+    return false;
+}
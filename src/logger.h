@@ -0,0 +1,119 @@
+#pragma once
+#include "money.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <type_traits>
+
+
+// Asynchronous engine log.
+//
+// A log call copies its message pointer and fields into a fixed-size record
+// in the calling thread's ring (single producer, single consumer, no lock,
+// no heap) and returns; a background writer drains every ring, orders the
+// records by time and writes them to the console or a file. When a ring is
+// full the record is dropped and counted (ecb_log_records_dropped_total)
+// rather than blocking the order path.
+//
+// Interactive console output (prompts, tables, validation errors) still
+// goes through utils.h; this is for the engine's own events.
+
+enum class LogLevel : uint8_t {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+};
+
+struct LogConfig
+{
+    LogLevel level = LogLevel::INFO;
+    std::string file; // empty: console
+};
+
+constexpr size_t log_max_fields = 6;
+constexpr size_t log_text_capacity = 48;  // longer text values are truncated
+constexpr size_t log_ring_capacity = 1024; // records per thread
+
+// one key=value pair; the key must be a string literal, text values are copied
+struct LogField
+{
+    enum class Kind : uint8_t { INT, DOUBLE, BOOL, TEXT };
+
+    const char *key;
+    Kind kind;
+    union
+    {
+        int64_t i;
+        double d;
+        bool b;
+        char text[log_text_capacity];
+    };
+
+    LogField() : key(""), kind(Kind::INT), i(0) {}
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    LogField(const char *key_, T value) : key(key_), kind(Kind::INT), i(static_cast<int64_t>(value)) {}
+    LogField(const char *key_, double value) : key(key_), kind(Kind::DOUBLE), d(value) {}
+    LogField(const char *key_, Money value) : key(key_), kind(Kind::DOUBLE), d(value.to_double()) {}
+    LogField(const char *key_, bool value) : key(key_), kind(Kind::BOOL), b(value) {}
+    LogField(const char *key_, const char *value) : key(key_), kind(Kind::TEXT) { copy_text(value, std::strlen(value)); }
+    LogField(const char *key_, const std::string &value) : key(key_), kind(Kind::TEXT) { copy_text(value.data(), value.size()); }
+
+    private:
+        void copy_text(const char *value, size_t length)
+        {
+            length = length < log_text_capacity - 1 ? length : log_text_capacity - 1;
+            std::memcpy(text, value, length);
+            text[length] = '\0';
+        }
+};
+
+namespace log_detail
+{
+    extern std::atomic<LogLevel> min_level;
+}
+
+inline bool log_enabled(LogLevel level)
+{
+    return level >= log_detail::min_level.load(std::memory_order_relaxed);
+}
+
+// `message` must be a string literal; fields past log_max_fields are ignored
+void log_write(LogLevel level, const char *message, std::initializer_list<LogField> fields);
+
+inline void log_debug(const char *message, std::initializer_list<LogField> fields = {})
+{
+    if (log_enabled(LogLevel::DEBUG))
+        log_write(LogLevel::DEBUG, message, fields);
+}
+
+inline void log_info(const char *message, std::initializer_list<LogField> fields = {})
+{
+    if (log_enabled(LogLevel::INFO))
+        log_write(LogLevel::INFO, message, fields);
+}
+
+inline void log_warn(const char *message, std::initializer_list<LogField> fields = {})
+{
+    if (log_enabled(LogLevel::WARN))
+        log_write(LogLevel::WARN, message, fields);
+}
+
+inline void log_error(const char *message, std::initializer_list<LogField> fields = {})
+{
+    if (log_enabled(LogLevel::ERROR))
+        log_write(LogLevel::ERROR, message, fields);
+}
+
+// starts the writer thread (restarting it with the new config if running);
+// returns false if the log file cannot be opened
+bool logger_start(const LogConfig &config);
+// writes everything logged so far, then stops the writer
+void logger_stop();
+
+// "debug", "info", "warn", "error", "off"
+bool parse_log_level(const std::string &name, LogLevel &out);
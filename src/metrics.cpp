@@ -0,0 +1,337 @@
+#include "metrics.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+
+// ---------------- layout ----------------
+// latency bucket upper bounds, 5 us .. 10 s
+static constexpr uint64_t bucket_bounds_ns[] = {
+    5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+    1'000'000, 2'500'000, 5'000'000, 10'000'000, 25'000'000, 50'000'000,
+    100'000'000, 250'000'000, 500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000};
+static constexpr size_t bucket_count = sizeof(bucket_bounds_ns) / sizeof(bucket_bounds_ns[0]);
+
+static constexpr size_t route_count = static_cast<size_t>(HttpRoute::COUNT);
+static constexpr size_t histogram_count = static_cast<size_t>(MetricHistogram::COUNT);
+static constexpr size_t counter_count = static_cast<size_t>(MetricCounter::COUNT);
+static constexpr size_t gauge_count = static_cast<size_t>(MetricGauge::COUNT);
+static constexpr size_t order_status_count = static_cast<size_t>(OrderStatus::PERSIST_FAILED) + 1; // last enumerator
+static constexpr size_t status_class_count = 5; // 1xx .. 5xx
+
+struct HistogramCells
+{
+    std::atomic<uint64_t> buckets[bucket_count + 1]; // last one is +Inf
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum_ns;
+};
+
+// written only by its owning thread
+struct ThreadBlock
+{
+    HistogramCells histograms[histogram_count];
+    HistogramCells http_latency[route_count];
+    std::atomic<uint64_t> http_status[route_count][status_class_count];
+    std::atomic<uint64_t> counters[counter_count];
+    std::atomic<uint64_t> orders[order_status_count];
+};
+
+struct BlockList
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBlock>> blocks;
+};
+
+static BlockList &block_list()
+{
+    static BlockList list;
+    return list;
+}
+
+static std::atomic<int64_t> gauges[gauge_count];
+
+static ThreadBlock &local_block()
+{
+    thread_local ThreadBlock *block = nullptr;
+    if (!block)
+    {
+        auto owned = std::unique_ptr<ThreadBlock>(new ThreadBlock()); // value-init: all zero
+        block = owned.get();
+        BlockList &list = block_list();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        list.blocks.push_back(std::move(owned));
+    }
+    return *block;
+}
+
+// single writer: a plain load + store is enough and avoids a locked RMW
+static inline void bump(std::atomic<uint64_t> &cell, uint64_t n = 1)
+{
+    cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+static void observe(HistogramCells &h, std::chrono::nanoseconds elapsed)
+{
+    uint64_t ns = elapsed.count() > 0 ? static_cast<uint64_t>(elapsed.count()) : 0;
+    size_t bucket = static_cast<size_t>(
+        std::lower_bound(std::begin(bucket_bounds_ns), std::end(bucket_bounds_ns), ns) - std::begin(bucket_bounds_ns));
+    bump(h.buckets[bucket]);
+    bump(h.count);
+    bump(h.sum_ns, ns);
+}
+
+
+// ---------------- recording ----------------
+const char *http_route_label(HttpRoute route)
+{
+    switch (route)
+    {
+    case HttpRoute::EVENTS:       return "/events";
+    case HttpRoute::QUOTE:        return "/quote/:id";
+    case HttpRoute::QUOTES:       return "/quotes";
+    case HttpRoute::ORDER:        return "/order/:id";
+    case HttpRoute::ORDERS_BATCH: return "/orders/batch";
+    case HttpRoute::METRICS:      return "/metrics";
+    case HttpRoute::EVENT_METRICS: return "/metrics/:id";
+    case HttpRoute::TRACE:        return "/trace";
+    case HttpRoute::READY:        return "/ready";
+    case HttpRoute::STREAM_QUOTES: return "/stream/quotes";
+    case HttpRoute::OTHER:        return "other";
+    case HttpRoute::COUNT:        break;
+    }
+    return "other";
+}
+
+static const char *order_result_label(OrderStatus status)
+{
+    switch (status)
+    {
+    case OrderStatus::FILLED:            return "filled";
+    case OrderStatus::MARKET_NOT_FOUND:  return "not_found";
+    case OrderStatus::MARKET_CLOSED:     return "closed";
+    case OrderStatus::INVALID_ORDER:     return "invalid";
+    case OrderStatus::RISK_CAP_REACHED:  return "risk_cap";
+    case OrderStatus::EXCEEDS_MAX_STAKE: return "max_stake";
+    case OrderStatus::PERSIST_FAILED:    return "persist_failed";
+    }
+    return "unknown";
+}
+
+void metrics_observe(MetricHistogram histogram, std::chrono::nanoseconds elapsed)
+{
+    observe(local_block().histograms[static_cast<size_t>(histogram)], elapsed);
+}
+
+void metrics_count(MetricCounter counter, uint64_t n)
+{
+    bump(local_block().counters[static_cast<size_t>(counter)], n);
+}
+
+void metrics_count_request(HttpRoute route, int status, std::chrono::nanoseconds elapsed)
+{
+    ThreadBlock &block = local_block();
+    size_t r = static_cast<size_t>(route);
+    size_t status_class = static_cast<size_t>(std::min(std::max(status / 100, 1), 5) - 1);
+    bump(block.http_status[r][status_class]);
+    observe(block.http_latency[r], elapsed);
+}
+
+void metrics_count_order(OrderStatus status)
+{
+    bump(local_block().orders[static_cast<size_t>(status)]);
+}
+
+void metrics_gauge_set(MetricGauge gauge, int64_t value)
+{
+    gauges[static_cast<size_t>(gauge)].store(value, std::memory_order_relaxed);
+}
+
+void metrics_gauge_add(MetricGauge gauge, int64_t delta)
+{
+    gauges[static_cast<size_t>(gauge)].fetch_add(delta, std::memory_order_relaxed);
+}
+
+
+// ---------------- timed lock ----------------
+// uncontended acquisitions skip the first clock read and record zero wait
+TimedLock::TimedLock(std::mutex &m) : mutex(&m)
+{
+    if (mutex->try_lock())
+    {
+        acquired = std::chrono::steady_clock::now();
+        metrics_observe(MetricHistogram::CONTRACT_LOCK_WAIT, std::chrono::nanoseconds(0));
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    mutex->lock();
+    acquired = std::chrono::steady_clock::now();
+    metrics_observe(MetricHistogram::CONTRACT_LOCK_WAIT, acquired - start);
+    trace_complete("contract_mutex wait", start, acquired);
+}
+
+void TimedLock::unlock()
+{
+    if (!mutex)
+        return;
+    auto released = std::chrono::steady_clock::now();
+    mutex->unlock();
+    mutex = nullptr;
+    metrics_observe(MetricHistogram::CONTRACT_LOCK_HOLD, released - acquired);
+    trace_complete("contract_mutex held", acquired, released);
+}
+
+
+// ---------------- exposition ----------------
+// sums of every thread's block, taken at scrape time
+struct HistogramTotals
+{
+    uint64_t buckets[bucket_count + 1] = {};
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+
+    void add(const HistogramCells &h)
+    {
+        for (size_t i = 0; i <= bucket_count; ++i)
+            buckets[i] += h.buckets[i].load(std::memory_order_relaxed);
+        count += h.count.load(std::memory_order_relaxed);
+        sum_ns += h.sum_ns.load(std::memory_order_relaxed);
+    }
+};
+
+struct Totals
+{
+    HistogramTotals histograms[histogram_count];
+    HistogramTotals http_latency[route_count];
+    uint64_t http_status[route_count][status_class_count] = {};
+    uint64_t counters[counter_count] = {};
+    uint64_t orders[order_status_count] = {};
+};
+
+static void append(std::string &out, const char *format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    int n = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n > 0)
+        out.append(line, std::min(static_cast<size_t>(n), sizeof(line) - 1));
+}
+
+static void header(std::string &out, const char *name, const char *type, const char *help)
+{
+    append(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+// `labels` is either empty or `key="value",` (trailing comma kept for le)
+static void histogram_series(std::string &out, const char *name, const std::string &labels, const HistogramTotals &h)
+{
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bucket_count; ++i)
+    {
+        cumulative += h.buckets[i];
+        append(out, "%s_bucket{%sle=\"%g\"} %llu\n", name, labels.c_str(),
+               static_cast<double>(bucket_bounds_ns[i]) / 1e9, static_cast<unsigned long long>(cumulative));
+    }
+    cumulative += h.buckets[bucket_count];
+    append(out, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, labels.c_str(), static_cast<unsigned long long>(cumulative));
+
+    std::string plain = labels.empty() ? "" : "{" + labels.substr(0, labels.size() - 1) + "}";
+    append(out, "%s_sum%s %.9f\n", name, plain.c_str(), static_cast<double>(h.sum_ns) / 1e9);
+    append(out, "%s_count%s %llu\n", name, plain.c_str(), static_cast<unsigned long long>(h.count));
+}
+
+std::string metrics_render()
+{
+    std::unique_ptr<Totals> totals(new Totals());
+    {
+        BlockList &list = block_list();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        for (const auto &block : list.blocks)
+        {
+            for (size_t i = 0; i < histogram_count; ++i)
+                totals->histograms[i].add(block->histograms[i]);
+            for (size_t r = 0; r < route_count; ++r)
+            {
+                totals->http_latency[r].add(block->http_latency[r]);
+                for (size_t c = 0; c < status_class_count; ++c)
+                    totals->http_status[r][c] += block->http_status[r][c].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < counter_count; ++i)
+                totals->counters[i] += block->counters[i].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < order_status_count; ++i)
+                totals->orders[i] += block->orders[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::string out;
+    out.reserve(16 * 1024);
+
+    header(out, "ecb_http_requests_total", "counter", "HTTP requests by route and status class.");
+    for (size_t r = 0; r < route_count; ++r)
+        for (size_t c = 0; c < status_class_count; ++c)
+            if (totals->http_status[r][c] > 0)
+                append(out, "ecb_http_requests_total{route=\"%s\",code=\"%uxx\"} %llu\n",
+                       http_route_label(static_cast<HttpRoute>(r)), static_cast<unsigned>(c + 1),
+                       static_cast<unsigned long long>(totals->http_status[r][c]));
+
+    header(out, "ecb_http_request_duration_seconds", "histogram", "Time from routing a request to its response being ready.");
+    for (size_t r = 0; r < route_count; ++r)
+        histogram_series(out, "ecb_http_request_duration_seconds",
+                         std::string("route=\"") + http_route_label(static_cast<HttpRoute>(r)) + "\",",
+                         totals->http_latency[r]);
+
+    header(out, "ecb_orders_total", "counter", "Orders by result.");
+    for (size_t i = 0; i < order_status_count; ++i)
+        append(out, "ecb_orders_total{result=\"%s\"} %llu\n", order_result_label(static_cast<OrderStatus>(i)),
+               static_cast<unsigned long long>(totals->orders[i]));
+
+    header(out, "ecb_contract_lock_wait_seconds", "histogram", "Time spent waiting to acquire a market's contract_mutex.");
+    histogram_series(out, "ecb_contract_lock_wait_seconds", "",
+                     totals->histograms[static_cast<size_t>(MetricHistogram::CONTRACT_LOCK_WAIT)]);
+    header(out, "ecb_contract_lock_hold_seconds", "histogram", "Time a market's contract_mutex was held per order or batch.");
+    histogram_series(out, "ecb_contract_lock_hold_seconds", "",
+                     totals->histograms[static_cast<size_t>(MetricHistogram::CONTRACT_LOCK_HOLD)]);
+
+    header(out, "ecb_sqlite_commit_seconds", "histogram", "Duration of order-book COMMITs.");
+    histogram_series(out, "ecb_sqlite_commit_seconds", "",
+                     totals->histograms[static_cast<size_t>(MetricHistogram::SQLITE_COMMIT)]);
+    header(out, "ecb_sqlite_commit_failures_total", "counter", "Order-book transactions that failed to commit.");
+    append(out, "ecb_sqlite_commit_failures_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::SQLITE_COMMIT_FAILURES)]));
+    header(out, "ecb_log_records_dropped_total", "counter", "Log records dropped because the logging thread's queue was full.");
+    append(out, "ecb_log_records_dropped_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::LOG_RECORDS_DROPPED)]));
+    header(out, "ecb_stream_events_total", "counter", "Quote events queued to GET /stream/quotes clients.");
+    append(out, "ecb_stream_events_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::STREAM_EVENTS)]));
+    header(out, "ecb_stream_subscribers_lagged_total", "counter",
+           "Streaming clients disconnected because their event buffer was full.");
+    append(out, "ecb_stream_subscribers_lagged_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::STREAM_SUBSCRIBERS_LAGGED)]));
+    header(out, "ecb_wire_protocol_errors_total", "counter",
+           "Binary order-entry connections closed because of a malformed frame.");
+    append(out, "ecb_wire_protocol_errors_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::WIRE_PROTOCOL_ERRORS)]));
+    header(out, "ecb_sequencer_batches_total", "counter",
+           "Runs of orders a sequencer thread applied and persisted together (--execution=sequenced).");
+    append(out, "ecb_sequencer_batches_total %llu\n",
+           static_cast<unsigned long long>(totals->counters[static_cast<size_t>(MetricCounter::SEQUENCER_BATCHES)]));
+
+    auto gauge = [&out](const char *name, const char *help, MetricGauge g) {
+        header(out, name, "gauge", help);
+        append(out, "%s %lld\n", name, static_cast<long long>(gauges[static_cast<size_t>(g)].load(std::memory_order_relaxed)));
+    };
+    gauge("ecb_open_markets", "Markets currently accepting orders.", MetricGauge::OPEN_MARKETS);
+    gauge("ecb_http_queued_connections", "Accepted connections waiting for an HTTP worker.", MetricGauge::HTTP_QUEUED_CONNECTIONS);
+    gauge("ecb_http_busy_workers", "HTTP workers currently serving a connection.", MetricGauge::HTTP_BUSY_WORKERS);
+    gauge("ecb_http_workers", "Size of the HTTP worker pool.", MetricGauge::HTTP_WORKERS);
+    gauge("ecb_stream_subscribers", "Connected GET /stream/quotes clients.", MetricGauge::STREAM_SUBSCRIBERS);
+    gauge("ecb_wire_connections", "Open binary order-entry connections.", MetricGauge::WIRE_CONNECTIONS);
+
+    return out;
+}
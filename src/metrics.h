@@ -0,0 +1,93 @@
+#pragma once
+#include "orders.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+
+// Process-wide metrics in Prometheus text format (GET /metrics).
+//
+// Every thread that records a metric gets its own block of counters and
+// histogram buckets; only that thread writes to it (plain relaxed
+// load+store, no locked instructions, no shared cache lines), and a scrape
+// sums the blocks of all threads. Recording therefore adds no contention to
+// the order path. Blocks outlive their threads so totals never go backwards.
+
+enum class HttpRoute {
+    EVENTS,
+    QUOTE,
+    QUOTES,
+    ORDER,
+    ORDERS_BATCH,
+    METRICS,
+    EVENT_METRICS,
+    TRACE,
+    READY,
+    STREAM_QUOTES,
+    OTHER,  // unmatched paths (404), and anything refused while starting (503)
+    COUNT
+};
+
+enum class MetricHistogram {
+    CONTRACT_LOCK_WAIT,  // waiting to acquire contract_mutex
+    CONTRACT_LOCK_HOLD,  // holding contract_mutex
+    SQLITE_COMMIT,       // COMMIT of an order-book transaction
+    COUNT
+};
+
+enum class MetricCounter {
+    SQLITE_COMMIT_FAILURES,
+    LOG_RECORDS_DROPPED,  // log ring full
+    STREAM_EVENTS,             // quote events queued to streaming clients
+    STREAM_SUBSCRIBERS_LAGGED, // streaming clients dropped for a full buffer
+    WIRE_PROTOCOL_ERRORS,      // binary connections closed on a malformed frame
+    SEQUENCER_BATCHES,         // runs of orders applied together by a sequencer thread
+    COUNT
+};
+
+// Set at scrape time or by their owner; plain shared atomics.
+enum class MetricGauge {
+    OPEN_MARKETS,
+    HTTP_QUEUED_CONNECTIONS,  // accepted connections waiting for a worker
+    HTTP_BUSY_WORKERS,
+    HTTP_WORKERS,
+    STREAM_SUBSCRIBERS,
+    WIRE_CONNECTIONS,
+    COUNT
+};
+
+const char *http_route_label(HttpRoute route);
+
+void metrics_observe(MetricHistogram histogram, std::chrono::nanoseconds elapsed);
+void metrics_count(MetricCounter counter, uint64_t n = 1);
+void metrics_count_request(HttpRoute route, int status, std::chrono::nanoseconds elapsed);
+void metrics_count_order(OrderStatus status);
+
+void metrics_gauge_set(MetricGauge gauge, int64_t value);
+void metrics_gauge_add(MetricGauge gauge, int64_t delta);
+
+// all metrics in the Prometheus text exposition format (version 0.0.4)
+std::string metrics_render();
+
+
+// std::unique_lock stand-in that records how long the caller waited for the
+// mutex and, on release, how long it held it.
+class TimedLock
+{
+    private:
+        std::mutex *mutex;
+        std::chrono::steady_clock::time_point acquired;
+
+    public:
+        explicit TimedLock(std::mutex &m);
+        ~TimedLock() { unlock(); }
+        TimedLock(TimedLock &&other) noexcept : mutex(other.mutex), acquired(other.acquired) { other.mutex = nullptr; }
+        TimedLock(const TimedLock &) = delete;
+        TimedLock &operator=(const TimedLock &) = delete;
+        TimedLock &operator=(TimedLock &&) = delete;
+
+        void unlock();
+};
@@ -0,0 +1,238 @@
+#include "migrations.h"
+#include "logger.h"
+#include "trace.h"
+#include "utils.h"
+#include <string>
+
+
+// Databases created before migrations existed are at version 0 but already
+// have some of these tables, hence IF NOT EXISTS in the early steps.
+static const Migration migrations[] = {
+    {1, "events and order book", R"(
+        CREATE TABLE IF NOT EXISTS events (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            tag TEXT NOT NULL UNIQUE,
+            name TEXT NOT NULL,
+            risk_cap REAL,
+            outcome BOOLEAN DEFAULT NULL,
+            resolved BOOLEAN DEFAULT 0,
+            q_yes REAL DEFAULT 0,
+            q_no REAL DEFAULT 0,
+            event_funds REAL DEFAULT 0,
+            win_payout REAL DEFAULT 0,
+            order_count INTEGER DEFAULT 0,
+            profit_loss REAL DEFAULT 0,
+            maturity DATETIME NOT NULL,
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            resolved_at DATETIME NULL
+        );
+        CREATE TABLE IF NOT EXISTS order_book (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            event_id INTEGER NOT NULL,
+            side INTEGER NOT NULL,
+            stake REAL NOT NULL,
+            expected_cashout REAL NOT NULL,
+            price REAL NOT NULL,
+            pay_out REAL DEFAULT NULL,
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            FOREIGN KEY(event_id) REFERENCES events(id)
+        );
+    )"},
+
+    // one row per event being (or having been) settled; `cursor` is the last
+    // order_book id paid out, so a settlement resumes where it stopped
+    {2, "settlement progress", R"(
+        CREATE TABLE IF NOT EXISTS settlements (
+            event_id INTEGER PRIMARY KEY,
+            outcome BOOLEAN NOT NULL,
+            cursor INTEGER NOT NULL DEFAULT 0,
+            settled_orders INTEGER NOT NULL DEFAULT 0,
+            total_payout REAL NOT NULL DEFAULT 0,
+            started_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            finished_at DATETIME NULL,
+            FOREIGN KEY(event_id) REFERENCES events(id)
+        );
+    )"},
+
+    // one event's orders in id order: list_event_orders, the metrics
+    // aggregate and settlement chunks (event_id = ? AND id > cursor) all
+    // become range scans instead of full scans of the order history
+    {3, "order_book index by event", R"(
+        CREATE INDEX IF NOT EXISTS order_book_event ON order_book (event_id, id);
+    )"},
+
+    // per-event order aggregates, updated by every fill (record_fills) so
+    // metrics read one row; backfilled once from the existing orders
+    {4, "event order aggregates", R"(
+        ALTER TABLE events ADD COLUMN yes_stake REAL NOT NULL DEFAULT 0;
+        ALTER TABLE events ADD COLUMN no_stake REAL NOT NULL DEFAULT 0;
+        ALTER TABLE events ADD COLUMN largest_stake REAL NOT NULL DEFAULT 0;
+        ALTER TABLE events ADD COLUMN yes_liability REAL NOT NULL DEFAULT 0;
+        ALTER TABLE events ADD COLUMN no_liability REAL NOT NULL DEFAULT 0;
+        UPDATE events SET
+            yes_stake = COALESCE((SELECT SUM(stake) FROM order_book WHERE event_id = events.id AND side != 0), 0),
+            no_stake = COALESCE((SELECT SUM(stake) FROM order_book WHERE event_id = events.id AND side = 0), 0),
+            largest_stake = COALESCE((SELECT MAX(stake) FROM order_book WHERE event_id = events.id), 0),
+            yes_liability = COALESCE((SELECT SUM(expected_cashout) FROM order_book WHERE event_id = events.id AND side != 0), 0),
+            no_liability = COALESCE((SELECT SUM(expected_cashout) FROM order_book WHERE event_id = events.id AND side = 0), 0);
+    )"},
+
+    // last binlog record copied into SQLite (--storage=binlog); written in
+    // the same transaction as the copied orders
+    {5, "binlog position", R"(
+        CREATE TABLE IF NOT EXISTS binlog_position (
+            id INTEGER PRIMARY KEY CHECK (id = 1),
+            seq INTEGER NOT NULL
+        );
+    )"},
+
+    // amounts (stakes, prices, cashouts, funds, payouts, caps, aggregates)
+    // become INTEGER micro-units (Money); REAL affinity would turn them back
+    // into floats, so the three tables are rebuilt. The children are copied
+    // against events_new first: with foreign keys on, events can only be
+    // dropped once nothing references it, and renaming events_new re-points
+    // their constraints. AUTOINCREMENT counters carry over.
+    {6, "money as integer micro-units", R"(
+        CREATE TABLE events_new (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            tag TEXT NOT NULL UNIQUE,
+            name TEXT NOT NULL,
+            risk_cap INTEGER,
+            outcome BOOLEAN DEFAULT NULL,
+            resolved BOOLEAN DEFAULT 0,
+            q_yes REAL DEFAULT 0,
+            q_no REAL DEFAULT 0,
+            event_funds INTEGER DEFAULT 0,
+            win_payout INTEGER DEFAULT 0,
+            order_count INTEGER DEFAULT 0,
+            profit_loss INTEGER DEFAULT 0,
+            maturity DATETIME NOT NULL,
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            resolved_at DATETIME NULL,
+            yes_stake INTEGER NOT NULL DEFAULT 0,
+            no_stake INTEGER NOT NULL DEFAULT 0,
+            largest_stake INTEGER NOT NULL DEFAULT 0,
+            yes_liability INTEGER NOT NULL DEFAULT 0,
+            no_liability INTEGER NOT NULL DEFAULT 0
+        );
+        INSERT INTO events_new
+        SELECT id, tag, name, CAST(ROUND(risk_cap * 1e6) AS INTEGER), outcome, resolved, q_yes, q_no,
+               CAST(ROUND(event_funds * 1e6) AS INTEGER), CAST(ROUND(win_payout * 1e6) AS INTEGER), order_count,
+               CAST(ROUND(profit_loss * 1e6) AS INTEGER), maturity, created_at, resolved_at,
+               CAST(ROUND(yes_stake * 1e6) AS INTEGER), CAST(ROUND(no_stake * 1e6) AS INTEGER),
+               CAST(ROUND(largest_stake * 1e6) AS INTEGER), CAST(ROUND(yes_liability * 1e6) AS INTEGER),
+               CAST(ROUND(no_liability * 1e6) AS INTEGER)
+        FROM events;
+
+        CREATE TABLE order_book_new (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            event_id INTEGER NOT NULL,
+            side INTEGER NOT NULL,
+            stake INTEGER NOT NULL,
+            expected_cashout INTEGER NOT NULL,
+            price INTEGER NOT NULL,
+            pay_out INTEGER DEFAULT NULL,
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            FOREIGN KEY(event_id) REFERENCES events_new(id)
+        );
+        INSERT INTO order_book_new
+        SELECT id, event_id, side, CAST(ROUND(stake * 1e6) AS INTEGER), CAST(ROUND(expected_cashout * 1e6) AS INTEGER),
+               CAST(ROUND(price * 1e6) AS INTEGER), CAST(ROUND(pay_out * 1e6) AS INTEGER), created_at
+        FROM order_book;
+
+        CREATE TABLE settlements_new (
+            event_id INTEGER PRIMARY KEY,
+            outcome BOOLEAN NOT NULL,
+            cursor INTEGER NOT NULL DEFAULT 0,
+            settled_orders INTEGER NOT NULL DEFAULT 0,
+            total_payout INTEGER NOT NULL DEFAULT 0,
+            started_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            finished_at DATETIME NULL,
+            FOREIGN KEY(event_id) REFERENCES events_new(id)
+        );
+        INSERT INTO settlements_new
+        SELECT event_id, outcome, cursor, settled_orders, CAST(ROUND(total_payout * 1e6) AS INTEGER), started_at, finished_at
+        FROM settlements;
+
+        DELETE FROM sqlite_sequence WHERE name IN ('events_new', 'order_book_new');
+        INSERT INTO sqlite_sequence (name, seq)
+        SELECT name || '_new', seq FROM sqlite_sequence WHERE name IN ('events', 'order_book');
+
+        DROP TABLE order_book;
+        DROP TABLE settlements;
+        DROP TABLE events;
+        ALTER TABLE events_new RENAME TO events;
+        ALTER TABLE order_book_new RENAME TO order_book;
+        ALTER TABLE settlements_new RENAME TO settlements;
+        CREATE INDEX order_book_event ON order_book (event_id, id);
+    )"},
+};
+
+int latest_schema_version()
+{
+    return migrations[sizeof(migrations) / sizeof(migrations[0]) - 1].version;
+}
+
+int schema_version(DbConnection *conn)
+{
+    sqlite3_stmt *stmt = conn->prepare("PRAGMA user_version;");
+    if (!stmt)
+        return -1;
+    StmtGuard guard(stmt);
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+}
+
+// runs one migration and records its version in the same transaction
+static bool apply(DbConnection *conn, const Migration &migration)
+{
+    // BEGIN IMMEDIATE: a second process starting at the same time waits
+    // here, then sees the new version and skips the step
+    if (!conn->exec("BEGIN IMMEDIATE;"))
+        return false;
+
+    int current = schema_version(conn);
+    if (current >= migration.version)
+        return conn->exec("COMMIT;");
+
+    std::string bump = "PRAGMA user_version = " + std::to_string(migration.version) + ";";
+    if (current == migration.version - 1 && conn->exec(migration.sql) && conn->exec(bump.c_str()) &&
+        conn->exec("COMMIT;"))
+    {
+        log_info("Applied schema migration", {{"version", migration.version}, {"description", migration.description}});
+        return true;
+    }
+
+    if (!conn->exec("ROLLBACK;"))
+        error_msg("Failed to rollback transaction.");
+    return false;
+}
+
+bool migrate_database(DbConnection *conn)
+{
+    TraceSpan span("migrate_database");
+    int current = schema_version(conn);
+    if (current < 0)
+    {
+        error_msg("Failed to read schema version: " + std::string(conn->errmsg()));
+        return false;
+    }
+    if (current > latest_schema_version())
+    {
+        error_msg("Database schema version " + std::to_string(current) + " is newer than this build supports (" +
+                  std::to_string(latest_schema_version()) + ").");
+        return false;
+    }
+
+    for (const Migration &migration : migrations)
+    {
+        if (migration.version <= current)
+            continue;
+        if (!apply(conn, migration))
+        {
+            error_msg("Schema migration " + std::to_string(migration.version) + " (" + migration.description +
+                      ") failed.");
+            return false;
+        }
+    }
+    return true;
+}
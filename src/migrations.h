@@ -0,0 +1,27 @@
+#pragma once
+#include "connection.h"
+
+
+// Versioned schema changes. The database stores the number of the last
+// migration applied in `PRAGMA user_version`; migrate_database() applies the
+// newer ones in order, each in its own transaction together with the version
+// bump, so a failure leaves the schema at the previous version.
+//
+// To change the schema, append a migration to the list in migrations.cpp;
+// never edit or reorder one that has shipped.
+struct Migration
+{
+    int version;             // 1, 2, 3 ... in list order
+    const char *description;
+    const char *sql;         // one or more statements
+};
+
+// the schema version this build expects
+int latest_schema_version();
+
+// the database's current version; -1 on error
+int schema_version(DbConnection *conn);
+
+// brings the database up to latest_schema_version(); false if a migration
+// failed or the database was written by a newer build
+bool migrate_database(DbConnection *conn);
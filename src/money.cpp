@@ -0,0 +1,63 @@
+#include "money.h"
+
+
+static constexpr int64_t powers_of_ten[] = {1, 10, 100, 1'000, 10'000, 100'000, 1'000'000};
+
+static int clamp_decimals(int decimals)
+{
+    return decimals < 0 ? 0 : decimals > 6 ? 6 : decimals;
+}
+
+// |amount| in units of 10^-decimals, rounded half away from zero
+static uint64_t scaled_magnitude(Money amount, int decimals)
+{
+    uint64_t magnitude = amount.micros() < 0 ? 0 - static_cast<uint64_t>(amount.micros()) : amount.micros();
+    uint64_t unit = powers_of_ten[6 - decimals];
+    return (magnitude + unit / 2) / unit;
+}
+
+double Money::rounded(int decimals) const
+{
+    decimals = clamp_decimals(decimals);
+    double value = static_cast<double>(scaled_magnitude(*this, decimals)) / powers_of_ten[decimals];
+    return units < 0 && value != 0.0 ? -value : value;
+}
+
+size_t format_money(Money amount, char *out, int decimals)
+{
+    decimals = clamp_decimals(decimals);
+    uint64_t value = scaled_magnitude(amount, decimals);
+    bool negative = amount.micros() < 0 && value != 0; // no "-0.00"
+
+    // digits backwards into a scratch buffer, the decimal point after
+    // `decimals` of them
+    char digits[money_chars];
+    size_t n = 0;
+    for (int i = 0; i < decimals; ++i, value /= 10)
+        digits[n++] = static_cast<char>('0' + value % 10);
+    if (decimals > 0)
+        digits[n++] = '.';
+    do
+    {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    size_t length = 0;
+    if (negative)
+        out[length++] = '-';
+    while (n)
+        out[length++] = digits[--n];
+    return length;
+}
+
+std::string to_string(Money amount, int decimals)
+{
+    char buffer[money_chars];
+    return std::string(buffer, format_money(amount, buffer, decimals));
+}
+
+std::ostream &operator<<(std::ostream &os, Money amount)
+{
+    return os << to_string(amount);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+
+// A currency amount in fixed point: a whole number of micro-units (1e-6).
+// Stakes, prices per share, cashouts, funds and payouts are all Money, so
+// sums and comparisons are exact and nothing needs rounding after the fact;
+// the database stores the micro-units as INTEGER columns.
+//
+// Doubles only come in at the edges (request bodies, the LMSR arithmetic)
+// through from_double(), and go out through rounded() or format_money().
+class Money
+{
+    private:
+        int64_t units = 0; // micro-units
+
+        constexpr explicit Money(int64_t units_) : units(units_) {}
+
+    public:
+        static constexpr int64_t scale = 1'000'000;
+
+        constexpr Money() = default;
+        static constexpr Money from_micros(int64_t micros) { return Money(micros); }
+
+        // nearest micro-unit; NaN is zero and out-of-range values saturate,
+        // so a bad input can only fail the checks it is compared against
+        static Money from_double(double value)
+        {
+            if (!(value == value))
+                return Money();
+            if (value >= 9.2e12)
+                return Money(INT64_MAX);
+            if (value <= -9.2e12)
+                return Money(-INT64_MAX);
+            return Money(std::llround(value * scale));
+        }
+
+        constexpr int64_t micros() const { return units; }
+        double to_double() const { return static_cast<double>(units) / scale; }
+
+        // to `decimals` (0-6) places, half away from zero: what JSON shows
+        double rounded(int decimals = 2) const;
+
+        Money &operator+=(Money other) { units += other.units; return *this; }
+        Money &operator-=(Money other) { units -= other.units; return *this; }
+        friend constexpr Money operator+(Money a, Money b) { return Money(a.units + b.units); }
+        friend constexpr Money operator-(Money a, Money b) { return Money(a.units - b.units); }
+        friend constexpr Money operator-(Money a) { return Money(-a.units); }
+
+        friend constexpr bool operator==(Money a, Money b) { return a.units == b.units; }
+        friend constexpr bool operator!=(Money a, Money b) { return a.units != b.units; }
+        friend constexpr bool operator<(Money a, Money b) { return a.units < b.units; }
+        friend constexpr bool operator<=(Money a, Money b) { return a.units <= b.units; }
+        friend constexpr bool operator>(Money a, Money b) { return a.units > b.units; }
+        friend constexpr bool operator>=(Money a, Money b) { return a.units >= b.units; }
+};
+
+// ---------------- formatting ----------------
+// "-1234.57": `decimals` (0-6) places, half away from zero, integer
+// arithmetic only. Writes at most money_chars bytes (no terminator) and
+// returns the length.
+constexpr size_t money_chars = 28;
+size_t format_money(Money amount, char *out, int decimals = 2);
+
+std::string to_string(Money amount, int decimals = 2);
+
+// two decimals whatever the stream's precision; honours setw
+std::ostream &operator<<(std::ostream &os, Money amount);
+
+// the same rounding for values that stay doubles (LMSR prices and sizes)
+inline double round_cents(double value) { return std::round(value * 100.0) / 100.0; }
@@ -1,4 +1,6 @@
 #pragma once
+#include "money.h"
+#include <cstdint>
 
 
 // Order Interface
@@ -11,11 +13,72 @@ enum class Side {
 struct Order
 {
     int event_id;
-    double stake;
-    double price;
-    double expected_cashout;
+    Money stake;
+    Money price;            // per share (a winning share pays 1)
+    Money expected_cashout; // stake / price: paid if the side wins
     Side side;
-    double payout;
+    Money payout;
+};
+
+// Outcome of an order request; anything but FILLED means no state changed.
+enum class OrderStatus {
+    FILLED,
+    MARKET_NOT_FOUND,
+    MARKET_CLOSED,
+    INVALID_ORDER,
+    RISK_CAP_REACHED,
+    EXCEEDS_MAX_STAKE,
+    PERSIST_FAILED
+};
+
+inline const char *order_status_message(OrderStatus status)
+{
+    switch (status)
+    {
+    case OrderStatus::FILLED:            return "Filled";
+    case OrderStatus::MARKET_NOT_FOUND:  return "Event not found";
+    case OrderStatus::MARKET_CLOSED:     return "Market is closed";
+    case OrderStatus::INVALID_ORDER:     return "Invalid order";
+    case OrderStatus::RISK_CAP_REACHED:  return "Market has reached risk capacity";
+    case OrderStatus::EXCEEDS_MAX_STAKE: return "Stake exceeds max allowed for this market";
+    case OrderStatus::PERSIST_FAILED:    return "Order could not be persisted";
+    }
+    return "Unknown";
+}
+
+// Running totals over an event's orders, kept with the market state and
+// updated by every fill, so metrics never re-aggregate the order book.
+struct OrderAggregates
+{
+    Money yes_stake;
+    Money no_stake;
+    Money largest_stake; // largest single order
+    Money yes_liability; // paid out if YES wins: sum of YES cashouts
+    Money no_liability;
+
+    void add(Side side, Money stake, Money expected_cashout)
+    {
+        (side == Side::YES ? yes_stake : no_stake) += stake;
+        (side == Side::YES ? yes_liability : no_liability) += expected_cashout;
+        if (stake > largest_stake)
+            largest_stake = stake;
+    }
+};
+
+// An executed order together with the market state it left behind;
+// persisted as one unit so the order book and q_yes/q_no never diverge.
+struct Fill
+{
+    int event_id;
+    Side side;
+    Money stake;
+    Money price;
+    Money expected_cashout;
+    double q_yes;
+    double q_no;
+    Money event_funds;
+    int64_t order_count; // the market's order count after this fill
+    OrderAggregates aggregates;
 };
 
 
@@ -0,0 +1,77 @@
+#include "quote_kernel.h"
+#include "simd.h"
+
+void QuoteBook::clear()
+{
+    ids.clear();
+    q_yes.clear();
+    q_no.clear();
+    b.clear();
+    risk_cap.clear();
+}
+
+void QuoteBook::reserve(size_t n)
+{
+    ids.reserve(n);
+    q_yes.reserve(n);
+    q_no.reserve(n);
+    b.reserve(n);
+    risk_cap.reserve(n);
+}
+
+void QuoteBook::push(int id, double q_yes_, double q_no_, double b_, double risk_cap_)
+{
+    ids.push_back(id);
+    q_yes.push_back(q_yes_);
+    q_no.push_back(q_no_);
+    b.push_back(b_);
+    risk_cap.push_back(risk_cap_);
+}
+
+
+// ---------------- bulk LMSR quote ----------------
+// Per market, with d = (q_yes - q_no)/b:
+//   P(yes) = 1/(1 + e^-d),  P(no) = 1/(1 + e^d)
+//   remaining risk = cap - (C(q) - C(0)),  C(q) = b*log(e^(q_yes/b) + e^(q_no/b))
+//   e^(remaining/b) = e^((cap + b*ln2 - q_yes)/b) * P(yes)
+//   size = b * P(yes) * (e^(remaining/b) - 1), or 0 once the risk is used up
+// The identity for e^(remaining/b) avoids the log, leaving three exps and no
+// branches per market.
+template <typename V>
+static inline void quote_lanes(const V &qy, const V &qn, const V &b, const V &cap, V &yes, V &no, V &size)
+{
+    const double ln2 = 0.69314718055994530942;
+
+    V inv_b = 1.0 / b;
+    V d = (qy - qn) * inv_b;
+    yes = 1.0 / (1.0 + poly_exp(-d));
+    no = 1.0 / (1.0 + poly_exp(d));
+
+    V growth = poly_exp((cap + b * ln2 - qy) * inv_b) * yes;
+    size = b * yes * vmax(growth - 1.0, 0.0);
+}
+
+void price_markets(const QuoteBook &book, QuoteColumns &out)
+{
+    const size_t n = book.size();
+
+    out.price_yes.resize(n);
+    out.price_no.resize(n);
+    out.size.resize(n);
+
+    size_t i = 0;
+#ifdef KERNEL_SIMD
+    for (; i + simd_lanes <= n; i += simd_lanes)
+    {
+        vf64 yes, no, size;
+        quote_lanes(vload(&book.q_yes[i]), vload(&book.q_no[i]), vload(&book.b[i]), vload(&book.risk_cap[i]),
+                    yes, no, size);
+        vstore(&out.price_yes[i], yes);
+        vstore(&out.price_no[i], no);
+        vstore(&out.size[i], size);
+    }
+#endif
+    for (; i < n; ++i)
+        quote_lanes(book.q_yes[i], book.q_no[i], book.b[i], book.risk_cap[i],
+                    out.price_yes[i], out.price_no[i], out.size[i]);
+}
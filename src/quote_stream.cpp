@@ -0,0 +1,220 @@
+#include "quote_stream.h"
+#include "metrics.h"
+#include "money.h"
+#include "trace.h"
+#include "json.hpp"
+#include <algorithm>
+
+
+static const char lagged_event[] = "event: lagged\ndata: {}\n\n";
+
+void append_quote_event(std::string &out, int id, const Quote &quote)
+{
+    out += "event: quote\ndata: ";
+    out += nlohmann::json{
+        {"id", id},
+        {"yes_price", round_cents(quote.price_yes)},
+        {"no_price", round_cents(quote.price_no)},
+        {"max_stake", static_cast<int>(quote.size)},
+        {"version", quote.version}
+    }.dump();
+    out += "\n\n";
+}
+
+
+// ---------------- subscriber ----------------
+QuoteSubscriber::QuoteSubscriber(std::vector<int> ids_, size_t limit_) : limit(limit_), ids(std::move(ids_))
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+bool QuoteSubscriber::wants(int id) const
+{
+    return ids.empty() || std::binary_search(ids.begin(), ids.end(), id);
+}
+
+bool QuoteSubscriber::push(const std::string &events)
+{
+    bool lagged = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return true; // already leaving; its handler unsubscribes it
+        if (pending.size() + events.size() > limit)
+        {
+            // what it missed is gone; the client resyncs on reconnect
+            pending = lagged_event;
+            closed = lagged = true;
+        }
+        else
+            pending += events;
+    }
+    ready_cv.notify_one();
+    return !lagged;
+}
+
+void QuoteSubscriber::close(const char *final_event)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed)
+            return;
+        if (final_event)
+            pending += final_event;
+        closed = true;
+    }
+    ready_cv.notify_one();
+}
+
+bool QuoteSubscriber::take(std::string &out, std::chrono::milliseconds timeout)
+{
+    out.clear();
+    std::unique_lock<std::mutex> lock(mutex);
+    ready_cv.wait_for(lock, timeout, [this] { return closed || !pending.empty(); });
+    out.swap(pending);
+    return !(closed && out.empty());
+}
+
+
+// ---------------- stream ----------------
+QuoteStream::~QuoteStream()
+{
+    stop();
+}
+
+void QuoteStream::start(const QuoteStreamConfig &config_)
+{
+    stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    config = config_;
+    running = true;
+    dispatcher = std::thread(&QuoteStream::dispatch_loop, this);
+}
+
+void QuoteStream::stop()
+{
+    std::vector<std::shared_ptr<QuoteSubscriber>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        closing.swap(subscribers);
+        subscriber_count.store(0, std::memory_order_relaxed);
+    }
+    stop_cv.notify_all();
+    if (dispatcher.joinable())
+        dispatcher.join();
+    for (auto &subscriber : closing)
+        subscriber->close(nullptr);
+    metrics_gauge_set(MetricGauge::STREAM_SUBSCRIBERS, 0);
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    for (LMSRContract *contract : pending)
+        contract->stream_queued.store(false, std::memory_order_release);
+    pending.clear();
+}
+
+std::shared_ptr<QuoteSubscriber> QuoteStream::subscribe(std::vector<int> ids)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running || subscribers.size() >= config.max_subscribers)
+        return nullptr;
+    subscribers.push_back(std::make_shared<QuoteSubscriber>(std::move(ids), config.buffer_bytes));
+    subscriber_count.store(subscribers.size(), std::memory_order_relaxed);
+    metrics_gauge_set(MetricGauge::STREAM_SUBSCRIBERS, static_cast<int64_t>(subscribers.size()));
+    return subscribers.back();
+}
+
+void QuoteStream::unsubscribe(const std::shared_ptr<QuoteSubscriber> &subscriber)
+{
+    subscriber->close(nullptr);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+    if (it == subscribers.end())
+        return;
+    subscribers.erase(it);
+    subscriber_count.store(subscribers.size(), std::memory_order_relaxed);
+    metrics_gauge_set(MetricGauge::STREAM_SUBSCRIBERS, static_cast<int64_t>(subscribers.size()));
+}
+
+void QuoteStream::dispatch_loop()
+{
+    std::vector<LMSRContract *> changed;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running)
+    {
+        if (stop_cv.wait_for(lock, config.interval, [this] { return !running; }))
+            break;
+        lock.unlock();
+        {
+            // hand the fill path an empty list with the old capacity
+            std::lock_guard<std::mutex> pending_lock(pending_mutex);
+            changed.swap(pending);
+        }
+        if (!changed.empty())
+            dispatch(changed);
+        changed.clear();
+        lock.lock();
+    }
+}
+
+void QuoteStream::dispatch(const std::vector<LMSRContract *> &changed)
+{
+    TraceSpan span("QuoteStream dispatch");
+
+    // each event is formatted once; `offsets` delimits them in `all`. The
+    // flag is cleared before the snapshot is read, so a fill landing after
+    // the read queues its market for the next window.
+    std::string all;
+    std::vector<size_t> offsets{0};
+    offsets.reserve(changed.size() + 1);
+    for (LMSRContract *contract : changed)
+    {
+        contract->stream_queued.store(false, std::memory_order_release);
+        append_quote_event(all, contract->contract_id, contract->generate_quote());
+        offsets.push_back(all.size());
+    }
+
+    std::vector<std::shared_ptr<QuoteSubscriber>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        targets = subscribers;
+    }
+
+    uint64_t sent = 0;
+    std::string some;
+    for (const auto &subscriber : targets)
+    {
+        const std::string *events = &all;
+        size_t count = changed.size();
+        if (!subscriber->ids.empty())
+        {
+            some.clear();
+            count = 0;
+            for (size_t i = 0; i < changed.size(); ++i)
+                if (subscriber->wants(changed[i]->contract_id))
+                {
+                    some.append(all, offsets[i], offsets[i + 1] - offsets[i]);
+                    ++count;
+                }
+            events = &some;
+        }
+        if (count == 0)
+            continue;
+        if (subscriber->push(*events))
+            sent += count;
+        else
+        {
+            metrics_count(MetricCounter::STREAM_SUBSCRIBERS_LAGGED);
+            unsubscribe(subscriber);
+        }
+    }
+    metrics_count(MetricCounter::STREAM_EVENTS, sent);
+}
+
+
+QuoteStream &quote_stream()
+{
+    static QuoteStream stream;
+    return stream;
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "contract.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct QuoteStreamConfig {
+    std::chrono::milliseconds interval{100}; // updates of one market within this window are merged
+    size_t buffer_bytes = 1 << 20;           // unsent events per subscriber before it is dropped
+    size_t max_subscribers = 64;             // each holds one HTTP worker
+};
+
+// One GET /stream/quotes client: the Server-Sent Events not yet written to
+// its connection. The buffer is bounded; a subscriber that falls further
+// behind is closed with a final `lagged` event rather than slowing anyone
+// else down, and is expected to reconnect.
+class QuoteSubscriber
+{
+    private:
+        friend class QuoteStream;
+
+        std::mutex mutex;
+        std::condition_variable ready_cv;
+        std::string pending;
+        size_t limit;
+        bool closed = false;
+        std::vector<int> ids; // sorted; empty: every market
+
+        // appends under the lock; false if the events did not fit and the
+        // subscriber was closed for lagging
+        bool push(const std::string &events);
+        void close(const char *final_event);
+
+    public:
+        QuoteSubscriber(std::vector<int> ids_, size_t limit_);
+
+        bool wants(int id) const;
+
+        // waits up to `timeout` and moves the pending events into `out`
+        // (empty on timeout); false once closed and drained
+        bool take(std::string &out, std::chrono::milliseconds timeout);
+};
+
+// Pushes quote updates to the streaming clients.
+//
+// While someone is subscribed, a fill queues its market for the next
+// dispatch unless it is queued already (one flag exchange per fill, one
+// short locked push per market per window). Every interval a dispatcher
+// thread reads each queued market's latest snapshot, formats it once and
+// appends it to the subscribers that want it, so a fast market costs one
+// event per window however many fills it takes, and a slow client only
+// ever fills its own buffer. Queued markets must outlive the dispatch
+// (MarketRegistry never frees removed contracts).
+class QuoteStream
+{
+    private:
+        QuoteStreamConfig config;
+        std::atomic<size_t> subscriber_count{0};
+
+        std::mutex pending_mutex;
+        std::vector<LMSRContract *> pending; // changed since the last dispatch
+
+        std::mutex mutex;
+        std::condition_variable stop_cv;
+        std::vector<std::shared_ptr<QuoteSubscriber>> subscribers;
+        std::thread dispatcher;
+        bool running = false;
+
+        void dispatch_loop();
+        void dispatch(const std::vector<LMSRContract *> &changed);
+
+    public:
+        ~QuoteStream();
+
+        void start(const QuoteStreamConfig &config_);
+        void stop(); // closes every subscriber
+
+        // fill path: `contract` published a new snapshot
+        void notify(LMSRContract &contract)
+        {
+            if (subscriber_count.load(std::memory_order_relaxed) == 0 ||
+                contract.stream_queued.exchange(true, std::memory_order_acq_rel))
+                return;
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending.push_back(&contract);
+        }
+
+        // nullptr when not running or max_subscribers are connected;
+        // `ids` empty subscribes to every market
+        std::shared_ptr<QuoteSubscriber> subscribe(std::vector<int> ids);
+        void unsubscribe(const std::shared_ptr<QuoteSubscriber> &subscriber);
+
+        size_t size() const { return subscriber_count.load(std::memory_order_relaxed); }
+};
+
+QuoteStream &quote_stream();
+
+// appends one market's quote as an SSE `quote` event; the data is the
+// GET /quote/<id> object plus "id" and "version"
+void append_quote_event(std::string &out, int id, const Quote &quote);
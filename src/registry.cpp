@@ -0,0 +1,88 @@
+#include "registry.h"
+#include "utils.h"
+
+
+MarketRegistry::MarketRegistry()
+{
+    for (auto &chunk : chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+MarketRegistry::~MarketRegistry()
+{
+    for (auto &chunk_ptr : chunks)
+    {
+        Chunk *chunk = chunk_ptr.load(std::memory_order_relaxed);
+        if (!chunk)
+            continue;
+        for (auto &slot : *chunk)
+            delete slot.load(std::memory_order_relaxed);
+        delete chunk;
+    }
+}
+
+LMSRContract *MarketRegistry::find(int id) const
+{
+    if (id < 0)
+        return nullptr;
+    size_t index = static_cast<size_t>(id);
+    size_t c = index >> chunk_bits;
+    if (c >= max_chunks)
+        return nullptr;
+
+    const Chunk *chunk = chunks[c].load(std::memory_order_acquire);
+    if (!chunk)
+        return nullptr;
+    return (*chunk)[index & (chunk_size - 1)].load(std::memory_order_acquire);
+}
+
+bool MarketRegistry::insert(std::unique_ptr<LMSRContract> contract)
+{
+    int id = contract->contract_id;
+    size_t index = static_cast<size_t>(id);
+    size_t c = index >> chunk_bits;
+    if (id < 0 || c >= max_chunks)
+    {
+        error_msg("Market id out of registry range (id=" + std::to_string(id) + ").");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(write_mutex);
+
+    Chunk *chunk = chunks[c].load(std::memory_order_relaxed);
+    if (!chunk)
+    {
+        chunk = new Chunk();
+        for (auto &slot : *chunk)
+            slot.store(nullptr, std::memory_order_relaxed);
+        chunks[c].store(chunk, std::memory_order_release);
+        if (c + 1 > chunk_limit.load(std::memory_order_relaxed))
+            chunk_limit.store(c + 1, std::memory_order_release);
+    }
+
+    auto &slot = (*chunk)[index & (chunk_size - 1)];
+    if (slot.load(std::memory_order_relaxed))
+        return false;
+
+    slot.store(contract.release(), std::memory_order_release);
+    count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool MarketRegistry::remove(int id)
+{
+    std::lock_guard<std::mutex> lock(write_mutex);
+
+    LMSRContract *contract = find(id);
+    if (!contract)
+        return false;
+
+    size_t index = static_cast<size_t>(id);
+    Chunk *chunk = chunks[index >> chunk_bits].load(std::memory_order_relaxed);
+    (*chunk)[index & (chunk_size - 1)].store(nullptr, std::memory_order_release);
+    count.fetch_sub(1, std::memory_order_relaxed);
+
+    // readers may still hold the pointer; keep the object alive
+    retired.emplace_back(contract);
+    return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "contract.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+// Concurrent event id -> LMSRContract map shared by the HTTP workers and
+// the console. Event ids are small dense integers (SQLite AUTOINCREMENT), so
+// markets live in a two-level radix table of atomic pointers: a lookup is two
+// acquire loads and never waits. Inserts and removals are serialised by a
+// mutex. Removed contracts are retired rather than freed until the registry
+// is destroyed, so a pointer loaded just before a removal stays valid.
+class MarketRegistry
+{
+    public:
+        static constexpr int chunk_bits = 12;
+        static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+        static constexpr size_t max_chunks = 4096; // ids below 2^24
+
+    private:
+        using Chunk = std::array<std::atomic<LMSRContract *>, chunk_size>;
+
+        std::array<std::atomic<Chunk *>, max_chunks> chunks;
+        std::atomic<size_t> chunk_limit{0}; // one past the highest allocated chunk
+        std::atomic<size_t> count{0};
+
+        std::mutex write_mutex;
+        std::vector<std::unique_ptr<LMSRContract>> retired;
+
+    public:
+        MarketRegistry();
+        ~MarketRegistry();
+        MarketRegistry(const MarketRegistry &) = delete;
+        MarketRegistry &operator=(const MarketRegistry &) = delete;
+
+        // wait-free; nullptr if no open market has this id
+        LMSRContract *find(int id) const;
+
+        // false if the id is out of range or already registered
+        bool insert(std::unique_ptr<LMSRContract> contract);
+
+        // unlists the market; the object itself lives on until destruction
+        bool remove(int id);
+
+        size_t size() const { return count.load(std::memory_order_relaxed); }
+
+        // visits every open market in id order (a concurrent insert/remove
+        // may or may not be observed)
+        template <typename F>
+        void for_each(F &&visit) const
+        {
+            size_t limit = chunk_limit.load(std::memory_order_acquire);
+            for (size_t c = 0; c < limit; ++c)
+            {
+                const Chunk *chunk = chunks[c].load(std::memory_order_acquire);
+                if (!chunk)
+                    continue;
+                for (const auto &slot : *chunk)
+                {
+                    LMSRContract *contract = slot.load(std::memory_order_acquire);
+                    if (contract)
+                        visit(*contract);
+                }
+            }
+        }
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+// Sequence lock for a small trivially copyable value: one writer at a time
+// (serialised by the caller), any number of readers that never block.
+// A reader copies the value and retries if a write overlapped the copy.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable type");
+    static constexpr size_t words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    private:
+        std::atomic<uint64_t> sequence{0}; // odd while a write is in progress
+        std::atomic<uint64_t> data[words];
+
+    public:
+        SeqLock()
+        {
+            for (auto &word : data)
+                word.store(0, std::memory_order_relaxed);
+        }
+
+        explicit SeqLock(const T &value) : SeqLock() { store(value); }
+
+        SeqLock(const SeqLock &) = delete;
+        SeqLock &operator=(const SeqLock &) = delete;
+
+        void store(const T &value)
+        {
+            uint64_t buf[words] = {};
+            std::memcpy(buf, &value, sizeof(T));
+
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < words; ++i)
+                data[i].store(buf[i], std::memory_order_relaxed);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        T load() const
+        {
+            uint64_t buf[words];
+            uint64_t before, after;
+            do
+            {
+                before = sequence.load(std::memory_order_acquire);
+                for (size_t i = 0; i < words; ++i)
+                    buf[i] = data[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) != 0 || before != after);
+
+            T value;
+            std::memcpy(&value, buf, sizeof(T));
+            return value;
+        }
+};
@@ -0,0 +1,213 @@
+#include "sequencer.h"
+#include "metrics.h"
+#include "trace.h"
+#include <algorithm>
+#include <chrono>
+
+
+// ---------------- MPSC queue ----------------
+void OrderSequencer::Shard::push(Request *request)
+{
+    request->next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = head.exchange(request, std::memory_order_acq_rel);
+    previous->next.store(request, std::memory_order_release);
+}
+
+// nullptr when empty, or while the newest push is half done (its producer
+// has swapped `head` but not linked it yet; the next pop sees it)
+OrderSequencer::Request *OrderSequencer::Shard::pop()
+{
+    Node *first = tail;
+    Node *next = first->next.load(std::memory_order_acquire);
+    if (first == &stub)
+    {
+        if (!next)
+            return nullptr;
+        tail = first = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        tail = next;
+        return static_cast<Request *>(first);
+    }
+
+    // `first` is the last node: park the stub behind it so it can be taken
+    if (first != head.load(std::memory_order_acquire))
+        return nullptr;
+    stub.next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = head.exchange(&stub, std::memory_order_acq_rel);
+    previous->next.store(&stub, std::memory_order_release);
+    next = first->next.load(std::memory_order_acquire);
+    if (!next)
+        return nullptr;
+    tail = next;
+    return static_cast<Request *>(first);
+}
+
+
+// ---------------- lifecycle ----------------
+OrderSequencer::~OrderSequencer()
+{
+    stop();
+}
+
+void OrderSequencer::start(const SequencerConfig &config_)
+{
+    stop();
+    config = config_;
+    if (config.mode != ExecutionMode::SEQUENCED)
+        return;
+
+    size_t threads = config.threads;
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    config.max_batch = std::max<size_t>(config.max_batch, 1);
+
+    shards.clear();
+    for (size_t i = 0; i < threads; ++i)
+        shards.push_back(std::make_unique<Shard>());
+    running = true;
+    for (auto &shard : shards)
+        shard->thread = std::thread(&OrderSequencer::run, this, std::ref(*shard));
+}
+
+// Shards stay allocated until the next start(): a buy() that lost the race
+// with stop() still touches its shard's counters on the way out.
+void OrderSequencer::stop()
+{
+    running = false;
+    for (auto &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->wakeup.notify_one();
+    }
+    for (auto &shard : shards)
+        if (shard->thread.joinable())
+            shard->thread.join();
+}
+
+
+// ---------------- order path ----------------
+bool OrderSequencer::buy(LMSRContract &contract, Side side, Money stake, Order &order, OrderStatus &status)
+{
+    if (!running.load(std::memory_order_relaxed))
+        return false;
+    Shard &shard = *shards[static_cast<size_t>(contract.contract_id) % shards.size()];
+
+    // counted before checking `running` again, so a shard thread never
+    // exits with this order still to come
+    shard.in_flight.fetch_add(1);
+    if (!running.load())
+    {
+        shard.in_flight.fetch_sub(1);
+        return false;
+    }
+
+    Request request;
+    request.contract = &contract;
+    request.side = side;
+    request.stake = stake;
+    std::future<void> done = request.done.get_future();
+    shard.push(&request);
+    // pairs with the fence in run(): either the shard thread's pop sees this
+    // push, or this load sees it idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (shard.idle.load(std::memory_order_relaxed) && shard.idle.exchange(false))
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.wakeup.notify_one();
+    }
+
+    {
+        TraceSpan wait("sequencer wait");
+        done.get();
+    }
+    if (request.durable.valid())
+    {
+        TraceSpan wait("journal wait");
+        if (!request.durable.get())
+        {
+            // every waiter of the run may do this; the rollback is idempotent
+            LMSRContract::undo_batch(*request.undo);
+            request.result = LMSRContract::BatchResult{OrderStatus::PERSIST_FAILED, Order{}};
+        }
+    }
+    status = request.result.status;
+    order = request.result.order;
+    return true;
+}
+
+void OrderSequencer::run(Shard &shard)
+{
+    std::vector<Request *> batch;
+    batch.reserve(config.max_batch);
+    while (true)
+    {
+        while (batch.size() < config.max_batch)
+        {
+            Request *request = shard.pop();
+            if (!request)
+                break;
+            batch.push_back(request);
+        }
+        if (!batch.empty())
+        {
+            apply(batch);
+            shard.in_flight.fetch_sub(batch.size());
+            for (Request *request : batch)
+                request->done.set_value(); // the request is gone after this
+            batch.clear();
+            continue;
+        }
+
+        if (!running.load() && shard.in_flight.load() == 0)
+            return;
+
+        // sleep until a producer finds `idle` set; the pop after setting it
+        // catches a push that raced with the loop above
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        shard.idle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Request *request = shard.pop())
+        {
+            shard.idle.store(false);
+            batch.push_back(request);
+            continue;
+        }
+        shard.wakeup.wait_for(lock, std::chrono::milliseconds(100), [&shard, this]() {
+            return !shard.idle.load() || !running.load();
+        });
+        shard.idle.store(false);
+    }
+}
+
+// one run of consecutive orders: executed in arrival order, persisted together
+void OrderSequencer::apply(std::vector<Request *> &batch)
+{
+    TraceSpan span("OrderSequencer::apply");
+    std::vector<LMSRContract::BatchLeg> legs;
+    legs.reserve(batch.size());
+    for (Request *request : batch)
+        legs.push_back(LMSRContract::BatchLeg{request->contract, request->side, request->stake});
+
+    std::future<bool> durable;
+    auto undo = std::make_shared<std::vector<LMSRContract::BatchUndo>>();
+    std::vector<LMSRContract::BatchResult> results = LMSRContract::execute_batch(legs, durable, *undo, true);
+    std::shared_future<bool> shared;
+    if (durable.valid())
+        shared = durable.share();
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        batch[i]->result = results[i];
+        batch[i]->durable = shared;
+        batch[i]->undo = undo;
+    }
+    metrics_count(MetricCounter::SEQUENCER_BATCHES);
+}
+
+OrderSequencer &order_sequencer()
+{
+    static OrderSequencer sequencer;
+    return sequencer;
+}
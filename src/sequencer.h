@@ -0,0 +1,99 @@
+#pragma once
+#include "contract.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// How single orders (LMSRContract::buy) reach a market.
+enum class ExecutionMode {
+    LOCKED,    // the calling thread takes the market's contract_mutex
+    SEQUENCED  // handed to the market's sequencer thread (OrderSequencer)
+};
+
+struct SequencerConfig {
+    ExecutionMode mode = ExecutionMode::LOCKED;
+    size_t threads = 0;     // shards (one thread each); 0 = one per hardware thread
+    size_t max_batch = 64;  // orders applied and persisted together at most
+};
+
+// Single-writer order execution.
+//
+// Markets are split into shards by contract_id, each owned by one thread.
+// buy() pushes the order onto its shard's queue (lock-free, many producers,
+// the shard thread the only consumer) and waits on a future. The thread
+// takes the orders in arrival order, up to max_batch at a time, applies them
+// with LMSRContract::execute_batch, so a run of consecutive fills costs one
+// SYNC commit or one journal submission, and completes each future. Callers
+// never queue on contract_mutex, and every market sees its orders in one
+// deterministic sequence.
+//
+// contract_mutex is still taken (by the shard thread alone, uncontended
+// unless a POST /orders/batch or a settlement touches the market), so the
+// paths that lock markets directly keep working alongside. Unlike a batch,
+// a run whose SYNC commit fails is retried one order per commit, so only
+// the orders that still fail are rejected.
+class OrderSequencer
+{
+    private:
+        struct Node
+        {
+            std::atomic<Node *> next{nullptr};
+        };
+
+        // lives on the stack of the thread waiting in buy()
+        struct Request : Node
+        {
+            LMSRContract *contract;
+            Side side;
+            Money stake;
+            std::promise<void> done;
+            LMSRContract::BatchResult result;
+            std::shared_future<bool> durable; // GROUP/ASYNC commit of the run
+            std::shared_ptr<const std::vector<LMSRContract::BatchUndo>> undo; // if that fails
+        };
+
+        struct Shard
+        {
+            // intrusive MPSC queue (Vyukov): producers swap `head`, the
+            // shard thread alone walks from `tail`
+            std::atomic<Node *> head;
+            Node *tail;
+            Node stub;
+
+            std::atomic<size_t> in_flight{0}; // pushed and not completed
+            std::atomic<bool> idle{false};
+            std::mutex mutex;
+            std::condition_variable wakeup;
+            std::thread thread;
+
+            Shard() : head(&stub), tail(&stub) {}
+            void push(Request *request);
+            Request *pop();
+        };
+
+        SequencerConfig config;
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<bool> running{false};
+
+        void run(Shard &shard);
+        void apply(std::vector<Request *> &run);
+
+    public:
+        ~OrderSequencer();
+
+        void start(const SequencerConfig &config_); // no-op in LOCKED mode
+        void stop();  // completes every order already queued
+
+        // executes through the market's shard and waits for the result
+        // (durable, under GROUP); false if not running, leaving the order
+        // to the caller. Counts no metrics.
+        bool buy(LMSRContract &contract, Side side, Money stake, Order &order, OrderStatus &status);
+};
+
+OrderSequencer &order_sequencer();
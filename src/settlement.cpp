@@ -0,0 +1,166 @@
+#include "settlement.h"
+#include "database.h"
+#include "logger.h"
+#include "trace.h"
+#include <algorithm>
+
+
+Settler::~Settler()
+{
+    stop();
+}
+
+void Settler::start(const SettlerConfig &config_)
+{
+    stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    config = config_;
+    running = true;
+    for (size_t i = 0; i < std::max<size_t>(config.workers, 1); ++i)
+        workers.emplace_back(&Settler::worker_loop, this);
+}
+
+void Settler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    work_cv.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+    workers.clear();
+    done_cv.notify_all();
+}
+
+bool Settler::submit(int event_id, bool outcome)
+{
+    return begin_settlement(event_id, outcome) && resume(event_id);
+}
+
+bool Settler::resume(int event_id)
+{
+    Settlement progress;
+    if (!load_settlement(event_id, progress))
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = jobs.find(event_id);
+        if (it != jobs.end() && (it->second.state == SettlementState::QUEUED || it->second.state == SettlementState::RUNNING))
+            return true; // already on its way
+        if (progress.finished)
+        {
+            jobs[event_id] = SettlementStatus{progress, SettlementState::DONE};
+            return true;
+        }
+        jobs[event_id] = SettlementStatus{progress, SettlementState::QUEUED};
+        queue.push_back(event_id);
+    }
+    work_cv.notify_one();
+    return true;
+}
+
+std::vector<SettlementStatus> Settler::status() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<SettlementStatus> out;
+    for (const auto &job : jobs)
+        out.push_back(job.second);
+    return out;
+}
+
+bool Settler::wait(int event_id)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [&]() {
+        auto it = jobs.find(event_id);
+        return it == jobs.end() || !running || it->second.state == SettlementState::DONE ||
+               it->second.state == SettlementState::FAILED;
+    });
+    auto it = jobs.find(event_id);
+    return it != jobs.end() && it->second.state == SettlementState::DONE;
+}
+
+void Settler::worker_loop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        work_cv.wait(lock, [this]() { return !running || !queue.empty(); });
+        if (!running)
+            return;
+        int event_id = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        run(event_id);
+        lock.lock();
+    }
+}
+
+void Settler::run(int event_id)
+{
+    TraceSpan span("Settler::run");
+    Settlement progress;
+    int chunk;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        SettlementStatus &job = jobs[event_id];
+        job.state = SettlementState::RUNNING;
+        progress = job.progress;
+        chunk = config.chunk_orders;
+    }
+
+    SettlementState result = SettlementState::FAILED;
+    while (true)
+    {
+        auto chunk_start = std::chrono::steady_clock::now();
+        int settled = settle_order_chunk(progress, chunk);
+        auto held = std::chrono::steady_clock::now() - chunk_start;
+
+        if (settled == 0)
+        {
+            if (finish_settlement(progress))
+            {
+                progress.finished = true;
+                result = SettlementState::DONE;
+                log_info("Event settled", {{"event_id", event_id},
+                                           {"outcome", progress.outcome ? "YES" : "NO"},
+                                           {"orders", progress.settled_orders},
+                                           {"payout", progress.total_payout}});
+            }
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        jobs[event_id].progress = progress;
+        if (settled < 0)
+            break;
+
+        // give writers on live markets a turn at the lock before the next chunk
+        auto pause = std::max<std::chrono::steady_clock::duration>(held, std::chrono::milliseconds(1));
+        if (work_cv.wait_for(lock, pause, [this]() { return !running; }))
+        {
+            // stopping: the database keeps the cursor for the next start
+            jobs[event_id].state = SettlementState::QUEUED;
+            return;
+        }
+    }
+
+    if (result == SettlementState::FAILED)
+        log_error("Settlement failed; run 'resolve' again to resume it.", {{"event_id", event_id}});
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs[event_id].progress = progress;
+        jobs[event_id].state = result;
+    }
+    done_cv.notify_all();
+}
+
+
+Settler &settler()
+{
+    static Settler instance;
+    return instance;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "event.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+struct SettlerConfig {
+    size_t workers = 2;      // events settled at the same time
+    int chunk_orders = 2000; // orders paid out per transaction
+};
+
+enum class SettlementState { QUEUED, RUNNING, DONE, FAILED };
+
+struct SettlementStatus {
+    Settlement progress;
+    SettlementState state;
+};
+
+// Background settlement of resolved events.
+//
+// Each job pays out its event's orders one chunk (one short transaction) at
+// a time and, after each chunk, sleeps about as long as the chunk held the
+// write lock, so fills on live markets keep getting the lock while a large
+// event settles. Several events settle concurrently, one per worker. A job
+// interrupted by stop() or a crash resumes from its stored cursor.
+class Settler {
+    private:
+        SettlerConfig config;
+        mutable std::mutex mutex;
+        std::condition_variable work_cv;
+        std::condition_variable done_cv;
+        std::deque<int> queue;
+        std::map<int, SettlementStatus> jobs; // by event id
+        std::vector<std::thread> workers;
+        bool running = false;
+
+        void worker_loop();
+        void run(int event_id);
+
+    public:
+        ~Settler();
+
+        void start(const SettlerConfig &config_);
+        void stop(); // unfinished jobs stay in the database for resume()
+
+        // records the outcome and queues the settlement; false (nothing
+        // queued) if the event cannot be settled with this outcome
+        bool submit(int event_id, bool outcome);
+
+        // queues a settlement that begin_settlement() already recorded
+        bool resume(int event_id);
+
+        std::vector<SettlementStatus> status() const;
+
+        // blocks until the event's job is done or failed; false if failed or unknown
+        bool wait(int event_id);
+};
+
+Settler &settler();
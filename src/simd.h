@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Lane types and branch-free math shared by the SIMD kernels (quote_kernel.cpp,
+// lmsr_engine.cpp). Everything here is inline and only meant for .cpp files.
+
+// ---------------- SIMD lane types ----------------
+// GCC/Clang vector extensions, as wide as the target's registers: four
+// doubles per op with AVX, two otherwise (SSE2, NEON). Wider vectors than the
+// registers get split and spilled. Other compilers run the same code one
+// element at a time through the scalar overloads.
+#if defined(__GNUC__)
+#define KERNEL_SIMD 1
+// only ever passed between inline functions of this header; the push/pop
+// keeps the including file's own -Wpsabi warnings
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#if defined(__AVX__)
+#define KERNEL_SIMD_BYTES 32
+#else
+#define KERNEL_SIMD_BYTES 16
+#endif
+typedef double vf64 __attribute__((vector_size(KERNEL_SIMD_BYTES)));
+typedef int64_t vi64 __attribute__((vector_size(KERNEL_SIMD_BYTES)));
+constexpr size_t simd_lanes = sizeof(vf64) / sizeof(double);
+
+static inline vf64 vload(const double *p) { vf64 v; std::memcpy(&v, p, sizeof(v)); return v; }
+static inline void vstore(double *p, const vf64 &v) { std::memcpy(p, &v, sizeof(v)); }
+static inline vf64 vsplat(double c) { return vf64{} + c; }
+// lane select as and/andnot/or; GCC lowers a vector `?:` one lane at a time
+static inline vf64 vselect(const vi64 &mask, const vf64 &a, const vf64 &b)
+{
+    return (vf64)(((vi64)a & mask) | ((vi64)b & ~mask));
+}
+static inline vf64 vmax(const vf64 &a, const vf64 &b) { return vselect(a > b, a, b); }
+static inline vf64 vmin(const vf64 &a, const vf64 &b) { return vselect(a < b, a, b); }
+static inline vf64 vmax(const vf64 &a, double c) { return vmax(a, vsplat(c)); }
+static inline vf64 vmin(const vf64 &a, double c) { return vmin(a, vsplat(c)); }
+static inline double vhmax(const vf64 &v)
+{
+    double m = v[0];
+    for (size_t i = 1; i < simd_lanes; ++i)
+        m = v[i] > m ? v[i] : m;
+    return m;
+}
+static inline double vhsum(const vf64 &v)
+{
+    double s = 0.0;
+    for (size_t i = 0; i < simd_lanes; ++i)
+        s += v[i];
+    return s;
+}
+static inline vf64 vexp2i(const vf64 &t)  // 2^n, n held in the low mantissa bits of t
+{
+    vi64 bits;
+    std::memcpy(&bits, &t, sizeof(bits));
+    vi64 scale_bits = (((bits & 0xFFFFFFFF) ^ 0x80000000) - 0x80000000 + 1023) << 52;
+    vf64 scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return scale;
+}
+#pragma GCC diagnostic pop
+#endif
+
+static inline double vmax(double a, double c) { return a > c ? a : c; }
+static inline double vmin(double a, double c) { return a < c ? a : c; }
+static inline double vexp2i(double t)  // scalar twin of the above
+{
+    int64_t bits;
+    std::memcpy(&bits, &t, sizeof(bits));
+    int64_t scale_bits = (((bits & 0xFFFFFFFF) ^ 0x80000000) - 0x80000000 + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return scale;
+}
+
+
+// ---------------- branch-free exp ----------------
+// exp(x) = 2^n * e^r with n = round(x/ln2), |r| <= ln2/2; e^r by a degree-12
+// Taylor polynomial (error < 2e-16). Only arithmetic, min/max and bit casts,
+// so the same code serves one value (double) or a SIMD lane group (vf64).
+template <typename V>
+static inline V poly_exp(const V &arg)
+{
+    const double log2e = 1.4426950408889634;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double round_magic = 6755399441055744.0; // 1.5 * 2^52
+
+    V x = vmin(vmax(arg, -708.0), 709.0);
+
+    V t = x * log2e + round_magic;
+    V n = t - round_magic;
+    V r = (x - n * ln2_hi) - n * ln2_lo;
+
+    V p = r * (1.0 / 479001600.0) + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    return p * vexp2i(t);
+}
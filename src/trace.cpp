@@ -0,0 +1,161 @@
+#include "trace.h"
+#include "seqlock.h"
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<bool> trace_detail::enabled{false};
+
+static std::atomic<uint32_t> sample_every{1};
+static std::atomic<int64_t> session_start_ns{0};
+
+static int64_t to_ns(Clock::time_point t)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+
+// ---------------- per-thread rings ----------------
+struct TraceEvent
+{
+    const char *name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+// written only by its owning thread; a dump reads each slot through its
+// seqlock and skips nothing but slots that are being overwritten
+struct TraceRing
+{
+    uint32_t tid = 0;
+    std::atomic<uint64_t> head{0}; // spans ever recorded
+    SeqLock<TraceEvent> slots[trace_ring_capacity];
+};
+
+struct RingList
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+static RingList &ring_list()
+{
+    static RingList list;
+    return list;
+}
+
+struct ThreadTrace
+{
+    TraceRing *ring = nullptr; // allocated on the first sampled span
+    uint32_t depth = 0;        // open spans that saw tracing on
+    uint32_t roots = 0;        // outermost spans seen, for sampling
+    bool sampled = false;      // decision of the current outermost span
+};
+
+static thread_local ThreadTrace local;
+
+static void record(const char *name, Clock::time_point start, Clock::time_point end)
+{
+    if (!local.ring)
+    {
+        auto owned = std::make_unique<TraceRing>();
+        local.ring = owned.get();
+        RingList &list = ring_list();
+        std::lock_guard<std::mutex> lock(list.mutex);
+        owned->tid = static_cast<uint32_t>(list.rings.size() + 1);
+        list.rings.push_back(std::move(owned));
+    }
+
+    TraceRing &ring = *local.ring;
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.slots[head % trace_ring_capacity].store(TraceEvent{name, to_ns(start), to_ns(end) - to_ns(start)});
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+
+// ---------------- spans ----------------
+void TraceSpan::begin()
+{
+    entered = true;
+    if (local.depth++ == 0)
+        local.sampled = local.roots++ % sample_every.load(std::memory_order_relaxed) == 0;
+    sampled = local.sampled;
+    if (sampled)
+        start = Clock::now();
+}
+
+void TraceSpan::end()
+{
+    if (sampled)
+        record(name, start, Clock::now());
+    --local.depth;
+}
+
+void trace_complete(const char *name, Clock::time_point start, Clock::time_point end)
+{
+    if (!trace_detail::enabled.load(std::memory_order_relaxed))
+        return;
+    if (local.depth > 0 && local.sampled)
+        record(name, start, end);
+}
+
+
+// ---------------- control ----------------
+void trace_start(uint32_t every)
+{
+    sample_every.store(every > 0 ? every : 1, std::memory_order_relaxed);
+    session_start_ns.store(to_ns(Clock::now()), std::memory_order_relaxed);
+    trace_detail::enabled.store(true, std::memory_order_release);
+}
+
+void trace_stop()
+{
+    trace_detail::enabled.store(false, std::memory_order_release);
+}
+
+bool trace_running()
+{
+    return trace_detail::enabled.load(std::memory_order_relaxed);
+}
+
+uint32_t trace_sample_every()
+{
+    return sample_every.load(std::memory_order_relaxed);
+}
+
+
+// ---------------- export ----------------
+// Chrome trace-event format: complete ("X") events, times in microseconds
+std::string trace_dump_json()
+{
+    const int64_t origin = session_start_ns.load(std::memory_order_relaxed);
+    std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+                      "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"event-contract-bot\"}}";
+
+    char line[256];
+    RingList &list = ring_list();
+    std::lock_guard<std::mutex> lock(list.mutex);
+    for (const auto &ring : list.rings)
+    {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > trace_ring_capacity ? head - trace_ring_capacity : 0;
+        for (uint64_t i = first; i < head; ++i)
+        {
+            TraceEvent ev = ring->slots[i % trace_ring_capacity].load();
+            if (!ev.name || ev.start_ns < origin)
+                continue;
+            std::snprintf(line, sizeof(line),
+                          ",\n{\"name\":\"%s\",\"cat\":\"ecb\",\"ph\":\"X\",\"pid\":1,\"tid\":%" PRIu32
+                          ",\"ts\":%.3f,\"dur\":%.3f}",
+                          ev.name, ring->tid, static_cast<double>(ev.start_ns - origin) / 1000.0,
+                          static_cast<double>(ev.duration_ns) / 1000.0);
+            out += line;
+        }
+    }
+    out += "\n]}\n";
+    return out;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+
+// Scoped trace spans exported as Chrome trace-event JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+// A span records its name, start and duration into a ring buffer owned by
+// the calling thread, so recording takes no lock and shares no cache line.
+// Tracing is off by default; a disabled span costs one relaxed atomic load.
+// When on, every Nth outermost span per thread is sampled and the spans
+// nested inside it follow its decision, so a sampled request is complete.
+// Each thread keeps its latest `trace_ring_capacity` spans.
+
+constexpr size_t trace_ring_capacity = 16384;
+
+namespace trace_detail
+{
+    extern std::atomic<bool> enabled;
+}
+
+// sample every `sample_every`-th outermost span per thread (1 = all of them);
+// spans recorded before this call are left out of later dumps
+void trace_start(uint32_t sample_every = 1);
+void trace_stop();
+bool trace_running();
+uint32_t trace_sample_every();
+
+// a span whose times the caller already measured (e.g. TimedLock); recorded
+// only while the current thread's outermost span is sampled
+void trace_complete(const char *name, std::chrono::steady_clock::time_point start,
+                    std::chrono::steady_clock::time_point end);
+
+// spans recorded since the last trace_start(), as Chrome trace-event JSON
+std::string trace_dump_json();
+
+
+// `name` must outlive the dump: pass a string literal.
+class TraceSpan
+{
+    private:
+        const char *name;
+        std::chrono::steady_clock::time_point start;
+        bool entered = false; // counted in this thread's nesting depth
+        bool sampled = false;
+
+        void begin();
+        void end();
+
+    public:
+        explicit TraceSpan(const char *name_) : name(name_)
+        {
+            if (trace_detail::enabled.load(std::memory_order_relaxed))
+                begin();
+        }
+        ~TraceSpan()
+        {
+            if (entered)
+                end();
+        }
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+};
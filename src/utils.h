@@ -60,12 +60,6 @@ inline bool is_valid_risk_cap(const std::string& s, int min_value) {
 
 
 
-inline double round_figure(double value, int decimals = 2) {
-    double factor = std::pow(10.0, decimals);
-    return std::round(value * factor) / factor;
-}
-
-
 inline void error_msg(const std::string& s) {
     std::cout << "\033[91m" + s + "\033[0m" << std::endl;
 }
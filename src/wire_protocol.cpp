@@ -0,0 +1,100 @@
+#include "wire_protocol.h"
+
+
+size_t wire_frame_size(WireType type)
+{
+    switch (type)
+    {
+    case WireType::ORDER:         return 32;
+    case WireType::QUOTE_REQUEST: return 16;
+    case WireType::ACK:           return 48;
+    case WireType::QUOTE:         return 48;
+    case WireType::REJECT:        return 24;
+    }
+    return 0;
+}
+
+WireReject wire_reject_of(OrderStatus status)
+{
+    switch (status)
+    {
+    case OrderStatus::MARKET_NOT_FOUND:  return WireReject::MARKET_NOT_FOUND;
+    case OrderStatus::MARKET_CLOSED:     return WireReject::MARKET_CLOSED;
+    case OrderStatus::RISK_CAP_REACHED:  return WireReject::RISK_CAP_REACHED;
+    case OrderStatus::EXCEEDS_MAX_STAKE: return WireReject::EXCEEDS_MAX_STAKE;
+    case OrderStatus::PERSIST_FAILED:    return WireReject::PERSIST_FAILED;
+    case OrderStatus::FILLED:
+    case OrderStatus::INVALID_ORDER:     break;
+    }
+    return WireReject::INVALID_ORDER;
+}
+
+const char *wire_reject_message(WireReject reason)
+{
+    switch (reason)
+    {
+    case WireReject::MARKET_NOT_FOUND:  return order_status_message(OrderStatus::MARKET_NOT_FOUND);
+    case WireReject::MARKET_CLOSED:     return order_status_message(OrderStatus::MARKET_CLOSED);
+    case WireReject::INVALID_ORDER:     return order_status_message(OrderStatus::INVALID_ORDER);
+    case WireReject::RISK_CAP_REACHED:  return order_status_message(OrderStatus::RISK_CAP_REACHED);
+    case WireReject::EXCEEDS_MAX_STAKE: return order_status_message(OrderStatus::EXCEEDS_MAX_STAKE);
+    case WireReject::PERSIST_FAILED:    return order_status_message(OrderStatus::PERSIST_FAILED);
+    case WireReject::BAD_SEQUENCE:      return "Out-of-sequence request";
+    }
+    return "Unknown";
+}
+
+
+// ---------------- encoding ----------------
+// header plus a zeroed body
+static size_t begin_frame(uint8_t *out, WireType type, uint64_t sequence, uint32_t event_id)
+{
+    size_t length = wire_frame_size(type);
+    std::memset(out, 0, length);
+    wire_store<uint16_t>(out, static_cast<uint16_t>(length));
+    out[2] = static_cast<uint8_t>(type);
+    out[3] = wire_version;
+    wire_store<uint32_t>(out + 4, event_id);
+    wire_store<uint64_t>(out + 8, sequence);
+    return length;
+}
+
+size_t wire_encode_order(uint8_t *out, uint64_t sequence, uint32_t event_id, Side side, Money stake)
+{
+    size_t length = begin_frame(out, WireType::ORDER, sequence, event_id);
+    out[16] = side == Side::YES ? 1 : 0;
+    wire_store<int64_t>(out + 24, stake.micros());
+    return length;
+}
+
+size_t wire_encode_quote_request(uint8_t *out, uint64_t sequence, uint32_t event_id)
+{
+    return begin_frame(out, WireType::QUOTE_REQUEST, sequence, event_id);
+}
+
+size_t wire_encode_ack(uint8_t *out, uint64_t sequence, const Order &order)
+{
+    size_t length = begin_frame(out, WireType::ACK, sequence, static_cast<uint32_t>(order.event_id));
+    out[16] = order.side == Side::YES ? 1 : 0;
+    wire_store<int64_t>(out + 24, order.stake.micros());
+    wire_store<int64_t>(out + 32, order.price.micros());
+    wire_store<int64_t>(out + 40, order.expected_cashout.micros());
+    return length;
+}
+
+size_t wire_encode_quote(uint8_t *out, uint64_t sequence, uint32_t event_id, const Quote &quote)
+{
+    size_t length = begin_frame(out, WireType::QUOTE, sequence, event_id);
+    wire_store_f64(out + 16, quote.price_yes);
+    wire_store_f64(out + 24, quote.price_no);
+    wire_store_f64(out + 32, quote.size);
+    wire_store<uint64_t>(out + 40, quote.version);
+    return length;
+}
+
+size_t wire_encode_reject(uint8_t *out, uint64_t sequence, uint32_t event_id, WireReject reason)
+{
+    size_t length = begin_frame(out, WireType::REJECT, sequence, event_id);
+    out[16] = static_cast<uint8_t>(reason);
+    return length;
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include "contract.h"
+#include "orders.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+// Binary order-entry protocol (--wire-port), for clients that cannot afford
+// HTTP and JSON on every order.
+//
+// A connection carries fixed-layout little-endian frames. Every frame starts
+// with the same 16-byte header:
+//
+//   0  u16 length    whole frame in bytes, header included
+//   2  u8  type      WireType
+//   3  u8  version   wire_version
+//   4  u32 event_id  market the frame is about
+//   8  u64 sequence  requests: 1, 2, 3, ... per connection; replies echo it
+//
+// followed by a body whose size is fixed by the type:
+//
+//   ORDER          16  u8 side (0 NO, 1 YES), 7 zero bytes, i64 stake in micro-units
+//   QUOTE_REQUEST   0
+//   ACK            32  u8 side, 7 zero bytes, i64 stake, i64 price per share,
+//                      i64 expected cashout (micro-units)
+//   QUOTE          32  f64 yes price, f64 no price, f64 max stake, u64 quote version
+//   REJECT          8  u8 WireReject, 7 zero bytes
+//
+// Each request gets exactly one reply, in order. A request whose sequence is
+// not the next one expected is rejected with BAD_SEQUENCE and not executed,
+// so a resent order never fills twice. A malformed header closes the
+// connection.
+
+constexpr uint8_t wire_version = 1;
+
+enum class WireType : uint8_t {
+    ORDER = 1,
+    QUOTE_REQUEST = 2,
+    ACK = 3,
+    QUOTE = 4,
+    REJECT = 5
+};
+
+enum class WireReject : uint8_t {
+    MARKET_NOT_FOUND = 1,
+    MARKET_CLOSED = 2,
+    INVALID_ORDER = 3,
+    RISK_CAP_REACHED = 4,
+    EXCEEDS_MAX_STAKE = 5,
+    PERSIST_FAILED = 6,
+    BAD_SEQUENCE = 7
+};
+
+constexpr size_t wire_header_size = 16;
+constexpr size_t wire_max_frame_size = 48;
+
+// frame size of `type`; 0 for an unknown type
+size_t wire_frame_size(WireType type);
+
+WireReject wire_reject_of(OrderStatus status); // status != FILLED
+const char *wire_reject_message(WireReject reason);
+
+
+// ---------------- little-endian fields ----------------
+template <typename T>
+inline T wire_load(const uint8_t *p)
+{
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if constexpr (sizeof(T) == 2)
+        value = static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    else if constexpr (sizeof(T) == 4)
+        value = static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    else if constexpr (sizeof(T) == 8)
+        value = static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+#endif
+    return value;
+}
+
+template <typename T>
+inline void wire_store(uint8_t *p, T value)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    if constexpr (sizeof(T) == 2)
+        value = static_cast<T>(__builtin_bswap16(static_cast<uint16_t>(value)));
+    else if constexpr (sizeof(T) == 4)
+        value = static_cast<T>(__builtin_bswap32(static_cast<uint32_t>(value)));
+    else if constexpr (sizeof(T) == 8)
+        value = static_cast<T>(__builtin_bswap64(static_cast<uint64_t>(value)));
+#endif
+    std::memcpy(p, &value, sizeof(T));
+}
+
+inline double wire_load_f64(const uint8_t *p)
+{
+    uint64_t bits = wire_load<uint64_t>(p);
+    double value;
+    std::memcpy(&value, &bits, sizeof value);
+    return value;
+}
+
+inline void wire_store_f64(uint8_t *p, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    wire_store<uint64_t>(p, bits);
+}
+
+
+// ---------------- decoding ----------------
+// A frame read in place from a receive buffer: nothing is parsed or copied
+// up front, each accessor loads its field. Body accessors are only
+// meaningful for the types noted.
+class WireFrame
+{
+    private:
+        const uint8_t *p;
+
+    public:
+        explicit WireFrame(const uint8_t *frame) : p(frame) {}
+
+        uint16_t length() const { return wire_load<uint16_t>(p); }
+        WireType type() const { return static_cast<WireType>(p[2]); }
+        uint8_t version() const { return p[3]; }
+        uint32_t event_id() const { return wire_load<uint32_t>(p + 4); }
+        uint64_t sequence() const { return wire_load<uint64_t>(p + 8); }
+
+        // the header of a frame this protocol defines (the body may not
+        // have arrived yet); anything else means the stream is unusable
+        bool valid_header() const { return version() == wire_version && length() == wire_frame_size(type()); }
+
+        // ORDER, ACK
+        uint8_t side_byte() const { return p[16]; }
+        Side side() const { return p[16] == 1 ? Side::YES : Side::NO; }
+        Money stake() const { return Money::from_micros(wire_load<int64_t>(p + 24)); }
+        // ACK
+        Money price() const { return Money::from_micros(wire_load<int64_t>(p + 32)); }
+        Money expected_cashout() const { return Money::from_micros(wire_load<int64_t>(p + 40)); }
+        // QUOTE
+        double price_yes() const { return wire_load_f64(p + 16); }
+        double price_no() const { return wire_load_f64(p + 24); }
+        double max_stake() const { return wire_load_f64(p + 32); }
+        uint64_t quote_version() const { return wire_load<uint64_t>(p + 40); }
+        // REJECT
+        WireReject reason() const { return static_cast<WireReject>(p[16]); }
+};
+
+
+// ---------------- encoding ----------------
+// Each writes one whole frame to `out` (at least wire_max_frame_size bytes)
+// and returns its length.
+size_t wire_encode_order(uint8_t *out, uint64_t sequence, uint32_t event_id, Side side, Money stake);
+size_t wire_encode_quote_request(uint8_t *out, uint64_t sequence, uint32_t event_id);
+size_t wire_encode_ack(uint8_t *out, uint64_t sequence, const Order &order);
+size_t wire_encode_quote(uint8_t *out, uint64_t sequence, uint32_t event_id, const Quote &quote);
+size_t wire_encode_reject(uint8_t *out, uint64_t sequence, uint32_t event_id, WireReject reason);